@@ -0,0 +1,93 @@
+// analysis.cpp
+
+#include <sstream>
+#include <iomanip>
+
+#include "analysis.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace ConsoleEngine;
+
+
+void BackgroundAnalysis::set_enabled(bool on)
+{
+	enabled = on;
+	if (!enabled) stop();
+}
+
+
+// Start analysing a position, unless it is already being analysed. Any analysis of another position is stopped first.
+// The keys of the game's earlier positions, oldest first, let the search see repetitions of them.
+void BackgroundAnalysis::start(const Chessboard& chessboard, const vector<Key>& game_keys)
+{
+	if (!enabled) return;
+	if (is_running() && position_key == chessboard.key && position_player == chessboard.active_player) return;
+	stop();
+
+	board = chessboard;
+	position_key = chessboard.key;
+	position_player = chessboard.active_player;
+	{
+		lock_guard<mutex> lock(info_mutex);
+		has_info = false;
+	}
+
+	searcher.clear_stop();
+	worker = thread([this, game_keys]()
+	{
+		searcher.search(&board, SearchLimits(), [this](const SearchInfo& iteration)
+		{
+			lock_guard<mutex> lock(info_mutex);
+			latest_info = iteration;
+			has_info = true;
+		}, game_keys);
+	});
+}
+
+
+void BackgroundAnalysis::stop()
+{
+	if (!worker.joinable()) return;
+	searcher.stop();
+	worker.join();
+}
+
+
+bool BackgroundAnalysis::latest(SearchInfo* info)
+{
+	lock_guard<mutex> lock(info_mutex);
+	if (has_info) *info = latest_info;
+	return has_info;
+}
+
+
+// Describe the latest iteration for the player: its depth, the score from white's point of view in pawns, and the moves it expects.
+string BackgroundAnalysis::describe()
+{
+	if (!enabled) return "Analysis is off. Type 'analyse' to turn it on.";
+
+	SearchInfo info;
+	if (!latest(&info)) return "Analysis has only just started.";
+
+	stringstream ss;
+	ss << "Depth " << info.depth << ", ";
+	bool white_to_move = position_player == Colour::WHITE;
+	if (is_mate_score(info.score))
+	{
+		int plies = MATE_SCORE - abs(info.score);
+		bool white_mates = (info.score > 0) == white_to_move;
+		ss << (white_mates ? "white" : "black") << " mates in " << (plies + 1) / 2;
+	}
+	else
+	{
+		int white_score = white_to_move ? info.score : -info.score;
+		ss << "eval " << showpos << fixed << setprecision(2) << white_score / 100.0 << noshowpos;
+	}
+	ss << ", best move " << info.best_move().to_long_algebraic() << " (";
+	for (size_t i = 0; i < info.pv.size(); i++) ss << ((i > 0) ? " " : "") << info.pv[i].to_long_algebraic();
+	ss << ")";
+
+	return ss.str();
+}
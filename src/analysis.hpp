@@ -0,0 +1,47 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logic.hpp"
+#include "search.hpp"
+#include "transposition.hpp"
+
+namespace ConsoleEngine
+{
+    // Searches the position on the board in the background while the console waits for the player to enter a move,
+    // so the time spent thinking at the keyboard isn't wasted. The latest completed iteration can be asked for at any time.
+    //
+    // The search runs on its own thread, on its own copy of the board, with no limits; stop() ends it within a node
+    // and waits for the thread. The transposition table is kept from one position to the next, so after a move is played
+    // the search of the new position starts from what was found looking ahead into it.
+    // Analysis is off until enabled, and start() does nothing while it is off.
+    class BackgroundAnalysis
+    {
+    public:
+        BackgroundAnalysis(size_t hash_mb = 16) : tt(hash_mb), searcher(&tt) {};
+        ~BackgroundAnalysis() { stop(); }
+        void set_enabled(bool on);
+        bool is_enabled() const { return enabled; }
+        void start(const LogicEngine::Chessboard& chessboard, const std::vector<LogicEngine::Key>& game_keys = {});
+        void stop();
+        bool is_running() const { return worker.joinable(); }
+        bool latest(SearchEngine::SearchInfo* info);    // false until the search of the position has completed an iteration
+        std::string describe();
+
+    private:
+        bool enabled = false;
+        SearchEngine::TranspositionTable tt;
+        SearchEngine::Searcher searcher;
+        LogicEngine::Chessboard board;                  // moved through by the worker as it searches
+        LogicEngine::Key position_key = 0;              // the position being analysed, as it stands
+        LogicEngine::Colour position_player = LogicEngine::Colour::WHITE;
+        std::thread worker;
+
+        std::mutex info_mutex;                          // guards the latest iteration, written by the worker
+        SearchEngine::SearchInfo latest_info;
+        bool has_info = false;
+    };
+}
@@ -0,0 +1,162 @@
+// bitboard.cpp
+
+#include "bitboard.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+
+Magic LogicEngine::ROOK_MAGICS[NUM_SQUARES];
+Magic LogicEngine::BISHOP_MAGICS[NUM_SQUARES];
+Bitboard LogicEngine::BETWEEN[NUM_SQUARES][NUM_SQUARES];
+Bitboard LogicEngine::LINE[NUM_SQUARES][NUM_SQUARES];
+
+// The attack tables the magics index into. A rook needs at most 4096 entries for its square, and a bishop 512.
+static Bitboard rook_table[0x19000];
+static Bitboard bishop_table[0x1480];
+
+const int ROOK_DIRECTIONS[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+const int BISHOP_DIRECTIONS[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+
+// For each direction, progress outwards from the square adding each square to the attacks.
+// Stop after the first occupied square, which can be captured (or defended) but not passed.
+Bitboard LogicEngine::sliding_attacks(int sq, Bitboard occupied, bool orthogonal)
+{
+	const int (*directions)[2] = orthogonal ? ROOK_DIRECTIONS : BISHOP_DIRECTIONS;
+	Bitboard attacks = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		int row = square_row(sq) + directions[i][0];
+		int col = square_col(sq) + directions[i][1];
+		while (row >= 0 && row < 8 && col >= 0 && col < 8)
+		{
+			attacks |= square_bb(square_index(row, col));
+			if (occupied & square_bb(square_index(row, col))) break;
+			row += directions[i][0];
+			col += directions[i][1];
+		}
+	}
+
+	return attacks;
+}
+
+
+// xorshift64* generator, seeded so that the same magics are found on every run.
+static uint64_t next_random(uint64_t* state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 2685821657736338717ULL;
+}
+
+
+// Fill in the magics and attack table for one kind of slider.
+// For each square, every subset of the blocking mask is enumerated along with the attacks it produces.
+// Then random sparse numbers are tried as magics until one maps every subset to a table slot without two
+// different attack sets landing in the same slot.
+static void init_magics(Magic magics[], Bitboard table[], bool orthogonal)
+{
+	static Bitboard occupancies[4096], references[4096];
+	static int epoch[4096], current_epoch = 0;
+	Bitboard* next_attacks = table;
+
+	// seeds for each rank that are known to find magics quickly
+	const uint64_t RANK_SEEDS[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+	const Bitboard RANKS_1_8 = 0xFF000000000000FFULL;
+	const Bitboard FILES_A_H = 0x8181818181818181ULL;
+
+	for (int sq = 0; sq < NUM_SQUARES; sq++)
+	{
+		Magic& m = magics[sq];
+
+		// a slider on the edge can still be blocked along that edge, so only leave out the edges it isn't standing on
+		Bitboard rank_mask = 0xFFULL << (8 * square_row(sq));
+		Bitboard file_mask = 0x0101010101010101ULL << square_col(sq);
+		Bitboard edges = (RANKS_1_8 & ~rank_mask) | (FILES_A_H & ~file_mask);
+
+		m.mask = sliding_attacks(sq, 0, orthogonal) & ~edges;
+		m.shift = 64 - pop_count(m.mask);
+		m.attacks = next_attacks;
+
+		// walk every subset of the mask with the carry-rippler trick
+		int size = 0;
+		Bitboard b = 0;
+		do
+		{
+			occupancies[size] = b;
+			references[size] = sliding_attacks(sq, b, orthogonal);
+			size++;
+			b = (b - m.mask) & m.mask;
+		} while (b);
+		next_attacks += size;
+
+#if defined(USE_PEXT)
+		// PEXT packs the occupied mask squares into a perfect index, so no magic search is needed
+		m.magic = 0;
+		for (int i = 0; i < size; i++)
+			m.attacks[m.index(occupancies[i])] = references[i];
+#else
+		uint64_t seed = RANK_SEEDS[square_row(sq)];
+		for (int i = 0; i < size; )
+		{
+			do
+				m.magic = next_random(&seed) & next_random(&seed) & next_random(&seed);
+			while (pop_count((m.mask * m.magic) >> 56) < 6);
+
+			// the epoch marks which slots were filled by this attempt, so the table needn't be cleared between tries
+			current_epoch++;
+			for (i = 0; i < size; i++)
+			{
+				unsigned int idx = m.index(occupancies[i]);
+				if (epoch[idx] < current_epoch)
+				{
+					epoch[idx] = current_epoch;
+					m.attacks[idx] = references[i];
+				}
+				else if (m.attacks[idx] != references[i])
+					break;
+			}
+		}
+#endif
+	}
+}
+
+
+// Fill in the lines between every pair of aligned squares, using the slider attacks.
+// Two squares share a line if a rook or bishop on one would attack the other on an empty board.
+static void init_lines()
+{
+	for (int a = 0; a < NUM_SQUARES; a++)
+	{
+		for (int b = 0; b < NUM_SQUARES; b++)
+		{
+			BETWEEN[a][b] = 0;
+			LINE[a][b] = 0;
+			if (a == b) continue;
+
+			for (bool orthogonal : { true, false })
+			{
+				Bitboard (*attacks)(int, Bitboard) = orthogonal ? rook_attacks : bishop_attacks;
+				if (!(attacks(a, 0) & square_bb(b))) continue;
+
+				LINE[a][b] = (attacks(a, 0) & attacks(b, 0)) | square_bb(a) | square_bb(b);
+				BETWEEN[a][b] = attacks(a, square_bb(b)) & attacks(b, square_bb(a));
+			}
+		}
+	}
+}
+
+
+// Build the slider and line tables during static initialisation, before main() or any test runs.
+static struct BitboardInitialiser
+{
+	BitboardInitialiser()
+	{
+		init_magics(ROOK_MAGICS, rook_table, true);
+		init_magics(BISHOP_MAGICS, bishop_table, false);
+		init_lines();
+	}
+} bitboard_initialiser;
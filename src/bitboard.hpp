@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+namespace LogicEngine
+{
+    // A bitboard is a set of squares packed into a 64-bit integer.
+    // Squares are indexed rank by rank from a1 (0) to h8 (63), so the index of a square is row * 8 + col.
+    typedef uint64_t Bitboard;
+
+    const int NUM_SQUARES = 64;
+
+    constexpr int square_index(int row, int col) { return (row * 8) + col; }
+    constexpr int square_row(int sq) { return sq >> 3; }
+    constexpr int square_col(int sq) { return sq & 7; }
+    constexpr Bitboard square_bb(int sq) { return 1ULL << sq; }
+
+    // Count the number of squares in a bitboard.
+    inline int pop_count(Bitboard b)
+    {
+#if defined(_MSC_VER)
+        return (int)__popcnt64(b);
+#else
+        return __builtin_popcountll(b);
+#endif
+    }
+
+    // Return the index of the lowest set square. The bitboard must not be empty.
+    inline int lsb(Bitboard b)
+    {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, b);
+        return (int)idx;
+#else
+        return __builtin_ctzll(b);
+#endif
+    }
+
+    // Remove the lowest set square from the bitboard and return its index.
+    inline int pop_lsb(Bitboard* b)
+    {
+        int sq = lsb(*b);
+        *b &= *b - 1;
+        return sq;
+    }
+
+    // Attack tables for the leaping pieces, generated at compile time.
+    // Each table holds, for every square, the bitboard of squares a piece standing there attacks on an empty board.
+    typedef std::array<Bitboard, NUM_SQUARES> AttackTable;
+
+    constexpr int KNIGHT_OFFSETS[8][2] = { {-2, -1}, {-2, 1}, {2, -1}, {2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2} };
+    constexpr int KING_OFFSETS[8][2] = { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} };
+    constexpr int WHITE_PAWN_OFFSETS[2][2] = { {1, -1}, {1, 1} };
+    constexpr int BLACK_PAWN_OFFSETS[2][2] = { {-1, -1}, {-1, 1} };
+
+    // Build a table from a list of {row, col} offsets, dropping any that leave the board.
+    template <size_t N>
+    constexpr AttackTable make_leaper_table(const int (&offsets)[N][2])
+    {
+        AttackTable table = {};
+        for (int sq = 0; sq < NUM_SQUARES; sq++)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                int row = square_row(sq) + offsets[i][0];
+                int col = square_col(sq) + offsets[i][1];
+                if (row >= 0 && row < 8 && col >= 0 && col < 8)
+                    table[sq] |= square_bb(square_index(row, col));
+            }
+        }
+        return table;
+    }
+
+    inline constexpr AttackTable KNIGHT_ATTACKS = make_leaper_table(KNIGHT_OFFSETS);
+    inline constexpr AttackTable KING_ATTACKS = make_leaper_table(KING_OFFSETS);
+
+    // Pawn attacks depend on the direction the pawn moves in, so are indexed by colour first (white, then black).
+    inline constexpr std::array<AttackTable, 2> PAWN_ATTACKS = { make_leaper_table(WHITE_PAWN_OFFSETS), make_leaper_table(BLACK_PAWN_OFFSETS) };
+
+    // Attacks for the sliding pieces depend on which squares are occupied, so are looked up from magic bitboard tables.
+    // The occupied squares that could block a slider are hashed into an index of a table of precomputed attack sets,
+    // either by a multiply with a magic number or, when built with USE_PEXT, by the BMI2 PEXT instruction.
+    // The tables are built once at startup, before main() runs.
+    struct Magic
+    {
+        Bitboard mask;      // squares whose occupancy can block the slider, leaving out the board edges
+        Bitboard magic;
+        Bitboard* attacks;  // this square's slice of the attack table
+        int shift;
+
+        unsigned int index(Bitboard occupied) const
+        {
+#if defined(USE_PEXT)
+            return (unsigned int)_pext_u64(occupied, mask);
+#else
+            return (unsigned int)(((occupied & mask) * magic) >> shift);
+#endif
+        }
+    };
+
+    extern Magic ROOK_MAGICS[NUM_SQUARES];
+    extern Magic BISHOP_MAGICS[NUM_SQUARES];
+
+    inline Bitboard rook_attacks(int sq, Bitboard occupied) { return ROOK_MAGICS[sq].attacks[ROOK_MAGICS[sq].index(occupied)]; }
+    inline Bitboard bishop_attacks(int sq, Bitboard occupied) { return BISHOP_MAGICS[sq].attacks[BISHOP_MAGICS[sq].index(occupied)]; }
+    inline Bitboard queen_attacks(int sq, Bitboard occupied) { return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied); }
+
+    // Walk the rays out from a square one step at a time. Slow, so only used to fill the magic tables.
+    Bitboard sliding_attacks(int sq, Bitboard occupied, bool orthogonal);
+
+    // For two squares on a shared rank, file or diagonal: BETWEEN holds the squares strictly between them,
+    // and LINE holds the whole line through both, edge to edge. Both are empty for squares that are not aligned.
+    extern Bitboard BETWEEN[NUM_SQUARES][NUM_SQUARES];
+    extern Bitboard LINE[NUM_SQUARES][NUM_SQUARES];
+}
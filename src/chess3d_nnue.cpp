@@ -0,0 +1,160 @@
+// chess3d_nnue.cpp
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+#include "logic.hpp"
+#include "movegen.hpp"
+#include "perft.hpp"
+#include "nnue.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+
+
+const double SECONDS_PER_MEASUREMENT = 0.5;
+
+
+// Positions to time: the perft positions, and the positions a fixed sequence of moves passes through from each.
+vector<Chessboard> benchmark_positions()
+{
+	vector<Chessboard> positions;
+	for (const PerftPosition& position : PERFT_POSITIONS)
+	{
+		Chessboard cb;
+		cb.load_fen(position.fen);
+		for (int ply = 0; ply < 30; ply++)
+		{
+			positions.push_back(cb);
+			MoveList moves = get_all_legal_moves(cb);
+			if (moves.empty()) break;
+			cb.do_move(moves[(ply * 7) % moves.size()]);
+		}
+	}
+	return positions;
+}
+
+
+// Run a round of evaluations over and over until enough time has passed, returning evaluations per second.
+// Each round returns how many evaluations it made, and adds their scores to the checksum.
+template <typename Round>
+double evals_per_second(Round round, int64_t* checksum)
+{
+	auto start = chrono::steady_clock::now();
+	uint64_t evals = 0;
+	double seconds = 0;
+	do
+	{
+		evals += round(checksum);
+		seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	} while (seconds < SECONDS_PER_MEASUREMENT);
+
+	return evals / seconds;
+}
+
+
+// Time the evaluation on each instruction set the CPU supports, three ways:
+//	full: both accumulators worked out from scratch for every evaluation
+//	incremental: making each legal move, evaluating with the accumulators updated by the move, and taking it back, as a search does
+//	layers: evaluating positions whose accumulators are already up to date, so timing only the layers after the first
+void run_benchmark()
+{
+	vector<Chessboard> positions = benchmark_positions();
+	vector<MoveList> moves;
+	for (const Chessboard& cb : positions) moves.push_back(get_all_legal_moves(cb));
+
+	cout << "Evaluations per second over " << positions.size() << " positions\n";
+	cout << setw(8) << "path" << setw(14) << "full" << setw(14) << "incremental" << setw(14) << "layers" << "\n";
+
+	SimdPath best = get_simd_path();
+	int64_t scalar_checksum = 0;
+	for (SimdPath path : { SimdPath::SCALAR, SimdPath::SSE41, SimdPath::AVX2 })
+	{
+		if (!set_simd_path(path))
+		{
+			cout << setw(8) << simd_path_name(path) << "   not supported by this CPU\n";
+			continue;
+		}
+
+		int64_t checksum = 0;
+		double full = evals_per_second([&](int64_t* sum)
+		{
+			for (Chessboard& cb : positions)
+			{
+				cb.accumulator = Accumulator();
+				*sum += nnue_evaluate(cb);
+			}
+			return positions.size();
+		}, &checksum);
+
+		double incremental = evals_per_second([&](int64_t* sum)
+		{
+			uint64_t evals = 0;
+			for (size_t i = 0; i < positions.size(); i++)
+			{
+				for (Move move : moves[i])
+				{
+					UndoInfo undo = positions[i].do_move(move);
+					*sum += nnue_evaluate(positions[i]);
+					positions[i].undo_move(undo);
+				}
+				evals += moves[i].size();
+			}
+			return evals;
+		}, &checksum);
+
+		double layers = evals_per_second([&](int64_t* sum)
+		{
+			for (const Chessboard& cb : positions) *sum += nnue_evaluate(cb);
+			return positions.size();
+		}, &checksum);
+
+		cout << setw(8) << simd_path_name(path) << setw(14) << (uint64_t)full << setw(14) << (uint64_t)incremental << setw(14) << (uint64_t)layers << "\n";
+
+		// every path should score each position the same, so the sums of the first round's scores should agree
+		int64_t first_round = 0;
+		for (Chessboard& cb : positions)
+		{
+			cb.accumulator = Accumulator();
+			first_round += nnue_evaluate(cb);
+		}
+		if (path == SimdPath::SCALAR)
+			scalar_checksum = first_round;
+		else if (first_round != scalar_checksum)
+			cout << "\tscores differ from the scalar path!\n";
+	}
+	set_simd_path(best);
+}
+
+
+// Usage:
+//	chess3d_nnue [<network file>]
+// Times the network evaluation with each instruction set the CPU supports. Without a network file, a network of random weights
+// is timed instead, which takes as long to evaluate as a trained one.
+int main(int argc, char* argv[])
+{
+	if (argc > 2)
+	{
+		cout << "Usage:\n\tchess3d_nnue [<network file>]\n";
+		return 1;
+	}
+
+	if (argc == 2)
+	{
+		if (!load_network(argv[1]))
+		{
+			cout << "Could not load network: " << argv[1] << "\n";
+			return 1;
+		}
+	}
+	else
+	{
+		cout << "No network given, so timing a random one\n";
+		set_network(random_network(1));
+	}
+
+	cout << "Using " << simd_path_name(get_simd_path()) << " by default\n";
+	run_benchmark();
+	return 0;
+}
@@ -0,0 +1,145 @@
+// chess3d_perft.cpp
+
+#include <iostream>
+#include <chrono>
+
+#include "logic.hpp"
+#include "perft.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+
+
+// Options given after the position and depth.
+struct PerftOptions
+{
+	bool divide = false;
+	int threads = 1;
+	size_t hash_mb = 0;     // 0 runs without a perft hash table
+};
+
+
+// Run perft on one position, printing the node count, time taken and nodes per second.
+// With divide, the count below each root move is printed first.
+uint64_t run_perft(Chessboard cb, int depth, const PerftOptions& options)
+{
+	auto start = chrono::steady_clock::now();
+	unique_ptr<PerftTable> table = (options.hash_mb > 0) ? make_unique<PerftTable>(options.hash_mb) : nullptr;
+
+	// the root moves are split between threads, which needs at least two plies
+	uint64_t nodes = 0;
+	if (options.divide || (options.threads > 1 && depth > 1))
+	{
+		vector<tuple<Move, uint64_t>> results = perft_divide(&cb, depth, options.threads, table.get());
+		for (int i = 0; i < results.size(); i++)
+		{
+			if (options.divide) cout << get<0>(results[i]).to_long_algebraic() << ": " << get<1>(results[i]) << "\n";
+			nodes += get<1>(results[i]);
+		}
+		if (options.divide) cout << "\n";
+	}
+	else
+		nodes = perft(&cb, depth, table.get());
+
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	uint64_t nps = (seconds > 0) ? (uint64_t)(nodes / seconds) : 0;
+	cout << "Depth " << depth << ": " << nodes << " nodes in " << seconds << "s (" << nps << " nps)\n";
+
+	return nodes;
+}
+
+
+// Run every reference position up to the given depth, checking the counts against the known values.
+// Returns the number of counts that did not match.
+int run_reference_positions(int max_depth, const PerftOptions& options)
+{
+	int failures = 0;
+	for (const PerftPosition& position : PERFT_POSITIONS)
+	{
+		cout << position.name << ": " << position.fen << "\n";
+		Chessboard cb;
+		cb.load_fen(position.fen);
+
+		for (int depth = 1; depth <= max_depth && depth <= position.node_counts.size(); depth++)
+		{
+			uint64_t nodes = run_perft(cb, depth, options);
+			if (nodes != position.node_counts[depth - 1])
+			{
+				cout << "\033[1;31mExpected " << position.node_counts[depth - 1] << " nodes\033[0m\n";
+				failures++;
+			}
+		}
+		cout << "\n";
+	}
+
+	cout << ((failures == 0) ? "All perft counts match.\n" : to_string(failures) + " perft counts did not match.\n");
+	return failures;
+}
+
+
+// Read the options from the arguments after the position and depth. Returns false if any can't be read.
+bool parse_options(int argc, char* argv[], int first, PerftOptions* options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		string option = argv[i];
+		if (option == "divide")
+			options->divide = true;
+		else if (option == "threads" && i + 1 < argc)
+			options->threads = max(1, atoi(argv[++i]));
+		else if (option == "hash" && i + 1 < argc)
+			options->hash_mb = max(0, atoi(argv[++i]));
+		else
+			return false;
+	}
+	return true;
+}
+
+
+// Usage:
+//	chess3d_perft <position> <depth> [divide] [threads <n>] [hash <MB>]
+//		where the position is a file in positions/ (e.g. positions/starting_position.txt) or a quoted FEN string
+//	chess3d_perft reference [max depth] [threads <n>] [hash <MB>]
+//		runs the standard perft positions up to the max depth (default 4) and checks the node counts
+// With more than one thread, the moves from the root position are shared out between the threads.
+// The hash table is shared by all threads, and can be used with any number of them.
+int main(int argc, char* argv[])
+{
+	PerftOptions options;
+	string usage = "Usage:\n"
+		"\tchess3d_perft <position file or FEN> <depth> [divide] [threads <n>] [hash <MB>]\n"
+		"\tchess3d_perft reference [max depth] [threads <n>] [hash <MB>]\n";
+
+	if (argc >= 2 && string(argv[1]) == "reference")
+	{
+		bool has_depth = (argc >= 3 && isdigit(argv[2][0]));
+		int max_depth = has_depth ? stoi(argv[2]) : 4;
+		if (!parse_options(argc, argv, has_depth ? 3 : 2, &options))
+		{
+			cout << usage;
+			return 1;
+		}
+		return (run_reference_positions(max_depth, options) == 0) ? 0 : 1;
+	}
+
+	if (argc < 3 || !isdigit(argv[2][0]) || !parse_options(argc, argv, 3, &options))
+	{
+		cout << usage;
+		return 1;
+	}
+
+	string position = argv[1];
+	int depth = stoi(argv[2]);
+
+	Chessboard cb;
+	if (position.size() > 4 && position.substr(position.size() - 4) == ".txt")
+		cb = Chessboard(position);
+	else if (!cb.load_fen(position))
+	{
+		cout << "Could not read FEN: " << position << "\n";
+		return 1;
+	}
+
+	run_perft(cb, depth, options);
+	return 0;
+}
@@ -0,0 +1,233 @@
+// chess3d_search.cpp
+
+#include <iostream>
+#include <iomanip>
+
+#include "logic.hpp"
+#include "perft.hpp"
+#include "search.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+
+
+// Options given after the position, or after scaling.
+struct SearchOptions
+{
+	SearchLimits limits;
+	size_t hash_mb = 16;    // 0 searches without a transposition table
+	int threads = 1;
+	PruningOptions pruning;
+	string eval_file;       // a network to evaluate with instead of the piece-square tables
+};
+
+
+// Search every reference position to a depth with each thread count in turn, doubling from 1 up to max_threads.
+// The table is emptied before each search, so every thread count starts from nothing.
+// Prints the total time to reach the depth for each thread count, and its speedup over a single thread.
+void run_scaling(int depth, int max_threads, size_t hash_mb)
+{
+	TranspositionTable tt(max<size_t>(1, hash_mb));
+	SearchLimits limits;
+	limits.depth = depth;
+
+	cout << "Time to depth " << depth << " over " << PERFT_POSITIONS.size() << " positions, with a " << tt.size_mb() << "MB table\n";
+	cout << setw(8) << "threads" << setw(12) << "seconds" << setw(10) << "speedup" << setw(14) << "nodes" << setw(12) << "nps" << "\n";
+
+	double single_thread_seconds = 0;
+	for (int threads = 1; threads <= max_threads; threads *= 2)
+	{
+		ParallelSearcher searcher(&tt, threads);
+		double seconds = 0;
+		uint64_t nodes = 0;
+		for (const PerftPosition& position : PERFT_POSITIONS)
+		{
+			Chessboard cb;
+			cb.load_fen(position.fen);
+			tt.clear();
+
+			SearchInfo info = searcher.search(&cb, limits);
+			seconds += info.seconds;
+			nodes += info.nodes;
+		}
+		if (threads == 1) single_thread_seconds = seconds;
+
+		cout << setw(8) << threads << setw(12) << fixed << setprecision(3) << seconds
+			<< setw(9) << setprecision(2) << ((seconds > 0) ? single_thread_seconds / seconds : 0) << "x"
+			<< setw(14) << nodes << setw(12) << (uint64_t)((seconds > 0) ? nodes / seconds : 0) << "\n";
+	}
+}
+
+
+// Search every reference position to a depth with each pruning option turned off in turn, then with all of them on and all off.
+// The table is emptied before each search, so every search starts from nothing.
+// Prints the total nodes and time to reach the depth for each, and how many times fewer nodes were needed than with none of them.
+void run_pruning(int depth, size_t hash_mb)
+{
+	TranspositionTable tt(max<size_t>(1, hash_mb));
+	SearchLimits limits;
+	limits.depth = depth;
+
+	PruningOptions all, no_null_move, no_lmr, no_futility, no_reverse_futility, no_check_extensions;
+	PruningOptions none = { false, false, false, false, false };
+	no_null_move.null_move = false;
+	no_lmr.late_move_reductions = false;
+	no_futility.futility = false;
+	no_reverse_futility.reverse_futility = false;
+	no_check_extensions.check_extensions = false;
+	vector<pair<string, PruningOptions>> configurations = {
+		{ "all", all }, { "no nullmove", no_null_move }, { "no lmr", no_lmr }, { "no futility", no_futility },
+		{ "no rfp", no_reverse_futility }, { "no checkext", no_check_extensions }, { "none", none }
+	};
+
+	cout << "Nodes to depth " << depth << " over " << PERFT_POSITIONS.size() << " positions, with a " << tt.size_mb() << "MB table\n";
+	cout << setw(14) << "pruning" << setw(14) << "nodes" << setw(12) << "seconds" << setw(12) << "reduction" << "\n";
+
+	vector<tuple<string, uint64_t, double>> results;
+	for (auto& [name, options] : configurations)
+	{
+		ParallelSearcher searcher(&tt, 1);
+		searcher.set_pruning(options);
+		uint64_t nodes = 0;
+		double seconds = 0;
+		for (const PerftPosition& position : PERFT_POSITIONS)
+		{
+			Chessboard cb;
+			cb.load_fen(position.fen);
+			tt.clear();
+
+			SearchInfo info = searcher.search(&cb, limits);
+			nodes += info.nodes;
+			seconds += info.seconds;
+		}
+		results.push_back({ name, nodes, seconds });
+	}
+
+	uint64_t unpruned_nodes = get<1>(results.back());
+	for (auto& [name, nodes, seconds] : results)
+	{
+		cout << setw(14) << name << setw(14) << nodes << setw(12) << fixed << setprecision(3) << seconds
+			<< setw(11) << setprecision(1) << ((nodes > 0) ? (double)unpruned_nodes / nodes : 0) << "x\n";
+	}
+}
+
+
+// Read the options from the arguments after the position. Returns false if any can't be read.
+bool parse_options(int argc, char* argv[], int first, SearchOptions* options)
+{
+	for (int i = first; i < argc; i++)
+	{
+		string option = argv[i];
+		if (i + 1 >= argc) return false;
+		if (option == "evalfile")
+		{
+			options->eval_file = argv[++i];
+			continue;
+		}
+		if (!isdigit(argv[i + 1][0])) return false;
+
+		if (option == "depth")
+			options->limits.depth = atoi(argv[++i]);
+		else if (option == "nodes")
+			options->limits.nodes = stoull(argv[++i]);
+		else if (option == "movetime")
+			options->limits.time_ms = stoll(argv[++i]);
+		else if (option == "clock")
+			options->limits.clock_ms = stoll(argv[++i]);
+		else if (option == "inc")
+			options->limits.increment_ms = stoll(argv[++i]);
+		else if (option == "movestogo")
+			options->limits.moves_to_go = atoi(argv[++i]);
+		else if (option == "hash")
+			options->hash_mb = atoi(argv[++i]);
+		else if (option == "threads")
+			options->threads = max(1, atoi(argv[++i]));
+		else if (option == "nullmove")
+			options->pruning.null_move = atoi(argv[++i]) != 0;
+		else if (option == "lmr")
+			options->pruning.late_move_reductions = atoi(argv[++i]) != 0;
+		else if (option == "futility")
+			options->pruning.futility = atoi(argv[++i]) != 0;
+		else if (option == "rfp")
+			options->pruning.reverse_futility = atoi(argv[++i]) != 0;
+		else if (option == "checkext")
+			options->pruning.check_extensions = atoi(argv[++i]) != 0;
+		else
+			return false;
+	}
+	return true;
+}
+
+
+// Usage:
+//	chess3d_search <position> [depth <n>] [nodes <n>] [movetime <ms>] [clock <ms>] [inc <ms>] [movestogo <n>] [hash <MB>] [threads <n>]
+//		[evalfile <network file>] [nullmove 0|1] [lmr 0|1] [futility 0|1] [rfp 0|1] [checkext 0|1]
+//		where the position is a file in positions/ (e.g. positions/starting_position.txt) or a quoted FEN string
+//	chess3d_search scaling [depth <n>] [threads <max>] [hash <MB>]
+//		searches the standard perft positions to the depth (default 6) with 1, 2, 4 ... up to max threads (default 32),
+//		and reports the time to depth and speedup of each thread count
+//	chess3d_search pruning [depth <n>] [hash <MB>]
+//		searches the standard perft positions to the depth (default 7) with each pruning option off in turn, and with all on and all off,
+//		and reports the nodes and time to depth of each
+// Searches the position until the first limit is reached, printing each iteration as it completes and then the best move.
+// With a clock, the time manager decides how long to search, as if playing with that much time left for the side to move.
+// Without any limits, searches to depth 5. The transposition table is 16MB unless given, and hash 0 searches without one.
+// With more than one thread, helper threads search alongside the main one, sharing the table.
+// With an evalfile, positions are evaluated with the network in the file (see nnue.hpp).
+// Each pruning option (nullmove, lmr, futility, rfp and checkext) is on unless turned off with 0, for comparing searches with and without it.
+int main(int argc, char* argv[])
+{
+	SearchOptions options;
+	string usage = "Usage:\n"
+		"\tchess3d_search <position file or FEN> [depth <n>] [nodes <n>] [movetime <ms>] [clock <ms>] [inc <ms>] [movestogo <n>] [hash <MB>] [threads <n>]\n"
+		"\t\t[evalfile <network file>] [nullmove 0|1] [lmr 0|1] [futility 0|1] [rfp 0|1] [checkext 0|1]\n"
+		"\tchess3d_search scaling [depth <n>] [threads <max>] [hash <MB>]\n"
+		"\tchess3d_search pruning [depth <n>] [hash <MB>]\n";
+
+	if (argc < 2 || !parse_options(argc, argv, 2, &options))
+	{
+		cout << usage;
+		return 1;
+	}
+
+	if (!options.eval_file.empty() && !load_network(options.eval_file))
+	{
+		cout << "Could not load network: " << options.eval_file << "\n";
+		return 1;
+	}
+
+	if (string(argv[1]) == "scaling")
+	{
+		bool has_threads = false;
+		for (int i = 2; i < argc; i++) has_threads |= (string(argv[i]) == "threads");
+		run_scaling((options.limits.depth > 0) ? options.limits.depth : 6, has_threads ? options.threads : 32, (options.hash_mb > 0) ? options.hash_mb : 16);
+		return 0;
+	}
+
+	if (string(argv[1]) == "pruning")
+	{
+		run_pruning((options.limits.depth > 0) ? options.limits.depth : 7, (options.hash_mb > 0) ? options.hash_mb : 16);
+		return 0;
+	}
+
+	if (options.limits.depth == 0 && options.limits.nodes == 0 && options.limits.time_ms == 0 && options.limits.clock_ms == 0) options.limits.depth = 5;
+
+	string position = argv[1];
+	Chessboard cb;
+	if (position.size() > 4 && position.substr(position.size() - 4) == ".txt")
+		cb = Chessboard(position);
+	else if (!cb.load_fen(position))
+	{
+		cout << "Could not read FEN: " << position << "\n";
+		return 1;
+	}
+
+	unique_ptr<TranspositionTable> tt = (options.hash_mb > 0) ? make_unique<TranspositionTable>(options.hash_mb) : nullptr;
+	ParallelSearcher searcher(tt.get(), options.threads);
+	searcher.set_pruning(options.pruning);
+	SearchInfo info = searcher.search(&cb, options.limits, [](const SearchInfo& iteration) { cout << format_info(iteration) << "\n"; });
+
+	cout << "bestmove " << (info.pv.empty() ? "(none)" : info.best_move().to_long_algebraic()) << "\n";
+	return 0;
+}
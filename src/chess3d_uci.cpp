@@ -0,0 +1,26 @@
+// chess3d_uci.cpp
+
+#include <iostream>
+#include <string>
+
+#include "uci.hpp"
+
+using namespace std;
+using namespace UciEngine;
+
+
+// Usage:
+//	chess3d_uci
+// Speaks the UCI protocol over standard input and output, for playing in chess GUIs and tournament managers (see uci.hpp).
+// Reads commands until quit or the end of the input, searching on a worker thread so commands are still read while it searches.
+int main()
+{
+	UciHandler handler([](const string& line) { cout << line << endl; });
+
+	string line;
+	while (getline(cin, line))
+	{
+		if (!handler.handle_command(line)) break;
+	}
+	return 0;
+}
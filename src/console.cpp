@@ -28,9 +28,23 @@ void ConsoleEngine::debug_print(Level log_level, vector<string> output)
 }
 
 
+// The keys of the positions before each move made so far, oldest first, for finding repetitions of the game.
+vector<Key> ConsoleEngine::get_game_keys(stack<UndoInfo> undo_stack)
+{
+	vector<Key> keys(undo_stack.size());
+	for (size_t i = keys.size(); i > 0; i--)
+	{
+		keys[i - 1] = undo_stack.top().key;
+		undo_stack.pop();
+	}
+	return keys;
+}
+
+
 // Get the target square to move from, and validate the input. 
-// Also handles special inputs for undoing moves, saving games and exiting to the menu.
-vector<int> ConsoleEngine::get_input_target_square(Chessboard *cb, stack<Chessboard> *board_stack)
+// Also handles special inputs for undoing moves, saving games and exiting to the menu,
+// and, given a background analysis, for turning it on or off and showing what it has found so far.
+vector<int> ConsoleEngine::get_input_target_square(Chessboard *cb, stack<UndoInfo> *undo_stack, BackgroundAnalysis *analysis)
 {
 	string move_choice;
 
@@ -44,16 +58,34 @@ vector<int> ConsoleEngine::get_input_target_square(Chessboard *cb, stack<Chessbo
 		else if (move_choice == "undo")
 		{
 			// Handle the 'undo' operation.
-			if (board_stack->size() <= 1)
+			if (undo_stack->empty())
 			{
 				debug_print(Level::ERROR, { "\033[1;31mNo more moves to undo.\033[0m\n" });
 				continue;
 			}
 			debug_print(Level::INFO, { "\033[1;31mUndoing move.\033[0m\n" });
 
-			board_stack->pop();
-			*cb = board_stack->top();
-			print_board(*cb, vector<Square>(), Gamestate::NORMAL);
+			// take back the last move. the move lists are worked out from the board when needed, so there is nothing else to update
+			cb->undo_move(undo_stack->top());
+			undo_stack->pop();
+			print_board(*cb, MoveList(), Gamestate::NORMAL);
+			if (analysis != nullptr) analysis->start(*cb, get_game_keys(*undo_stack));
+
+			continue;
+		}
+		else if (move_choice == "analyse" && analysis != nullptr)
+		{
+			// Handle turning background analysis on or off.
+			analysis->set_enabled(!analysis->is_enabled());
+			analysis->start(*cb, get_game_keys(*undo_stack));
+			debug_print(Level::INFO, { "\033[1;33mAnalysis ", (analysis->is_enabled() ? "on" : "off"), ".\033[0m\n" });
+
+			continue;
+		}
+		else if (move_choice == "hint" && analysis != nullptr)
+		{
+			// Handle showing the analysis so far.
+			debug_print(Level::INFO, { "\033[1;33m", analysis->describe(), "\033[0m\n" });
 
 			continue;
 		}
@@ -95,7 +127,7 @@ vector<int> ConsoleEngine::get_input_target_square(Chessboard *cb, stack<Chessbo
 			debug_print(Level::DEBUG, { "\x1B[2J\x1B[H" });
 			debug_print(Level::DEBUG, { "Moves: " });
 
-			vector<Square> vms = cb->find_valid_moves(cb->board[target_position[0]][target_position[1]]);
+			MoveList vms = cb->find_valid_moves(cb->board[target_position[0]][target_position[1]]);
 			// if the chosen piece has no valid moves, restart the loop
 			if (vms.size() == 0)
 			{
@@ -110,7 +142,7 @@ vector<int> ConsoleEngine::get_input_target_square(Chessboard *cb, stack<Chessbo
 }
 
 
-vector<int> ConsoleEngine::get_input_destination_square(vector<Square> vms)
+vector<int> ConsoleEngine::get_input_destination_square(const MoveList& vms)
 {
 	while (true)
 	{
@@ -137,9 +169,9 @@ vector<int> ConsoleEngine::get_input_destination_square(vector<Square> vms)
 
 		// make sure we can move to that square with the piece we selected. if not, restart the loop.
 		bool found_valid_move_match = false;
-		for (int i = 0; i < vms.size(); i++)
+		for (Move move : vms)
 		{
-			if (vms[i].row == destination_position[0] && vms[i].col == destination_position[1])
+			if (move.to() == square_index(destination_position[0], destination_position[1]))
 			{
 				found_valid_move_match = true;
 			}
@@ -156,7 +188,7 @@ vector<int> ConsoleEngine::get_input_destination_square(vector<Square> vms)
 
 
 // Print a coloured board to the console.
-void ConsoleEngine::print_board(Chessboard chessboard, vector<Square> valid_moves, Gamestate gamestate)
+void ConsoleEngine::print_board(Chessboard chessboard, const MoveList& valid_moves, Gamestate gamestate)
 {
 	map<Piece, char> piece_map = {
 		{ Piece::EMPTY,  ' ' },
@@ -167,6 +199,10 @@ void ConsoleEngine::print_board(Chessboard chessboard, vector<Square> valid_move
 		{ Piece::QUEEN,  'Q' },
 		{ Piece::KING,   'K' }
 	};
+	// the squares the moves land on, to highlight
+	Bitboard highlighted = 0;
+	for (Move move : valid_moves) highlighted |= square_bb(move.to());
+
 	debug_print(Level::INFO, { "PGN : ", chessboard.notation, "\n"});
 	debug_print(Level::INFO, { "Current board : \n\n" });
 
@@ -194,7 +230,7 @@ void ConsoleEngine::print_board(Chessboard chessboard, vector<Square> valid_move
 			string colourcode = "\033[";
 
 			// attacked squares
-			if (count(valid_moves.begin(), valid_moves.end(), chessboard.board[DIM_SIZE - (1 + i)][j]) > 0)
+			if (highlighted & square_bb(square_index(DIM_SIZE - (1 + i), j)))
 			{
 				colourcode += "43;"; // yellow bg
 			}
@@ -257,6 +293,7 @@ map<int, string> ConsoleEngine::get_file_map(fs::path p, int *cur_id)
 			string gamepath = entry.path().string();
 			string base_filename = gamepath.substr(gamepath.find_last_of("/\\") + 1);
 			if (base_filename == "example.pgn") continue; // skip example pgn file for test
+			if (entry.path().extension() == ".epd") continue; // skip test suites, which hold many positions rather than a game
 			debug_print(Level::INFO, { to_string(*cur_id), ".  ", base_filename + "\n" });
 			id_game_map[*cur_id] = base_filename;
 			(*cur_id)++;
@@ -365,7 +402,8 @@ void ConsoleEngine::print_game_load_header(string active_player_str, Gamestate g
 	else debug_print(Level::INFO, { "\033[1;32mLOADED GAME\033[0m\n" });
 	debug_print(Level::INFO, { "\033[1;33m" + white_name + " vs " + black_name + "\n" });
 	debug_print(Level::INFO, { "\033[1;33m" + active_player_str + " to move.\n" });
-	debug_print(Level::INFO, { "When inputting target square:\n  - Type 'undo' to undo move.\n  - Type 'save' to save PGN file.\n  - Type 'exit' to return to menu.\033[0m\n\n" });
+	debug_print(Level::INFO, { "When inputting target square:\n  - Type 'undo' to undo move.\n  - Type 'save' to save PGN file.\n  - Type 'exit' to return to menu.\n"
+		"  - Type 'analyse' to turn analysis while you think on or off, and 'hint' to see its best move so far.\033[0m\n\n" });
 }
 
 
@@ -0,0 +1,25 @@
+// evaluate.cpp
+
+#include "evaluate.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+
+
+// Score a position in centipawns from the point of view of the side to move.
+// The board keeps midgame and endgame sums of material and piece-square values up to date as pieces move.
+// The pawn structure is added to those, and the two are blended by how much material is left (tapering) before taking the side to move's view.
+// While a network is loaded, the network scores the position instead.
+int SearchEngine::evaluate(const Chessboard& chessboard, PawnTable* pawn_table)
+{
+	if (nnue_can_evaluate(chessboard)) return nnue_evaluate(chessboard);
+
+	PawnEntry pawns = (pawn_table != nullptr) ? pawn_table->probe(chessboard) : evaluate_pawns(chessboard);
+
+	int mg = chessboard.psqt.mg + pawns.mg[0] - pawns.mg[1];
+	int eg = chessboard.psqt.eg + pawns.eg[0] - pawns.eg[1];
+	int phase = min(chessboard.psqt.phase, MAX_PHASE);
+	int score = (mg * phase + eg * (MAX_PHASE - phase)) / MAX_PHASE;
+
+	return (chessboard.active_player == Colour::WHITE) ? score : -score;
+}
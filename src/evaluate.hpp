@@ -0,0 +1,14 @@
+#pragma once
+
+#include "logic.hpp"
+#include "pawns.hpp"
+
+namespace SearchEngine
+{
+    // Piece values in centipawns, indexed by piece, for weighing up captures. The king is never captured, so is worth nothing here.
+    // The evaluation itself uses the midgame and endgame values in psqt.hpp.
+    const int PIECE_VALUES[7] = { 0, 100, 500, 320, 330, 900, 0 };
+
+    // The pawn structure is looked up in the pawn table if one is given, and worked out from scratch if not; the score is the same either way.
+    int evaluate(const LogicEngine::Chessboard& chessboard, PawnTable* pawn_table = nullptr);
+}
@@ -150,17 +150,14 @@ tuple<Chessboard, Gamestate> FileHandler::parse_pgn(Chessboard cb, vector<string
 			string dest_square_str = cur_pgn.substr(cur_pgn.length() - 2);
 			vector<int> dest_square = convert_chessboard_square_to_int(dest_square_str);
 
-			// Find the valid move lists for each player
-			get_valid_and_attacking_moves(&cb);
-
 			vector<Square> potential_movers;
 			// Finding the piece that moved
-			cb.active_player = active_colour;
-			vector<tuple<Square, vector<Square>>> all_movers = (move_config["is_capture"] ? cb.attacking_moves[cb.active_player] : cb.valid_moves[cb.active_player]);
-			for (int i = 0; i < all_movers.size(); i++)
+			cb.set_active_player(active_colour);
+			MoveList all_movers = (move_config["is_capture"] ? cb.attacking_moves(cb.active_player) : cb.valid_moves(cb.active_player));
+			for (Move move : all_movers)
 			{
-				Square potential_mover = get<0>(all_movers[i]);
-				if (is_dest_square_attackable_by_piece(all_movers[i], dest_square))
+				Square potential_mover = cb.board[square_row(move.from())][square_col(move.from())];
+				if (move.to() == square_index(dest_square[0], dest_square[1]))
 				{
 					if (potential_mover.piece == moving_piece)
 					{
@@ -207,19 +204,8 @@ tuple<Chessboard, Gamestate> FileHandler::parse_pgn(Chessboard cb, vector<string
 				}
 			}
 
-			switch_pieces(&cb, { mvr.row, mvr.col }, dest_square);
-			cb.move_no++;
-
-			if (move_config["is_promotion"])
-			{
-				cb.board[dest_square[0]][dest_square[1]].piece = promotion_choice;
-			}
-			if (move_config["is_en_passant"])
-			{
-				int captured_pawn_rank = (active_colour == Colour::WHITE) ? 4 : 3;
-				cb.board[captured_pawn_rank][dest_square[1]] = Square(captured_pawn_rank, dest_square[1]);
-				get_valid_and_attacking_moves(&cb);
-			}
+			// build_move() spots en passant from the pawn moving diagonally onto an empty square
+			cb.do_move(build_move(cb, { mvr.row, mvr.col }, dest_square, promotion_choice));
 		}
 		else
 		{
@@ -228,17 +214,8 @@ tuple<Chessboard, Gamestate> FileHandler::parse_pgn(Chessboard cb, vector<string
 			bool queenside = true;
 			if (cur_pgn == "O-O") queenside = false;
 
-			Square player_king = active_colour == Colour::WHITE ? cb.board[0][4] : cb.board[7][4];
-			if (queenside)
-			{
-				switch_pieces(&cb, { player_king.row, player_king.col }, vector<int>({ player_king.row, 2 }));
-				switch_pieces(&cb, { player_king.row, 0 }, vector<int>({ player_king.row, 3 }));
-			}
-			else
-			{
-				switch_pieces(&cb, { player_king.row, player_king.col }, vector<int>({ player_king.row, 6 }));
-				switch_pieces(&cb, { player_king.row, 7 }, vector<int>({ player_king.row, 5 }));
-			}
+			int king_sq = (active_colour == Colour::WHITE) ? square_index(0, 4) : square_index(7, 4);
+			cb.do_move(Move(king_sq, queenside ? king_sq - 2 : king_sq + 2, MoveFlag::CASTLING));
 		}
 
 		gs = Gamestate::NORMAL;
@@ -246,9 +223,6 @@ tuple<Chessboard, Gamestate> FileHandler::parse_pgn(Chessboard cb, vector<string
 		if (move_config["is_checkmate"]) gs = Gamestate::CHECKMATE;
 	}
 
-	Colour opp_colour = (cb.active_player == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
-	cb.active_player = opp_colour;
-
 	return tuple<Chessboard, Gamestate>(cb, gs);
 }
 
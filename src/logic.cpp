@@ -1,6 +1,10 @@
 // logic.cpp
 
+#include <cassert>
+#include <sstream>
+
 #include "logic.hpp"
+#include "movegen.hpp"
 #include "console.hpp"
 #include "file_handler.hpp"
 
@@ -18,8 +22,6 @@ Square::Square()
 	piece = Piece::EMPTY;
 	row = -1;
 	col = -1;
-	has_moved = true;
-	when_moved = {};
 }
 
 Square::Square(int r, int c)
@@ -28,19 +30,78 @@ Square::Square(int r, int c)
 	piece = Piece::EMPTY;
 	row = r;
 	col = c;
-	has_moved = true;
-	when_moved = {};
 }
 
 
-Square::Square(Piece p, Colour c, int i, int j, bool h_m, vector<int> w_m)
+Square::Square(Piece p, Colour c, int i, int j)
 {
 	piece = p;
 	colour = c;
 	row = i;
 	col = j;
-	has_moved = h_m;
-	when_moved = w_m;
+}
+
+
+// Write a move in long algebraic notation, e.g. "e2e4" or "e7e8q", as used for perft output.
+string Move::to_long_algebraic() const
+{
+	string result = "";
+	for (int sq : { from(), to() })
+	{
+		result += (char)('a' + square_col(sq));
+		result += (char)('1' + square_row(sq));
+	}
+
+	switch (promotion())
+	{
+		case Piece::QUEEN:  result += "q"; break;
+		case Piece::ROOK:   result += "r"; break;
+		case Piece::BISHOP: result += "b"; break;
+		case Piece::KNIGHT: result += "n"; break;
+		default: break;
+	}
+
+	return result;
+}
+
+
+// Add or remove a piece from the bitboards, keeping the colour occupancy in step.
+void Bitboards::add(Colour c, Piece p, int sq)
+{
+	pieces[(int)c][(int)p - 1] |= square_bb(sq);
+	occupancy[(int)c] |= square_bb(sq);
+}
+
+void Bitboards::remove(Colour c, Piece p, int sq)
+{
+	pieces[(int)c][(int)p - 1] &= ~square_bb(sq);
+	occupancy[(int)c] &= ~square_bb(sq);
+}
+
+
+// Replace the attacks of the piece on a square, counting again only the squares that changed.
+void AttackMap::set(Colour c, int sq, Bitboard attacks)
+{
+	Bitboard lost = from[sq] & ~attacks;
+	Bitboard gained = attacks & ~from[sq];
+	while (lost)
+	{
+		int target = pop_lsb(&lost);
+		if (--counts[(int)c][target] == 0) attacked[(int)c] &= ~square_bb(target);
+	}
+	while (gained)
+	{
+		int target = pop_lsb(&gained);
+		if (counts[(int)c][target]++ == 0) attacked[(int)c] |= square_bb(target);
+	}
+	from[sq] = attacks;
+}
+
+bool AttackMap::operator==(const AttackMap& rhs) const
+{
+	return equal(begin(from), end(from), begin(rhs.from))
+		&& equal(&counts[0][0], &counts[0][0] + (2 * NUM_SQUARES), &rhs.counts[0][0])
+		&& attacked[0] == rhs.attacked[0] && attacked[1] == rhs.attacked[1];
 }
 
 
@@ -50,8 +111,7 @@ bool Square::operator==(const Square rhs) const
 	return (colour == rhs.colour)
 		&& (piece == rhs.piece)
 		&& (row == rhs.row)
-		&& (col == rhs.col)
-		&& (has_moved == rhs.has_moved);
+		&& (col == rhs.col);
 }
 
 bool Square::operator!=(const Square rhs) const
@@ -80,853 +140,758 @@ vector<int> LogicEngine::convert_chessboard_square_to_int(string position)
 }
 
 
-// Take a vector<tuple<Square, vector<Square>>> object of the attackable squares and reduce it to a vector of the attacked squares
-vector<Square> parse_attackable_squares(vector<tuple<Square, vector<Square>>> attackable_squares)
+// For a given square, find all the moves that piece can move to.
+// The legal move generator masks the piece's prospective moves with the checks and pins on the king, which the board works out once per position.
+MoveList LogicEngine::get_valid_square_moves(Square target, const Chessboard& chessboard)
 {
-	vector<Square> result;
-	for (int i = 0; i < attackable_squares.size(); i++)
-	{
-		vector<Square> selected_piece_attacked_squares = get<1>(attackable_squares[i]);
-		result.insert(result.end(), selected_piece_attacked_squares.begin(), selected_piece_attacked_squares.end());
-	}
-
-	return result;
+	MoveList moves;
+	add_moves(chessboard, target, get_legal_moves(chessboard, chessboard.cached_king_safety(target.colour), target), &moves, false);
+	return moves;
 }
 
 
-// Find the two diagonal squares the pawn can capture on
-vector<Square> get_pawn_attacking_squares(Square target, vector<vector<Square>> board, Colour opp_colour, int dir)
+// Go through the board and compile a list of all the moves a player is currently targeting
+MoveList LogicEngine::find_all_attackable_squares(const Chessboard& chessboard, Colour colour, Piece_Finding_Mode mode)
 {
-	vector<Square> pawn_attacking_squares;
-
-	// handle case where pawn is at the end of the board and cannot attack the squares in front
-	if ((target.colour == Colour::WHITE && target.row == 7) || (target.colour == Colour::BLACK && target.row == 0))
-		return pawn_attacking_squares;
+	MoveList all_attackable_squares;
+	Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	const Board& board = chessboard.board;
 
-	if (target.col > 0) {
-		if (board[target.row + dir][target.col - 1].colour == opp_colour) {
-			pawn_attacking_squares.push_back(board[target.row + dir][target.col - 1]);
-		}
-	}
-	if (target.col < 7) {
-		if (board[target.row + dir][target.col + 1].colour == opp_colour) {
-			pawn_attacking_squares.push_back(board[target.row + dir][target.col + 1]);
+	// only visit the squares occupied by the colour, in the same order as a scan of the board
+	Bitboard pieces = chessboard.bitboards.occupancy[(int)colour];
+	while (pieces)
+	{
+		int sq = pop_lsb(&pieces);
+		Square target = board[square_row(sq)][square_col(sq)];
+		switch (mode)
+		{
+			// find all the valid moves
+			case Piece_Finding_Mode::VALID:
+				add_moves(chessboard, target, chessboard.cached_piece_moves(sq), &all_attackable_squares, false);
+				break;
+
+			// find all the attacking moves: the captures a piece can make.
+			// The attack map already holds the squares each piece attacks, so only pieces attacking an opponent piece need their legal moves found.
+			// Pawns need no special case, since the squares they attack are not the squares they move forward to.
+			case Piece_Finding_Mode::ATTACKABLE:
+			{
+				Bitboard targets = chessboard.attacks.from[sq] & chessboard.bitboards.occupancy[(int)opp_colour];
+				if (targets)
+					add_moves(chessboard, target, targets & chessboard.cached_piece_moves(sq), &all_attackable_squares, false);
+				break;
+			}
 		}
 	}
 
-	return pawn_attacking_squares;
+	return all_attackable_squares;
 }
 
 
-// Go through the logic of en passant, determining whether the move is legal for a specified direction (-1 for left, 1 for right)
-bool can_en_passant(Square pawn, vector<vector<Square>> board, Colour opp_colour, int dir, int move_no)
+// Test for checkmate and stalemate.
+// We look for any move the player can make, stopping at the first one found.
+// If there are none, the player is checkmated.
+// If the player is not in check, the game ends in stalemate.
+bool test_for_checkmate_stalemate(Chessboard* cb, Colour player, Colour opp_colour)
 {
-	int test_col = pawn.col + dir;
+	return !cb->has_any_legal_move(player);
+}
 
-	if (test_col < 0 || test_col >= DIM_SIZE)
-		return false;
 
-	if (board[pawn.row][test_col].piece != Piece::PAWN)
-		return false;
+// handles the logic of moving one square into another, and replacing the moved square with an empty square
+void LogicEngine::switch_pieces(Chessboard *cb, vector<int> target_position, vector<int> destination_position)
+{
+	Square moved_piece = cb->board[target_position[0]][target_position[1]];
+	moved_piece.row = destination_position[0];
+	moved_piece.col = destination_position[1];
 
-	// If the last move was the pawn, we can en passant it
-	if ((board[pawn.row][test_col].when_moved.size() == 1) && (board[pawn.row][test_col].when_moved.back() == move_no - 1))
-		return true;
-	else
-		return false;
+	cb->set_square(destination_position[0], destination_position[1], moved_piece);
+	cb->set_square(target_position[0], target_position[1], Square(target_position[0], target_position[1]));
 }
 
 
-// For pawns, look a square ahead in the direction a pawn can move in, or two if the paawn hasn't moved yet.
-// Also check for diagonal captures and en passant.
-vector<Square> get_prospective_pawn_moves(Square target, vector<vector<Square>> board, Colour opp_colour, int move_no)
+// Reference the piece notation map
+string get_piece_notation_map(Piece p)
 {
-	vector<Square> prospective_moves;
+	map<Piece, string> piece_notation_map = {
+		{ Piece::EMPTY,  " " },
+		{ Piece::PAWN,   ""  },
+		{ Piece::ROOK,   "R" },
+		{ Piece::KNIGHT, "N" },
+		{ Piece::BISHOP, "B" },
+		{ Piece::QUEEN,  "Q" },
+		{ Piece::KING,   "K" }
+	};
 
-	// use +1 for white and -1 for black to find valid squares in the direction (dir) the pawn moves in
-	int dir = (target.colour == Colour::WHITE) ? 1 : -1;
+	return piece_notation_map[p];
+}
 
-	if ((target.colour == Colour::WHITE && target.row < 7) || (target.colour == Colour::BLACK && target.row > 0))
-	{
-		// moving one square ahead
-		if (board[target.row + dir][target.col].colour == Colour::EMPTY)
-		{
-			prospective_moves.push_back(board[target.row + dir][target.col]);
 
-			// case for pawns on the starting file
-			if (!target.has_moved && target.row == ((target.colour == Colour::WHITE) ? 1 : 6))
-			{
-				if (board[target.row + (dir * 2)][target.col].colour == Colour::EMPTY)
-				{
-					prospective_moves.push_back(board[target.row + (dir * 2)][target.col]);
-				}
-			}
-		}
+// Build the notation for the ply, e.g. "Nbxd2"
+// This is worked out before the move is made, while the other pieces that could have made it can still be found.
+string get_ply_notation(Chessboard* cb, vector<int> target_position, vector<int> destination_position, bool is_capture)
+{
+	string result_notation = "";
 
-		// in the case where there is an opposite-coloured piece diagonally in front of the pawn: that piece is capturable
-		vector<Square> pawn_attacking_Squares = get_pawn_attacking_squares(target, board, opp_colour, dir);
-		prospective_moves.insert(prospective_moves.end(), pawn_attacking_Squares.begin(), pawn_attacking_Squares.end());
-	}
+	// First get the section of the string for the moved piece
+	Square moved_piece = cb->board[target_position[0]][target_position[1]];
+	result_notation += get_piece_notation_map(moved_piece.piece);
+
+	// If multiple pieces could move to that location, we need to show more details about which one moved there.
+	// Only other pieces of the same type can, and for a capture only those the attack map has attacking the square.
+	// In the case of pawns, we want the attacking moves if a piece was captured, but the valid moves if not.
+	// This is because a pawn moving forward should only have one option- directly in front. En passant does not affect this as it still involves capturing.
+	int from = square_index(target_position[0], target_position[1]);
+	int to = square_index(destination_position[0], destination_position[1]);
+	Bitboard others = cb->bitboards.of(moved_piece.colour, moved_piece.piece) & ~square_bb(from);
+	bool candidate_on_row = false;
+	bool candidate_on_col = false;
 
-	// Check for en passant. For this, the piece must have advanced exactly three ranks: white pawns must be on rank 5 and black on rank 4
-	// Then, an opponent pawn must have moved two ranks forward in the previous move to be adjacent to the pawn.
-	// If so, we can move the pawn diagonally and capture the opponent pawn.
-	if (target.row == ((target.colour == Colour::WHITE) ? 4 : 3))
+	while (others)
 	{
-		// to the left
-		if (can_en_passant(target, board, opp_colour, -1, move_no))
-			prospective_moves.push_back(board[target.row + dir][target.col - 1]);
-		// to the right
-		if (can_en_passant(target, board, opp_colour, 1, move_no))
-			prospective_moves.push_back(board[target.row + dir][target.col + 1]);
+		int sq = pop_lsb(&others);
+		if (is_capture && !(cb->attacks.from[sq] & square_bb(to))) continue;
+		if (!(cb->cached_piece_moves(sq) & square_bb(to))) continue;
+
+		// Look to see if the piece is on the same rank or file as the piece that moved.
+		Square potential_mover = cb->board[square_row(sq)][square_col(sq)];
+		if (potential_mover.row == target_position[0]) candidate_on_row = true;
+		if (potential_mover.col == target_position[1]) candidate_on_col = true;
+
+		// For knights, this isn't necessarily true and we must perform more tests to dig a level deeper.
+		// NOTE there is a bug here where a player with 3 knights can get incorrect notation. but who cares
+		if (potential_mover.piece == Piece::KNIGHT && !candidate_on_col) candidate_on_row = true;
 	}
+
+	// If the piece is a pawn and theres a capture we must always include the file.
+	if (is_capture && moved_piece.piece == Piece::PAWN && !candidate_on_col) candidate_on_row = true;
+
+	if (candidate_on_row) result_notation += convert_int_to_chessboard_square(target_position[1], target_position[0])[0];
+	if (candidate_on_col) result_notation += convert_int_to_chessboard_square(target_position[1], target_position[0])[1];
 	
-	return prospective_moves;
-}
+	
+	// If a piece was captured, we need to represent a capture
+	if (is_capture) result_notation += "x";
 
+	// Then append the coordinates of the landing square
+	result_notation += convert_int_to_chessboard_square(destination_position[1], destination_position[0]);
 
-// For rooks and bishops, test to see if the prospective square is valid (i.e. not occupied by a piece of the same colour.
-// If not valid, set the progress_search flag to false to prevent looking any further in the piece's sightline.
-void progress_rook_bishop_search(Square target, Square test_square, Colour opp_colour, vector<Square>* prospective_moves, bool* progress_search)
-{
-	if (test_square.colour == Colour::EMPTY)
-	{
-		(*prospective_moves).push_back(test_square);
-	}
-	else if (test_square.colour == opp_colour)
-	{
-		(*prospective_moves).push_back(test_square);
-		*progress_search = false;
-	}
-	else if (test_square.colour == target.colour)
-	{
-		*progress_search = false;
-	}
+	return result_notation;
 }
 
 
-// For each cardinal direction outwards from the piece location, we:
-// progress forwards in the direction, adding all empty squares to the list of prospective moves
-// if we reach a non-empty square:
-// if the opposite colour: add it to the list and prevent moving further.
-// if the same colour: just prevent moving further
-vector<Square> get_prospective_rook_moves(Square target, vector<vector<Square>> board, Colour opp_colour)
+// Work out the move for a piece moving from the target to the destination square, flagging special moves from the board.
+// Kings moving two files are castling, and pawns moving diagonally onto an empty square are capturing en passant.
+Move LogicEngine::build_move(const Chessboard& chessboard, vector<int> target_position, vector<int> destination_position, Piece promotion_choice)
 {
-	vector<Square> prospective_moves;
+	Square moving_piece = chessboard.board[target_position[0]][target_position[1]];
+	Square destination_piece = chessboard.board[destination_position[0]][destination_position[1]];
+	int from = square_index(target_position[0], target_position[1]);
+	int to = square_index(destination_position[0], destination_position[1]);
 
-	// forwards
-	bool progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
+	switch (moving_piece.piece)
 	{
-		if ((target.row + i) >= DIM_SIZE) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row + i][target.col];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
+	case Piece::KING:
+		if (abs(destination_position[1] - target_position[1]) == 2)
+			return Move(from, to, MoveFlag::CASTLING);
+		break;
+	case Piece::PAWN:
+		if (destination_position[0] == (moving_piece.colour == Colour::WHITE ? 7 : 0))
+			return Move(from, to, MoveFlag::PROMOTION, promotion_choice);
+		if (abs(destination_position[0] - target_position[0]) == 2)
+			return Move(from, to, MoveFlag::DOUBLE_PUSH);
+		if (destination_piece.piece == Piece::EMPTY && destination_position[1] != target_position[1])
+			return Move(from, to, MoveFlag::EN_PASSANT);
+		break;
+	default:
+		break;
 	}
 
-	// backwards
-	progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
-	{
-		if ((target.row - i) < 0) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row - i][target.col];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
-	}
+	return Move(from, to);
+}
 
-	// left
-	progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
-	{
-		if ((target.col + i) >= DIM_SIZE) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row][target.col + i];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
-	}
 
-	// right
-	progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
-	{
-		if ((target.col - i) < 0) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row][target.col - i];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
-	}
+// Go through the move making procedure. Assume from prior checks that the move is valid.
+// 1. Make the move, storing the details of the moved piece and destination square
+// 2. Look for check, checkmate and stalemate.
+// 3. Build the PGN string for the move.
+// 4. Return a gamestate depending on the state of the game
+// The board's do_move() switches the active player and increments the move counter.
+// If an undo record is passed in, it is filled so the move can be taken back with undo_move().
+Gamestate LogicEngine::make_move(Chessboard* cb, Move move, UndoInfo* undo)
+{
+	vector<int> target_position = { square_row(move.from()), square_col(move.from()) };
+	vector<int> destination_position = { square_row(move.to()), square_col(move.to()) };
+	Colour colour = cb->board[target_position[0]][target_position[1]].colour;
+	Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	int move_no = cb->move_no;
 
-	return prospective_moves;
-}
+	Gamestate gamestate = Gamestate::NORMAL;
 
+	// 1. Make the move, writing its notation first while the pieces are where the player saw them
+	bool is_capture = (cb->board[destination_position[0]][destination_position[1]].piece == Piece::EMPTY) ? false : true;
+	string ply_notation = get_ply_notation(cb, target_position, destination_position, is_capture);
 
-// For each diagonal direction outwards from the piece location, we:
-// progress in the direction, adding all empty squares to the list of prospective moves
-// if we reach a non-empty square:
-// if the opposite colour: add it to the list and prevent moving further.
-// if the same colour: just prevent moving further
-vector<Square> get_prospective_bishop_moves(Square target, vector<vector<Square>> board, Colour opp_colour)
-{
-	vector<Square> prospective_moves;
+	UndoInfo move_undo = cb->do_move(move);
+	if (undo != nullptr) *undo = move_undo;
 
-	// up-right
-	bool progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
+	switch (move.flag())
 	{
-		if ((target.row + i) >= DIM_SIZE || (target.col + i) >= DIM_SIZE) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row + i][target.col + i];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
+		case MoveFlag::CASTLING:
+			ply_notation = (destination_position[1] == 2) ? "O-O-O" : "O-O";
+			break;
+		case MoveFlag::EN_PASSANT:
+			ply_notation += "ep";
+			break;
+		case MoveFlag::PROMOTION:
+			ply_notation += get_piece_notation_map(move.promotion());
+			break;
+		default:
+			break;
 	}
 
-	// down-right
-	progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
+	// 2. Look for check, checkmate and stalemate
+	if (is_king_attacked(*cb, opp_colour))
 	{
-		if ((target.row - i) < 0 || (target.col + i) >= DIM_SIZE) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row - i][target.col + i];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
+		// The opponent king is in check.
+		// We already restrict the player's moves once in check to those that escape check.
+		// We must however look for checkmate.
+		gamestate = Gamestate::CHECK;
+		bool is_checkmate = test_for_checkmate_stalemate(cb, opp_colour, colour);
+		ply_notation += (is_checkmate ? "#" : "+");
+		if (is_checkmate) gamestate = Gamestate::CHECKMATE;
 	}
-
-	// up-left
-	progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
+	else
 	{
-		if ((target.row + i) >= DIM_SIZE || (target.col - i) < 0) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row + i][target.col - i];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
+		bool is_stalemate = test_for_checkmate_stalemate(cb, opp_colour, colour);
+		if (is_stalemate) gamestate = Gamestate::STALEMATE;
 	}
 
-	// down-left
-	progress_search = true;
-	for (int i = 1; i < DIM_SIZE; i++)
+	// 3. Add the ply notation to the game's notation
+	string full_ply_notation = "";
+	if (colour == Colour::WHITE)
 	{
-		if ((target.row - i) < 0 || (target.col - i) < 0) progress_search = false;
-		if (!progress_search) continue;
-		Square test_square = board[target.row - i][target.col - i];
-		progress_rook_bishop_search(target, test_square, opp_colour, &prospective_moves, &progress_search);
+		full_ply_notation += to_string((move_no + 1) / 2);
+		full_ply_notation += ".";
+		full_ply_notation += ply_notation;
 	}
+	else
+	{
+		full_ply_notation += " ";
+		full_ply_notation += ply_notation;
+		full_ply_notation += " ";
+	}
+	cb->notation += full_ply_notation;
 
-	return prospective_moves;
+	return gamestate;
 }
 
 
-// Find queen moves by imagining the queen as a rook and bishop and concatenating the prospective moves of the two
-vector<Square> get_prospective_queen_moves(Square target, vector<vector<Square>> board, Colour opp_colour)
+// Find the castling rights lost by a move to or from a square: moving the king loses both, and moving or capturing a rook loses its side.
+int get_castling_rights_lost(int sq)
 {
-	vector<Square> prospective_moves_rook = get_prospective_rook_moves(target, board, opp_colour);
-	vector<Square> prospective_moves_bishop = get_prospective_bishop_moves(target, board, opp_colour);
-
-	// concatenate prospective moves for rook and bishop
-	vector<Square> prospective_moves = prospective_moves_rook;
-	prospective_moves.insert(prospective_moves.end(), prospective_moves_bishop.begin(), prospective_moves_bishop.end());
-	return prospective_moves;
+	switch (sq)
+	{
+		case square_index(0, 4): return WHITE_OO | WHITE_OOO;
+		case square_index(0, 0): return WHITE_OOO;
+		case square_index(0, 7): return WHITE_OO;
+		case square_index(7, 4): return BLACK_OO | BLACK_OOO;
+		case square_index(7, 0): return BLACK_OOO;
+		case square_index(7, 7): return BLACK_OO;
+		default: return 0;
+	}
 }
 
 
-// Given a square the knight could move to, determine if that square is on the board.
-// If so, find out if its a prospective move (i.e. not occupied by a piece of the same colour).
-bool is_knight_square_prospective(Square target, vector<vector<Square>> board, Colour opp_colour, int row_t, int col_t)
+// Make a move on the board, returning what is needed to take it back again.
+// Handles moving the rook when castling, removing the pawn captured en passant, and promoting pawns.
+// Unlike make_move(), this does not update the move lists or notation, so it is cheap enough to call for every move in a search.
+UndoInfo Chessboard::do_move(Move move)
 {
-	if ((target.row + row_t >= DIM_SIZE) || (target.row + row_t < 0) || (target.col + col_t >= DIM_SIZE) || (target.col + col_t < 0))
-		return false;
-	Square test_square = board[target.row + row_t][target.col + col_t];
+	int from_row = square_row(move.from()), from_col = square_col(move.from());
+	int to_row = square_row(move.to()), to_col = square_col(move.to());
 
-	if (test_square.colour == Colour::EMPTY || test_square.colour == opp_colour)
-		return true;
+	UndoInfo undo;
+	undo.move = move;
+	undo.castling_rights = castling_rights;
+	undo.ep_square = ep_square;
+	undo.halfmove_clock = halfmove_clock;
+	undo.notation_length = notation.size();
+	undo.key = key;
 
-	return false;
-}
+	// the pawn captured en passant stands beside the moving pawn, rather than on the square it moves to
+	int captured_row = (move.flag() == MoveFlag::EN_PASSANT) ? from_row : to_row;
+	undo.captured = board[captured_row][to_col];
+	if (move.flag() == MoveFlag::EN_PASSANT)
+		set_square(captured_row, to_col, Square(captured_row, to_col));
 
+	// the fifty-move count starts again whenever a pawn moves or a piece is captured
+	bool resets_clock = (board[from_row][from_col].piece == Piece::PAWN) || (undo.captured.piece != Piece::EMPTY);
+	halfmove_clock = resets_clock ? 0 : halfmove_clock + 1;
 
-// Find knight moves by defining a list of all the knight's move patterns, and testing for each.
-vector<Square> get_prospective_knight_moves(Square target, vector<vector<Square>> board, Colour opp_colour)
-{
-	vector<Square> prospective_moves;
-	vector<tuple<int, int>> knight_moves = { {-2, -1}, {-2, 1}, {2, -1}, {2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2} };
+	switch_pieces(this, { from_row, from_col }, { to_row, to_col });
 
-	for (int i = 0; i < knight_moves.size(); i++)
+	switch (move.flag())
 	{
-		if (is_knight_square_prospective(target, board, opp_colour, get<0>(knight_moves[i]), get<1>(knight_moves[i])))
+		case MoveFlag::CASTLING:
+			if (to_col == 2)
+				switch_pieces(this, { from_row, 0 }, { from_row, 3 });
+			else
+				switch_pieces(this, { from_row, 7 }, { from_row, 5 });
+			break;
+		case MoveFlag::PROMOTION:
 		{
-			Square test_square = board[target.row + get<0>(knight_moves[i])][target.col + get<1>(knight_moves[i])];
-			prospective_moves.push_back(test_square);
+			Square promoted_piece = board[to_row][to_col];
+			promoted_piece.piece = move.promotion();
+			set_square(to_row, to_col, promoted_piece);
+			break;
 		}
+		default:
+			break;
 	}
 
-	return prospective_moves;
+	// set_square() has already updated the key for the pieces, so only the castling rights, en passant file and side are left
+	key ^= ZOBRIST.castling[castling_rights];
+	castling_rights &= ~(get_castling_rights_lost(move.from()) | get_castling_rights_lost(move.to()));
+	key ^= ZOBRIST.castling[castling_rights];
+
+	if (ep_square != -1) key ^= ZOBRIST.ep_file[square_col(ep_square)];
+	ep_square = (move.flag() == MoveFlag::DOUBLE_PUSH) ? square_index((from_row + to_row) / 2, from_col) : -1;
+	if (ep_square != -1) key ^= ZOBRIST.ep_file[square_col(ep_square)];
+
+	active_player = (active_player == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	key ^= ZOBRIST.side;
+	move_no++;
+
+	move_cache.clear();
+
+	// in debug builds, check the incremental key, attack map and piece-square score against ones worked out from scratch
+	assert(key == compute_key());
+	assert(pawn_key == compute_pawn_key());
+	assert(attacks == compute_attacks());
+	assert(psqt == compute_psqt());
+	assert(accumulator.agrees_with(compute_accumulator(*this)));
+
+	return undo;
 }
 
 
-// detect validity of castling by looking for empty squares and unattacked squares between king and rook
-// the two checks are performed on different lists of squares, so must be handled separately
-bool can_castle(int target_row, Chessboard *chessboard, Colour opp_colour, vector<int> empty_cols, vector<int> unattacked_cols)
+// Take back a move made by do_move(), putting the moved pieces back and restoring any captured piece.
+// Moves must be undone in the reverse order they were made.
+void Chessboard::undo_move(const UndoInfo& undo)
 {
-	vector<vector<Square>> board = chessboard->board;
+	Move move = undo.move;
+	int from_row = square_row(move.from()), from_col = square_col(move.from());
+	int to_row = square_row(move.to()), to_col = square_col(move.to());
 
-	// iterate rows { 1, 2, 3 } for queenside, and { 5, 6 } for kingside
-	// check that squares inbetween the king and rook must be empty
-	for (int i = 0; i < empty_cols.size(); i++)
-	{
-		int column_under_test = empty_cols[i];
-		if (!(board[target_row][column_under_test].piece == Piece::EMPTY))
-			return false;
-	}
+	active_player = (active_player == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	move_no--;
+
+	Square moved_piece = board[to_row][to_col];
+	moved_piece.row = from_row;
+	moved_piece.col = from_col;
+	if (move.flag() == MoveFlag::PROMOTION) moved_piece.piece = Piece::PAWN;
+
+	set_square(to_row, to_col, Square(to_row, to_col));
+	set_square(from_row, from_col, moved_piece);
+
+	int captured_row = (move.flag() == MoveFlag::EN_PASSANT) ? from_row : to_row;
+	set_square(captured_row, to_col, undo.captured);
 
-	// iterate rows { 2, 3, 4 } for queenside, and { 4, 5, 6 } for kingside
-	// check that squares the king moves through cannot be attacked by the opponent, and the king cannot be in check
-	vector<Square> attacked_squares = parse_attackable_squares(chessboard->attacking_moves[opp_colour]);
-	for (int i = 0; i < unattacked_cols.size(); i++)
+	if (move.flag() == MoveFlag::CASTLING)
 	{
-		int column_under_test = unattacked_cols[i];
-		Square square_under_test = board[target_row][column_under_test];
-		if (count(attacked_squares.begin(), attacked_squares.end(), square_under_test) > 0)
-			return false;
+		int rook_from_col = (to_col == 2) ? 0 : 7, rook_to_col = (to_col == 2) ? 3 : 5;
+		Square rook = board[from_row][rook_to_col];
+		rook.col = rook_from_col;
+
+		set_square(from_row, rook_to_col, Square(from_row, rook_to_col));
+		set_square(from_row, rook_from_col, rook);
 	}
 
-	return true;
+	castling_rights = undo.castling_rights;
+	ep_square = undo.ep_square;
+	halfmove_clock = undo.halfmove_clock;
+	notation.resize(undo.notation_length);
+	key = undo.key;
+	move_cache.clear();
+
+	assert(key == compute_key());
+	assert(pawn_key == compute_pawn_key());
+	assert(attacks == compute_attacks());
+	assert(psqt == compute_psqt());
+	assert(accumulator.agrees_with(compute_accumulator(*this)));
 }
 
 
-// Look in the immediate 3x3 grid around the king and check for any empty or opponent-occupied squares.
-// Then check for castling opportunies
-vector<Square> get_prospective_king_moves(Square target, Chessboard chessboard, Colour opp_colour)
+// Pass the move to the other side without moving a piece, for null-move pruning in the search.
+// Only the side to move, the en passant square and the fifty-move count change. Must not be made while in check.
+UndoInfo Chessboard::do_null_move()
 {
-	vector<Square> prospective_moves;
-	//vector<Square> all_enemy_attacking_squares = parse_attackable_squares(find_all_attackable_squares(board, opp_colour, true));
-	vector<Square> all_enemy_attacking_squares = parse_attackable_squares(chessboard.attacking_moves[opp_colour]);
-	vector<vector<Square>> board = chessboard.board;
-
-	for (int i = -1; i <= 1; i++)
-	{
-		for (int j = -1; j <= 1; j++)
-		{
-			if ((target.row + i >= DIM_SIZE) || (target.row + i < 0) || (target.col + j >= DIM_SIZE) || (target.col + j < 0))
-				continue;
+	UndoInfo undo;
+	undo.move = Move();
+	undo.castling_rights = castling_rights;
+	undo.ep_square = ep_square;
+	undo.halfmove_clock = halfmove_clock;
+	undo.notation_length = notation.size();
+	undo.key = key;
 
-			Square test_square = board[target.row + i][target.col + j];
+	if (ep_square != -1) key ^= ZOBRIST.ep_file[square_col(ep_square)];
+	ep_square = -1;
+	halfmove_clock++;
 
-			// skip the king in question
-			if (test_square.piece == Piece::KING) continue;
+	active_player = (active_player == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	key ^= ZOBRIST.side;
+	move_no++;
 
-			// to prevent the king moving next to another king, look in the 3x3 radius around the prospective square for the opponent king
-			bool neighbours_opponent_king = false;
-			for (int k = -1; k <= 1; k++)
-			{
-				for (int l = -1; l <= 1; l++)
-				{
-					int test_row = target.row + i + k;
-					int test_col = target.col + j + l;
-					if ((test_row >= DIM_SIZE) || (test_row < 0) || (test_col >= DIM_SIZE) || (test_col < 0))
-						continue;
-
-					if (board[test_row][test_col].piece == Piece::KING && board[test_row][test_col].colour == opp_colour)
-						neighbours_opponent_king = true;
-				}
-			}
-			if (neighbours_opponent_king) continue;
+	move_cache.clear();
+	assert(key == compute_key());
 
-			// the king cannot move into an attacked square
-			if (count(all_enemy_attacking_squares.begin(), all_enemy_attacking_squares.end(), test_square) > 0) continue;
+	return undo;
+}
 
-			if (test_square.colour == Colour::EMPTY || test_square.colour == opp_colour) prospective_moves.push_back(test_square);
-		}
-	}
 
-	
-	// handling castling
-	if (!target.has_moved && target.col == 4)
-	{
-		// queenside O-O-O
-		if (!board[target.row][0].has_moved && board[target.row][0].piece == Piece::ROOK)
-		{
-			bool can_queenside_castle = can_castle(target.row, &chessboard, opp_colour, vector<int>({1, 2, 3}), vector<int>({ 2, 3, 4 }));
-			if (can_queenside_castle)
-				prospective_moves.push_back(board[target.row][2]);
-		}
+// Take back a null move made by do_null_move().
+void Chessboard::undo_null_move(const UndoInfo& undo)
+{
+	active_player = (active_player == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	move_no--;
+	ep_square = undo.ep_square;
+	halfmove_clock = undo.halfmove_clock;
+	key = undo.key;
+	move_cache.clear();
+}
 
-		// kingside O-O
-		if (!board[target.row][7].has_moved && board[target.row][0].piece == Piece::ROOK)
-		{
-			bool can_kingside_castle = can_castle(target.row, &chessboard, opp_colour, vector<int>({5, 6}), vector<int>({4, 5, 6}));
-			if (can_kingside_castle)
-				prospective_moves.push_back(board[target.row][6]);
-		}
-	}
-	
 
-	return prospective_moves;
+// For a given piece, find all the squares that piece can move to.
+// Doesn't include illegal moves, moves that would put the king in check, etc.
+// Includes special moves i.e. castling, en passant.
+// The moves come from the board's move cache, so asking again for the same piece costs nothing.
+MoveList Chessboard::find_valid_moves(Square target)
+{
+	MoveList moves;
+	add_moves(*this, target, cached_piece_moves(square_index(target.row, target.col)), &moves, false);
+	return moves;
 }
 
 
-// Create a deep copy clone of an input chessboard
-vector<vector<Square>> deep_clone_board(vector<vector<Square>> original)
+// Initialise a chessboard from a text file.
+// The piece map defines how the text file should be structured, with uppercase for white pieces and lowercase for black.
+Chessboard::Chessboard(string filename)
 {
-	vector<Square> row(DIM_SIZE);
-	vector<vector<Square>> copy(DIM_SIZE, row);
+	// a missing or short file leaves the rest of the board empty, so a board can always be made before a position is loaded into it
+	string setup_position = read_board_setup_file(filename);
+	setup_position.resize(DIM_SIZE * DIM_SIZE, '_');
 
-	for (int row = 0; row < DIM_SIZE; row++)
+	active_player = Colour::WHITE;
+	move_no = 1;
+	ep_square = -1;
+	halfmove_clock = 0;
+
+	for (int i = 0; i < DIM_SIZE; i++)
 	{
-		for (int col = 0; col < DIM_SIZE; col++)
+		for (int j = 0; j < DIM_SIZE; j++)
 		{
-			copy[row][col].col = original[row][col].col;
-			copy[row][col].row = original[row][col].row;
-			copy[row][col].has_moved = original[row][col].has_moved;
-			copy[row][col].piece = original[row][col].piece;
-			copy[row][col].colour = original[row][col].colour;
+			Piece p = get<0>(piece_map.at(setup_position[((DIM_SIZE - (i + 1)) * DIM_SIZE) + j]));
+			Colour c = get<1>(piece_map.at(setup_position[((DIM_SIZE - (i + 1)) * DIM_SIZE) + j]));
+			board[i][j] = Square(p, c, i, j);
+			if (p != Piece::EMPTY) bitboards.add(c, p, square_index(i, j));
 		}
 	}
 
-	return copy;
-}
-
-
-// Treat the king like a queen and find all the pieces it can see
-// If any of those pieces is a piece that could attack the king, it is under attack
-bool is_king_attacked(Square king, vector<vector<Square>> board, Colour opp_colour)
-{
-	vector<Square> raycast_king_moves_orthogonal = get_prospective_rook_moves(king, board, opp_colour);
-	for (int i = 0; i < raycast_king_moves_orthogonal.size(); i++)
+	// every piece starts unmoved, so a side can castle wherever its king and rook stand on their starting squares
+	castling_rights = 0;
+	if (board[0][4].piece == Piece::KING && board[0][4].colour == Colour::WHITE)
 	{
-		if (raycast_king_moves_orthogonal[i].piece == Piece::ROOK ||
-			raycast_king_moves_orthogonal[i].piece == Piece::QUEEN)
-			return true;
+		if (board[0][7].piece == Piece::ROOK && board[0][7].colour == Colour::WHITE) castling_rights |= WHITE_OO;
+		if (board[0][0].piece == Piece::ROOK && board[0][0].colour == Colour::WHITE) castling_rights |= WHITE_OOO;
 	}
-
-	vector<Square> raycast_king_moves_diagonal = get_prospective_bishop_moves(king, board, opp_colour);
-	for (int i = 0; i < raycast_king_moves_diagonal.size(); i++)
+	if (board[7][4].piece == Piece::KING && board[7][4].colour == Colour::BLACK)
 	{
-		if (raycast_king_moves_diagonal[i].piece == Piece::BISHOP ||
-			raycast_king_moves_diagonal[i].piece == Piece::QUEEN)
-			return true;
+		if (board[7][7].piece == Piece::ROOK && board[7][7].colour == Colour::BLACK) castling_rights |= BLACK_OO;
+		if (board[7][0].piece == Piece::ROOK && board[7][0].colour == Colour::BLACK) castling_rights |= BLACK_OOO;
 	}
 
-	return false;
+	key = compute_key();
+	pawn_key = compute_pawn_key();
+	attacks = compute_attacks();
+	psqt = compute_psqt();
+	accumulator = Accumulator();
 }
 
 
-// Take the prospective moves and identify which ones can be made.
-// Prospective moves cannot be made if making the move would open up the king to being captured by another piece
-vector<Square> trim_valid_moves(Square target, vector<vector<Square>> board, Colour opp_colour, vector<Square> prospective_moves)
+// Set up the board from a position in Forsyth-Edwards Notation (FEN), such as the starting position:
+//	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+// The fields after the piece placement can be left out. Returns false and leaves the board alone if the FEN can't be read.
+bool Chessboard::load_fen(string fen)
 {
-	vector<Square> confirmed_moves;
-	// catch for the case where no prospective moves can be made
-	if (prospective_moves.size() == 0) return confirmed_moves;
+	istringstream fields(fen);
+	string placement, side = "w", castling = "-", ep = "-";
+	int halfmove_no = 0, fullmove_no = 1;
+	fields >> placement >> side >> castling >> ep >> halfmove_no >> fullmove_no;
 
-	for (int i = 0; i < prospective_moves.size(); i++)
+	// read the piece placement from rank 8 down to rank 1 into a setup string like the position files use
+	string setup_position(DIM_SIZE * DIM_SIZE, '_');
+	int row = DIM_SIZE - 1, col = 0;
+	for (char c : placement)
 	{
-		vector<vector<Square>> test_board = deep_clone_board(board);
-		Square prosp_move = prospective_moves[i];
+		if (c == '/')
+		{
+			if (col != DIM_SIZE || row == 0) return false;
+			row--;
+			col = 0;
+		}
+		else if (c >= '1' && c <= '8')
+			col += c - '0';
+		else if (piece_map.count(c) > 0 && c != '_' && col < DIM_SIZE)
+			setup_position[((DIM_SIZE - (row + 1)) * DIM_SIZE) + col++] = c;
+		else
+			return false;
 
-		// make the prospective move on the test board
-		test_board[prosp_move.row][prosp_move.col].piece = test_board[target.row][target.col].piece;
-		test_board[prosp_move.row][prosp_move.col].colour = test_board[target.row][target.col].colour;
-		test_board[prosp_move.row][prosp_move.col].has_moved = true;
-		test_board[prosp_move.row][prosp_move.col].when_moved = test_board[target.row][target.col].when_moved;
+		if (col > DIM_SIZE) return false;
+	}
+	if (row != 0 || col != DIM_SIZE) return false;
+	if (side != "w" && side != "b") return false;
+	if (ep != "-" && (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || (ep[1] != '3' && ep[1] != '6'))) return false;
 
-		test_board[target.row][target.col] = Square(target.row, target.col);
+	bitboards = Bitboards();
+	notation = "";
+	active_player = (side == "w") ? Colour::WHITE : Colour::BLACK;
+	move_no = (2 * (max(fullmove_no, 1) - 1)) + 1 + ((active_player == Colour::BLACK) ? 1 : 0);
 
-		// now, trace rays from the white king in each horizontal, vertical and diagonal direction.
-		// if we find a queen, rook or bishop then we are putting the king into check and the move is rejected
-		for (int row = 0; row < DIM_SIZE; row++)
+	for (int i = 0; i < DIM_SIZE; i++)
+	{
+		for (int j = 0; j < DIM_SIZE; j++)
 		{
-			for (int col = 0; col < DIM_SIZE; col++)
-			{
-				if (test_board[row][col].piece == Piece::KING && test_board[row][col].colour == target.colour)
-				{
-					Square king = test_board[row][col];
-					if (!is_king_attacked(king, test_board, opp_colour))
-					{
-						vector<Square> king_knight_moves = get_prospective_knight_moves(king, test_board, opp_colour);
-						bool king_attacked_by_knight = false;
-						for (int i = 0; i < king_knight_moves.size(); i++)
-						{
-							if (king_knight_moves[i].piece == Piece::KNIGHT) king_attacked_by_knight = true;
-						}
-						if (!king_attacked_by_knight) confirmed_moves.push_back(prosp_move);
-					}
-						
-				}
-			}
+			Piece p = get<0>(piece_map.at(setup_position[((DIM_SIZE - (i + 1)) * DIM_SIZE) + j]));
+			Colour c = get<1>(piece_map.at(setup_position[((DIM_SIZE - (i + 1)) * DIM_SIZE) + j]));
+			board[i][j] = Square(p, c, i, j);
+			if (p != Piece::EMPTY) bitboards.add(c, p, square_index(i, j));
 		}
 	}
 
-	return confirmed_moves;
+	// only keep castling rights where the king and rook are still on their starting squares
+	map<char, tuple<int, int, int>> castling_map = {
+		{ 'K', { WHITE_OO,  0, 7 } },
+		{ 'Q', { WHITE_OOO, 0, 0 } },
+		{ 'k', { BLACK_OO,  7, 7 } },
+		{ 'q', { BLACK_OOO, 7, 0 } }
+	};
+	castling_rights = 0;
+	for (char c : castling)
+	{
+		if (castling_map.count(c) == 0) continue;
+		auto [right, back_row, rook_col] = castling_map[c];
+		Colour colour = (back_row == 0) ? Colour::WHITE : Colour::BLACK;
+		if (board[back_row][4].piece == Piece::KING && board[back_row][4].colour == colour
+			&& board[back_row][rook_col].piece == Piece::ROOK && board[back_row][rook_col].colour == colour)
+			castling_rights |= right;
+	}
+
+	// the pawn that can be captured en passant moved two squares on the last move
+	ep_square = -1;
+	if (ep != "-")
+	{
+		int ep_row = ep[1] - '1', ep_col = ep[0] - 'a';
+		int pawn_row = (ep_row == 2) ? 3 : 4;
+		Square pawn = board[pawn_row][ep_col];
+		if (pawn.piece == Piece::PAWN && pawn.colour == ((ep_row == 2) ? Colour::WHITE : Colour::BLACK))
+			ep_square = square_index(ep_row, ep_col);
+	}
+	halfmove_clock = max(halfmove_no, 0);
+
+	key = compute_key();
+	pawn_key = compute_pawn_key();
+	attacks = compute_attacks();
+	psqt = compute_psqt();
+	accumulator = Accumulator();
+	move_cache.clear();
+	return true;
 }
 
-// For a given square, find all the moves that piece can move to
-vector<Square> LogicEngine::get_valid_square_moves(Square target, Chessboard chessboard, Colour opp_colour)
+
+// Place a square on the board, keeping the bitboards, attack map, Zobrist keys, piece-square score and network accumulator in step with the piece that now stands there.
+// Anything that edits the board outside of moving pieces should go through here.
+void Chessboard::set_square(int row, int col, Square square)
 {
-	vector<Square> prospective_moves;
-	vector<vector<Square>> board = chessboard.board;
+	int sq = square_index(row, col);
+	Square current = board[row][col];
+	bool was_occupied = current.piece != Piece::EMPTY && current.colour != Colour::EMPTY;
+	bool is_occupied = square.piece != Piece::EMPTY && square.colour != Colour::EMPTY;
 
-	switch (target.piece)
+	// sliders looking at the square see further or less far once it empties or fills, so their attacks change too.
+	// These are found before the board changes, but the same sliders see the square either way.
+	Bitboard sliders = 0;
+	if (was_occupied != is_occupied)
 	{
-	case Piece::EMPTY:
-		break;
-	case Piece::PAWN:
-		prospective_moves = get_prospective_pawn_moves(target, board, opp_colour, chessboard.move_no);
-		break;
-	case Piece::ROOK:
-		prospective_moves = get_prospective_rook_moves(target, board, opp_colour);
-		break;
-	case Piece::BISHOP:
-		prospective_moves = get_prospective_bishop_moves(target, board, opp_colour);
-		break;
-	case Piece::QUEEN:
-		prospective_moves = get_prospective_queen_moves(target, board, opp_colour);
-		break;
-	case Piece::KNIGHT:
-		prospective_moves = get_prospective_knight_moves(target, board, opp_colour);
-		break;
-	case Piece::KING:
-		prospective_moves = get_prospective_king_moves(target, chessboard, opp_colour);
-		break;
+		Bitboard occupied = bitboards.all();
+		Bitboard queens = bitboards.of(Colour::WHITE, Piece::QUEEN) | bitboards.of(Colour::BLACK, Piece::QUEEN);
+		sliders = (rook_attacks(sq, occupied) & (bitboards.of(Colour::WHITE, Piece::ROOK) | bitboards.of(Colour::BLACK, Piece::ROOK) | queens))
+			| (bishop_attacks(sq, occupied) & (bitboards.of(Colour::WHITE, Piece::BISHOP) | bitboards.of(Colour::BLACK, Piece::BISHOP) | queens));
 	}
 
-	// take the list of prospective moves and reduce it to only valid ones
-	vector<Square> confirmed_moves = trim_valid_moves(target, chessboard.board, opp_colour, prospective_moves);
-	return confirmed_moves;
-}
-
+	if (was_occupied)
+	{
+		bitboards.remove(current.colour, current.piece, sq);
+		attacks.set(current.colour, sq, 0);
+		key ^= ZOBRIST.pieces[(int)current.colour][(int)current.piece - 1][sq];
+		if (current.piece == Piece::PAWN) pawn_key ^= ZOBRIST.pieces[(int)current.colour][(int)current.piece - 1][sq];
+		psqt.remove((int)current.colour, (int)current.piece - 1, sq);
+		accumulator.remove((int)current.colour, (int)current.piece - 1, sq);
+	}
+	if (is_occupied)
+	{
+		bitboards.add(square.colour, square.piece, sq);
+		attacks.set(square.colour, sq, get_piece_attacks(square.piece, square.colour, sq, bitboards.all()));
+		key ^= ZOBRIST.pieces[(int)square.colour][(int)square.piece - 1][sq];
+		if (square.piece == Piece::PAWN) pawn_key ^= ZOBRIST.pieces[(int)square.colour][(int)square.piece - 1][sq];
+		psqt.add((int)square.colour, (int)square.piece - 1, sq);
+		accumulator.add((int)square.colour, (int)square.piece - 1, sq);
+	}
 
-// Go through the board and compile a list of all the squares a player is currently targeting
-vector<tuple<Square, vector<Square>>> LogicEngine::find_all_attackable_squares(Chessboard chessboard, Colour colour, Piece_Finding_Mode mode)
-{
-	vector<tuple<Square, vector<Square>>> all_attackable_squares;
-	Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
-	vector<vector<Square>> board = chessboard.board;
+	board[row][col] = square;
+	move_cache.clear();
 
-	for (int row = 0; row < DIM_SIZE; row++)
+	while (sliders)
 	{
-		for (int col = 0; col < DIM_SIZE; col++)
-		{
-			if (board[row][col].colour == colour)
-			{
-				tuple<Square, vector<Square>> confirmed_piece_moves;
-				switch (mode)
-				{
-					// find all the valid moves
-					case Piece_Finding_Mode::VALID:
-						confirmed_piece_moves = { board[row][col], get_valid_square_moves(board[row][col], chessboard, opp_colour) };
-						all_attackable_squares.push_back(confirmed_piece_moves);
-						break;
-
-					// find all the attacking moves. this only excludes pawns moving forward, which are not squares attacked by the pawn
-					case Piece_Finding_Mode::ATTACKABLE:
-						int dir = (board[row][col].colour == Colour::WHITE) ? 1 : -1;
-						switch (board[row][col].piece)
-						{
-							// Pawns are handled separately since they cannot attack the same squares they can move to.
-							case Piece::PAWN:
-								confirmed_piece_moves = { board[row][col], get_pawn_attacking_squares(board[row][col], board, opp_colour, dir) };
-								all_attackable_squares.push_back(confirmed_piece_moves);
-								break;
-							// For other pieces: we find their moves and add them to the list.
-							default:
-								confirmed_piece_moves = { board[row][col], get_valid_square_moves(board[row][col], chessboard, opp_colour) };
-								all_attackable_squares.push_back(confirmed_piece_moves);
-								break;
-						}
-						break;
-				}
-			}
-		}
+		int slider_sq = pop_lsb(&sliders);
+		Square slider = board[square_row(slider_sq)][square_col(slider_sq)];
+		attacks.set(slider.colour, slider_sq, get_piece_attacks(slider.piece, slider.colour, slider_sq, bitboards.all()));
 	}
-
-	return all_attackable_squares;
 }
 
 
-// Test for checkmate and stalemate.
-// We look at every possible move a checked player can make.
-// If the list is empty, the player is checkmated.
-// If the player is not in check, the game ends in stalemate.
-bool test_for_checkmate_stalemate(Chessboard* cb, Colour player, Colour opp_colour)
+// Set the side to move, keeping the Zobrist key in step.
+void Chessboard::set_active_player(Colour colour)
 {
-	vector<Square> potential_moves = parse_attackable_squares((*cb).valid_moves[player]);
-	return potential_moves.size() == 0;
+	if (colour != active_player) key ^= ZOBRIST.side;
+	active_player = colour;
 }
 
 
-// handles the logic of moving one square into another, and replacing the moved square with an empty square
-void LogicEngine::switch_pieces(Chessboard *cb, vector<int> target_position, vector<int> destination_position)
+// Work out the Zobrist key of the position from scratch.
+// The key is normally updated as moves are made, so this is for setting up a board and for checking the updates.
+Key Chessboard::compute_key() const
 {
-	cb->board[destination_position[0]][destination_position[1]].piece = cb->board[target_position[0]][target_position[1]].piece;
-	cb->board[destination_position[0]][destination_position[1]].colour = cb->board[target_position[0]][target_position[1]].colour;
-	cb->board[destination_position[0]][destination_position[1]].has_moved = true;
+	Key result = 0;
+	for (int c = 0; c < 2; c++)
+	{
+		for (int p = 0; p < 6; p++)
+		{
+			Bitboard pieces = bitboards.pieces[c][p];
+			while (pieces) result ^= ZOBRIST.pieces[c][p][pop_lsb(&pieces)];
+		}
+	}
 
-	cb->board[destination_position[0]][destination_position[1]].when_moved = cb->board[target_position[0]][target_position[1]].when_moved;
-	cb->board[destination_position[0]][destination_position[1]].when_moved.push_back(cb->move_no);
+	result ^= ZOBRIST.castling[castling_rights];
+	if (ep_square != -1) result ^= ZOBRIST.ep_file[square_col(ep_square)];
+	if (active_player == Colour::BLACK) result ^= ZOBRIST.side;
 
-	cb->board[target_position[0]][target_position[1]] = Square(target_position[0], target_position[1]);
+	return result;
 }
 
 
-// For a given piece that could move to the destination square, look through the squares it could move to and see if any of them match the destination square.
-bool LogicEngine::is_dest_square_attackable_by_piece(tuple<Square, vector<Square>> potential_mover, vector<int> dest_position)
+// Work out the pawn key from scratch: the Zobrist numbers for each pawn on its square, and nothing else.
+Key Chessboard::compute_pawn_key() const
 {
-	vector<Square> potential_mover_destinations = get<1>(potential_mover);
-	for (int j = 0; j < potential_mover_destinations.size(); j++)
+	Key result = 0;
+	for (int c = 0; c < 2; c++)
 	{
-		Square test_piece_dest = potential_mover_destinations[j];
-		if (test_piece_dest.col == dest_position[1] && test_piece_dest.row == dest_position[0])
-			return true;
+		Bitboard pawns = bitboards.pieces[c][(int)Piece::PAWN - 1];
+		while (pawns) result ^= ZOBRIST.pieces[c][(int)Piece::PAWN - 1][pop_lsb(&pawns)];
 	}
 
-	return false;
+	return result;
 }
 
 
-// Reference the piece notation map
-string get_piece_notation_map(Piece p)
+// Build the attack map from scratch, for setting up a board and for checking the updates made as pieces move.
+AttackMap Chessboard::compute_attacks() const
 {
-	map<Piece, string> piece_notation_map = {
-		{ Piece::EMPTY,  " " },
-		{ Piece::PAWN,   ""  },
-		{ Piece::ROOK,   "R" },
-		{ Piece::KNIGHT, "N" },
-		{ Piece::BISHOP, "B" },
-		{ Piece::QUEEN,  "Q" },
-		{ Piece::KING,   "K" }
-	};
+	AttackMap result;
+	Bitboard occupied = bitboards.all();
+	Bitboard pieces = occupied;
+	while (pieces)
+	{
+		int sq = pop_lsb(&pieces);
+		Square square = board[square_row(sq)][square_col(sq)];
+		result.set(square.colour, sq, get_piece_attacks(square.piece, square.colour, sq, occupied));
+	}
 
-	return piece_notation_map[p];
+	return result;
 }
 
 
-// Build the notation for the ply, e.g. "Nbxd2"
-string get_ply_notation(Chessboard* cb, vector<int> target_position, vector<int> destination_position, bool is_capture)
+// Add up the piece-square score of the position from scratch, for setting up a board and for checking the updates made as pieces move.
+PsqtScore Chessboard::compute_psqt() const
 {
-	string result_notation = "";
-
-	// First get the section of the string for the moved piece
-	Square moved_piece = cb->board[destination_position[0]][destination_position[1]];
-	result_notation += get_piece_notation_map(moved_piece.piece);
-
-	// If multiple pieces could move to that location, we need to show more details about which one moved there.
-	// In the case of pawns, we want the attacking moves if a piece was captured, but the valid moves if not.
-	// This is because a pawn moving forward should only have one option- directly in front. En passant does not affect this as it still involves capturing.
-	vector<tuple<Square, vector<Square>>> potential_movers = ( is_capture ? cb->attacking_moves[cb->active_player] : cb->valid_moves[cb->active_player] );
-	bool candidate_on_row = false;
-	bool candidate_on_col = false;
-
-	for (int i = 0; i < potential_movers.size(); i++)
+	PsqtScore result;
+	for (int c = 0; c < 2; c++)
 	{
-		Square potential_mover = get<0>(potential_movers[i]);
-
-		// Don't inspect the same piece that we're moving
-		if ((potential_mover.piece == moved_piece.piece)
-			&& (potential_mover.row == target_position[0])
-			&& (potential_mover.col == target_position[1]))
-			continue;
-		// We only care about pieces of the same type that could land in that square
-		if (potential_mover.piece != moved_piece.piece) continue;
-		
-		// Look to see if the piece is on the same rank or file as the piece that moved.
-		if (potential_mover.row == target_position[0])
-		{
-			if (is_dest_square_attackable_by_piece(potential_movers[i], destination_position))
-				candidate_on_row = true;
-		}
-		if (potential_mover.col == target_position[1])
+		for (int p = 0; p < 6; p++)
 		{
-			if (is_dest_square_attackable_by_piece(potential_movers[i], destination_position))
-				candidate_on_col = true;
+			Bitboard pieces = bitboards.pieces[c][p];
+			while (pieces) result.add(c, p, pop_lsb(&pieces));
 		}
-
-		// For knights, this isn't necessarily true and we must perform more tests to dig a level deeper.
-		// So, for the potential mover, go straight to the is_dest_square_attackable_by_piece() function.
-		// NOTE there is a bug here where a player with 3 knights can get incorrect notation. but who cares
-		if (potential_mover.piece == Piece::KNIGHT && !candidate_on_col)
-		{
-			if (is_dest_square_attackable_by_piece(potential_movers[i], destination_position))
-				candidate_on_row = true;
-		}
-
-		// If the piece is a pawn and theres a capture we must always include the file.
-		if (is_capture && moved_piece.piece == Piece::PAWN && !candidate_on_col)
-			candidate_on_row = true;
 	}
 
-	if (candidate_on_row) result_notation += convert_int_to_chessboard_square(target_position[1], target_position[0])[0];
-	if (candidate_on_col) result_notation += convert_int_to_chessboard_square(target_position[1], target_position[0])[1];
-	
-	
-	// If a piece was captured, we need to represent a capture
-	if (is_capture) result_notation += "x";
-
-	// Then append the coordinates of the landing square
-	result_notation += convert_int_to_chessboard_square(destination_position[1], destination_position[0]);
-
-	return result_notation;
+	return result;
 }
 
 
-// Go through the move making procedure. Assume from prior checks that the move is valid.
-// 1. Make the move, storing the details of the moved piece and destination square
-// 2. Look for check, checkmate and stalemate.
-// 3. Build the PGN string for the move.
-// 4. Update the active player's turn
-// 5. Return a gamestate depending on the state of the game
-Gamestate LogicEngine::make_move(Chessboard* cb, vector<Square> valid_piece_moves, vector<int> target_position, vector<int> destination_position)
+// The valid moves of every piece of a colour, worked out from the board when asked for.
+MoveList Chessboard::valid_moves(Colour colour) const
 {
-	Colour colour = cb->board[target_position[0]][target_position[1]].colour;
-	Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
-	Square destination_piece = cb->board[destination_position[0]][destination_position[1]];
-	string ply_notation = "";
-
-	Gamestate gamestate = Gamestate::NORMAL;
-
-	// 1. Make the move
-	for (int i = 0; i < valid_piece_moves.size(); i++)
-	{
-		if (valid_piece_moves[i].row == destination_position[0] && valid_piece_moves[i].col == destination_position[1])
-		{
-			// move the piece
-			bool is_capture = (cb->board[destination_position[0]][destination_position[1]].piece == Piece::EMPTY) ? false : true;
-
-			switch_pieces(cb, target_position, destination_position);
-			ply_notation = get_ply_notation(cb, target_position, destination_position, is_capture);
-			break;
-		}
-	}
+	return find_all_attackable_squares(*this, colour, Piece_Finding_Mode::VALID);
+}
 
-	Square moved_piece = cb->board[destination_position[0]][destination_position[1]];
-	switch (moved_piece.piece)
-	{
-		case Piece::KING:
-			// check to see if we castled; if so, then the rook needs to be moved too.
-			// Queenside
-			if (target_position[1] == 4 && destination_position[1] == 2)
-			{
-				switch_pieces(cb, vector<int>({ target_position[0], 0 }), vector<int>({ target_position[0], 3 }));
-				ply_notation = "O-O-O";
-			}
-			// Kingside
-			else if (target_position[1] == 4 && destination_position[1] == 6)
-			{
-				switch_pieces(cb, vector<int>({ target_position[0], 7 }), vector<int>({ target_position[0], 5 }));
-				ply_notation = "O-O";
-			}
-			break;
-		case Piece::PAWN:
-			// check to see if we captured via en passant; if so, remove the captured pawn
-			if (destination_piece.piece == Piece::EMPTY && destination_piece.col != target_position[1])
-			{
-				cb->board[target_position[0]][destination_position[1]] = Square(target_position[0], destination_position[1]);
-				ply_notation += "ep";
-			}
-			break;
-	}
-	
-	// If the moved piece is a pawn moving to the opposite back rank, we must intercept for promotion.
-	if (moved_piece.piece == Piece::PAWN && moved_piece.row == (moved_piece.colour == Colour::WHITE ? 7 : 0))
-	{
-		Piece promotion_choice = get_pawn_promotion_terminal();
-		cb->board[destination_position[0]][destination_position[1]].piece = promotion_choice;
-		ply_notation += get_piece_notation_map(promotion_choice);
-	}
 
-	// Find the valid and attacking move lists for each player
-	// Attacking moves do not include the squares that pawns can move to, as they are not attacking these squares.
-	// We store these two lists separately so that we can use the valid moves list to find squares to move to,
-	//	and the attacking moves list to search for stalemate and checkmate conditions.
-	// Both 'lists' are actually stored as a map with colour keys and a vector of tuples for values,
-	//	where the tuples contain the coloured piece and a vector of the squares that piece can move to or attack.
-	// i.e.: std::map<Colour, std::vector<std::tuple<Square, std::vector<Square>>>>
-	(*cb).valid_moves[Colour::WHITE] = find_all_attackable_squares(*cb, Colour::WHITE, Piece_Finding_Mode::VALID);
-	(*cb).valid_moves[Colour::BLACK] = find_all_attackable_squares(*cb, Colour::BLACK, Piece_Finding_Mode::VALID);
+// The captures every piece of a colour can make, worked out from the attack map when asked for.
+MoveList Chessboard::attacking_moves(Colour colour) const
+{
+	return find_all_attackable_squares(*this, colour, Piece_Finding_Mode::ATTACKABLE);
+}
 
-	(*cb).attacking_moves[Colour::WHITE] = find_all_attackable_squares(*cb, Colour::WHITE, Piece_Finding_Mode::ATTACKABLE);
-	(*cb).attacking_moves[Colour::BLACK] = find_all_attackable_squares(*cb, Colour::BLACK, Piece_Finding_Mode::ATTACKABLE);
 
-	// 2. Look for check, checkmate and stalemate
-	vector<Square> attackable_squares = parse_attackable_squares((*cb).attacking_moves[colour]);
-	bool is_check = false;
-	for (int i = 0; i < attackable_squares.size(); i++)
-	{
-		if (attackable_squares[i].piece == Piece::KING)
-		{
-			// The opponent king is in check.
-			// We already restrict the player's moves once in check to those that escape check.
-			// We must however look for checkmate.
-			is_check = true;
-			gamestate = Gamestate::CHECK;
-			bool is_checkmate = test_for_checkmate_stalemate(cb, opp_colour, colour);
-			ply_notation += (is_checkmate ? "#" : "+");
-			if (is_checkmate) gamestate = Gamestate::CHECKMATE;
-		}
-	}
-	if (!is_check)
-	{
-		bool is_stalemate = test_for_checkmate_stalemate(cb, opp_colour, colour);
-		if (is_stalemate) gamestate = Gamestate::STALEMATE;
-	}
+// Look for any legal move for a colour, stopping at the first piece that has one.
+// The king is tried first, as when in check it is the piece most likely to have a move.
+bool Chessboard::has_any_legal_move(Colour colour) const
+{
+	Bitboard king = bitboards.of(colour, Piece::KING);
+	if (king && cached_piece_moves(lsb(king))) return true;
 
-	// 3. Add the ply notation to the game's notation
-	string full_ply_notation = "";
-	if (cb->active_player == Colour::WHITE)
-	{
-		full_ply_notation += to_string((cb->move_no + 1) / 2);
-		full_ply_notation += ".";
-		full_ply_notation += ply_notation;
-	}
-	else
+	Bitboard pieces = bitboards.occupancy[(int)colour] & ~king;
+	while (pieces)
 	{
-		full_ply_notation += " ";
-		full_ply_notation += ply_notation;
-		full_ply_notation += " ";
+		if (cached_piece_moves(pop_lsb(&pieces))) return true;
 	}
-	cb->notation += full_ply_notation;
-
-	// 4. At the end of the move, the active player colour is switched.
-	cb->active_player = opp_colour;
 
-	// 5. Increment the move counter.
-	cb->move_no++;
-
-	
-	return gamestate;
+	return false;
 }
 
 
-// For a given piece, find all the squares that piece can move to.
-// Doesn't include illegal moves, moves that would put the king in check, etc.
-// Includes special moves i.e. castling, en passant.
-vector<Square> Chessboard::find_valid_moves(Square target)
+// The checks, pins and attacked squares around a colour's king, worked out the first time they are asked for in a position.
+const KingSafety& Chessboard::cached_king_safety(Colour colour) const
 {
-	vector<Square> prospective_moves;
-	vector<vector<Square>> board = this->board;
-	Colour opp_colour = (target.colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	if (!move_cache.king_safety_ready[(int)colour])
+	{
+		move_cache.king_safety[(int)colour] = get_king_safety(*this, colour);
+		move_cache.king_safety_ready[(int)colour] = true;
+	}
 
-	vector<Square> confirmed_moves = get_valid_square_moves(target, *this, opp_colour);
-	return confirmed_moves;
+	return move_cache.king_safety[(int)colour];
 }
 
 
-// Initialise a chessboard from a text file.
-// The piece map defines how the text file should be structured, with uppercase for white pieces and lowercase for black.
-Chessboard::Chessboard(string filename)
+// The squares the piece on a square can legally move to, worked out the first time they are asked for in a position.
+Bitboard Chessboard::cached_piece_moves(int sq) const
 {
-	string setup_position = read_board_setup_file(filename);
-
-	vector<Square> row(DIM_SIZE);
-	vector<vector<Square>> b(DIM_SIZE, row);
-	active_player = Colour::WHITE;
-	move_no = 1;
-
-	board = b;
-
-	for (int i = 0; i < DIM_SIZE; i++)
+	if (!(move_cache.ready & square_bb(sq)))
 	{
-		for (int j = 0; j < DIM_SIZE; j++)
-		{
-			Piece p = get<0>(piece_map[setup_position[((DIM_SIZE - (i + 1)) * DIM_SIZE) + j]]);
-			Colour c = get<1>(piece_map[setup_position[((DIM_SIZE - (i + 1)) * DIM_SIZE) + j]]);
-			board[i][j] = Square(p, c, i, j, false, vector<int>());
-		}
+		Square target = board[square_row(sq)][square_col(sq)];
+		move_cache.destinations[sq] = (target.colour == Colour::EMPTY) ? 0 : get_legal_moves(*this, cached_king_safety(target.colour), target);
+		move_cache.ready |= square_bb(sq);
 	}
+
+	return move_cache.destinations[sq];
 }
 
 
@@ -943,13 +908,13 @@ void handle_gamestate(Chessboard *cb, Gamestate gs, string *winner)
 			cb->result = (cb->active_player == Colour::WHITE) ? "0-1" : "1-0";
 			debug_print(Level::INFO, { "\x1B[2J\x1B[H" });
 			debug_print(Level::INFO, {"\033[1;33mThe king is checkmated! Game over. ", *winner, " wins!\033[0m\n"});
-			print_board(*cb, vector<Square>(), gs);
+			print_board(*cb, MoveList(), gs);
 			return;
 		case Gamestate::STALEMATE:
 			cb->result = "1/2-1/2";
 			debug_print(Level::INFO, { "\x1B[2J\x1B[H" });
 			debug_print(Level::INFO, {"\033[1;33mIts a stalemate! Game ends in a tie.\033[0m\n"});
-			print_board(*cb, vector<Square>(), gs);
+			print_board(*cb, MoveList(), gs);
 			return;
 	}
 }
@@ -973,28 +938,14 @@ bool handle_game_end(Chessboard cb, Gamestate gs)
 }
 
 
-// Find the valid move lists for each player
-void LogicEngine::get_valid_and_attacking_moves(Chessboard *chessboard)
-{
-	chessboard->valid_moves[Colour::WHITE] =
-		find_all_attackable_squares(*chessboard, Colour::WHITE, Piece_Finding_Mode::VALID);
-	chessboard->valid_moves[Colour::BLACK] =
-		find_all_attackable_squares(*chessboard, Colour::BLACK, Piece_Finding_Mode::VALID);
-
-	chessboard->attacking_moves[Colour::WHITE] =
-		find_all_attackable_squares(*chessboard, Colour::WHITE, Piece_Finding_Mode::ATTACKABLE);
-	chessboard->attacking_moves[Colour::BLACK] =
-		find_all_attackable_squares(*chessboard, Colour::BLACK, Piece_Finding_Mode::ATTACKABLE);
-}
-
-
 // Main game loop
 void LogicEngine::loop_board(Chessboard cb, Gamestate gs)
 {
-	stack<Chessboard> board_stack;
-	board_stack.push(cb);
+	// Each move made pushes a record of how to take it back, so 'undo' can step backwards without copying the board.
+	stack<UndoInfo> undo_stack;
 
-	get_valid_and_attacking_moves(&cb);
+	// Once turned on, the position is analysed in the background for as long as the player takes over their move.
+	BackgroundAnalysis analysis;
 
 	print_game_load_header((cb.active_player == Colour::WHITE) ? "White" : "Black", gs, cb.white_name, cb.black_name);
 	
@@ -1002,29 +953,30 @@ void LogicEngine::loop_board(Chessboard cb, Gamestate gs)
 	{
 		if (gs == Gamestate::CHECKMATE || gs == Gamestate::STALEMATE) break;
 
-		vector<Square> potential_moves = parse_attackable_squares(cb.valid_moves[cb.active_player]);
+		MoveList potential_moves = cb.valid_moves(cb.active_player);
 		string num_potential_moves = to_string(potential_moves.size());
 		debug_print(Level::DEBUG, { "Number of valid moves: " , num_potential_moves , "\nValid moves are: " });
-		for (int i = 0; i < potential_moves.size(); i++)
+		for (Move move : potential_moves)
 		{
-			debug_print(Level::DEBUG, { convert_int_to_chessboard_square(potential_moves[i].col, potential_moves[i].row) , " " });
+			debug_print(Level::DEBUG, { convert_int_to_chessboard_square(square_col(move.to()), square_row(move.to())) , " " });
 		}
 		debug_print(Level::INFO, { "\n" });
 
-		print_board(cb, vector<Square>(), Gamestate::NORMAL);
+		print_board(cb, MoveList(), Gamestate::NORMAL);
 
 		vector<int> target_position, destination_position;
 
 		// Get the square to move from, and if valid, find the piece on that square and its valid moves.
-		target_position = get_input_target_square(&cb, &board_stack);
+		analysis.start(cb, get_game_keys(undo_stack));
+		target_position = get_input_target_square(&cb, &undo_stack, &analysis);
 		if (target_position[0] == -1) return; // if the user inputted 'exit' to return to menu
 
-		vector<Square> vms = cb.find_valid_moves(cb.board[target_position[0]][target_position[1]]);
+		MoveList vms = cb.find_valid_moves(cb.board[target_position[0]][target_position[1]]);
 
 		// debug-print all the valid moves for that piece
-		for (int i = 0; i < vms.size(); i++)
+		for (Move move : vms)
 		{
-			debug_print(Level::DEBUG, { convert_int_to_chessboard_square(vms[i].col, vms[i].row), " " });
+			debug_print(Level::DEBUG, { convert_int_to_chessboard_square(square_col(move.to()), square_row(move.to())), " " });
 		}
 		debug_print(Level::DEBUG, { "\n" });
 
@@ -1035,11 +987,16 @@ void LogicEngine::loop_board(Chessboard cb, Gamestate gs)
 		destination_position = get_input_destination_square(vms);
 		if (destination_position[0] == -1) continue; // if the user inputted 'back' to return to target square selection
 
-		// finally: make the move
-		gs = make_move(&cb, vms, target_position, destination_position);
+		// If the moved piece is a pawn moving to the opposite back rank, we must intercept for promotion.
+		Move move = build_move(cb, target_position, destination_position);
+		if (move.flag() == MoveFlag::PROMOTION)
+			move = build_move(cb, target_position, destination_position, get_pawn_promotion_terminal());
 
-		// Push the new board to the stack of boards. This includes the notation stack, state of the board and pieces, and game metadata e.g. move no.
-		board_stack.push(cb);
+		// finally: make the move, once the analysis of the position before it has stopped
+		analysis.stop();
+		UndoInfo undo;
+		gs = make_move(&cb, move, &undo);
+		undo_stack.push(undo);
 
 		handle_game_end(cb, gs);
 	}
@@ -3,6 +3,7 @@
 #pragma warning( disable : 26451 )
 
 #include <vector>
+#include <array>
 #include <map>
 #include <string>
 #include <algorithm>
@@ -11,6 +12,12 @@
 #include <stack>
 #include <filesystem>
 #include <ctime>
+#include <type_traits>
+
+#include "bitboard.hpp"
+#include "zobrist.hpp"
+#include "psqt.hpp"
+#include "nnue.hpp"
 
 namespace LogicEngine 
 {
@@ -48,6 +55,8 @@ namespace LogicEngine
     };
 
     // Define a square. A square can be empty or occupied by a piece
+    // Squares hold no history, so they can be copied and compared as plain values.
+    // Whether a side can still castle or capture en passant is kept on the board instead.
     class Square
     {
     public:
@@ -55,24 +64,176 @@ namespace LogicEngine
         Piece piece;
         int row;
         int col;
-        bool has_moved;
-        std::vector<int> when_moved; // List of move numbers when that piece was moved
         bool operator==(const Square rhs) const;
         bool operator!=(const Square rhs) const;
 
         Square();
         Square(int row, int col);
-        Square(Piece p, Colour c, int i, int j, bool h_m, std::vector<int> w_m);
+        Square(Piece p, Colour c, int i, int j);
+    };
+    static_assert(std::is_trivially_copyable_v<Square>, "squares should copy without allocating");
+
+    const int DIM_SIZE = 8; // size of the chessboard
+
+    typedef std::array<std::array<Square, DIM_SIZE>, DIM_SIZE> Board;
+
+    // The bitboard core of the board: one bitboard per coloured piece type, plus the occupancy of each colour.
+    // Bitboards are indexed by colour and then by piece, skipping Piece::EMPTY.
+    // Kept in step with the board of squares by every function that moves pieces.
+    struct Bitboards
+    {
+        Bitboard pieces[2][6] = {};
+        Bitboard occupancy[2] = {};
+
+        Bitboard of(Colour c, Piece p) const { return pieces[(int)c][(int)p - 1]; }
+        Bitboard all() const { return occupancy[0] | occupancy[1]; }
+        void add(Colour c, Piece p, int sq);
+        void remove(Colour c, Piece p, int sq);
+    };
+
+    // How many pieces of each colour attack each square, kept up to date as pieces move.
+    // The attacks of the piece on each square are kept too, so a change to a piece's attacks only recounts the squares it gained or lost.
+    // When a piece arrives on or leaves a square, only it and the sliders looking through that square need their attacks worked out again.
+    struct AttackMap
+    {
+        Bitboard from[NUM_SQUARES] = {};        // squares attacked by the piece on each square
+        uint8_t counts[2][NUM_SQUARES] = {};    // number of pieces of each colour attacking each square
+        Bitboard attacked[2] = {};              // squares each colour attacks at least once
+
+        int count(Colour c, int sq) const { return counts[(int)c][sq]; }
+        void set(Colour c, int sq, Bitboard attacks);
+        bool operator==(const AttackMap& rhs) const;
+    };
+
+    // Moves which touch more squares than the two the moving piece travels between, or which change the piece, are flagged.
+    enum class MoveFlag
+    {
+        NORMAL,
+        DOUBLE_PUSH,
+        CASTLING,
+        EN_PASSANT,
+        PROMOTION
+    };
+
+    // A move of one piece between two squares, given as bitboard square indices.
+    // Castling moves are given as the king's move; the rook is moved alongside it.
+    // Packed into 16 bits so move lists stay small: the from square in bits 0-5, the to square in bits 6-11,
+    // and the move type in bits 12-15. Types 0-3 are the non-promoting flags, and 4-7 promote to a knight, bishop, rook or queen.
+    class Move
+    {
+    public:
+        int from() const { return data & 0x3F; }
+        int to() const { return (data >> 6) & 0x3F; }
+        MoveFlag flag() const { return (type() < PROMOTION_TYPE) ? (MoveFlag)type() : MoveFlag::PROMOTION; }
+        Piece promotion() const { return (type() < PROMOTION_TYPE) ? Piece::EMPTY : PROMOTION_PIECES[type() - PROMOTION_TYPE]; }
+        uint16_t raw() const { return data; }
+        static Move from_raw(uint16_t raw) { Move move; move.data = raw; return move; }
+        std::string to_long_algebraic() const;
+
+        bool operator==(const Move rhs) const { return data == rhs.data; }
+        bool operator!=(const Move rhs) const { return data != rhs.data; }
+
+        Move() = default;
+        // A promotion without a piece given promotes to a queen.
+        Move(int from, int to, MoveFlag flag = MoveFlag::NORMAL, Piece promotion = Piece::EMPTY)
+            : data((uint16_t)(from | (to << 6) | (encode_type(flag, promotion) << 12))) {};
+
+    private:
+        static const int PROMOTION_TYPE = 4;
+        inline static const Piece PROMOTION_PIECES[4] = { Piece::KNIGHT, Piece::BISHOP, Piece::ROOK, Piece::QUEEN };
+
+        int type() const { return data >> 12; }
+        static int encode_type(MoveFlag flag, Piece promotion)
+        {
+            if (flag != MoveFlag::PROMOTION) return (int)flag;
+            switch (promotion)
+            {
+            case Piece::KNIGHT: return PROMOTION_TYPE;
+            case Piece::BISHOP: return PROMOTION_TYPE + 1;
+            case Piece::ROOK:   return PROMOTION_TYPE + 2;
+            default:            return PROMOTION_TYPE + 3;
+            }
+        }
+
+        uint16_t data = 0;
+    };
+    static_assert(sizeof(Move) == 2, "moves should pack into 16 bits");
+
+    // A list of moves with a fixed capacity, kept in place rather than on the heap.
+    // No legal position has more than 218 moves, so 256 is always enough.
+    class MoveList
+    {
+    public:
+        static const int MAX_MOVES = 256;
+
+        void push_back(Move move) { moves[count++] = move; }
+        void clear() { count = 0; }
+        int size() const { return count; }
+        bool empty() const { return count == 0; }
+        bool contains(Move move) const { return std::find(begin(), end(), move) != end(); }
+
+        Move& operator[](int i) { return moves[i]; }
+        Move operator[](int i) const { return moves[i]; }
+        Move* begin() { return moves; }
+        Move* end() { return moves + count; }
+        const Move* begin() const { return moves; }
+        const Move* end() const { return moves + count; }
+
+    private:
+        Move moves[MAX_MOVES];
+        int count = 0;
+    };
+
+    // What the legal move generator needs to know about one side's king, worked out once per position.
+    // Each piece's legal moves are then its prospective moves with these masks applied, without trying any move on a copy of the board.
+    struct KingSafety
+    {
+        int king_sq;            // -1 if the side has no king on the board
+        Bitboard checkers;      // opponent pieces giving check
+        Bitboard check_mask;    // squares a move other than a king move must land on to get out of check
+        Bitboard pinned;        // own pieces which cannot leave the line between their king and an opponent slider
+        Bitboard enemy_attacks; // squares the opponent attacks, looking through the king so it cannot step back along a checking ray
+    };
+
+    // The legal moves worked out so far for a position, filled in a piece at a time as they are asked for.
+    // Anything that changes the position empties it, so a move only costs clearing two masks.
+    struct MoveCache
+    {
+        Bitboard ready = 0;                         // squares whose piece's moves are held in destinations
+        Bitboard destinations[NUM_SQUARES];
+        bool king_safety_ready[2] = {};
+        KingSafety king_safety[2];
+
+        void clear() { ready = 0; king_safety_ready[0] = king_safety_ready[1] = false; }
     };
 
-    // Define the board as a 2-d array of squares. 
+    // Castling rights, as bits of a mask: kingside (O-O) and queenside (O-O-O) for each colour.
+    const int WHITE_OO = 1;
+    const int WHITE_OOO = 2;
+    const int BLACK_OO = 4;
+    const int BLACK_OOO = 8;
+
+    // Everything needed to take a move back, returned by do_move() and passed to undo_move().
+    // The rest of the position can be worked out from the move itself.
+    struct UndoInfo
+    {
+        Move move;
+        Square captured;        // the captured piece, or an empty square
+        int castling_rights;
+        int ep_square;
+        int halfmove_clock;
+        size_t notation_length; // the length of the game notation before the move was added to it
+        Key key;                // the position's Zobrist key before the move
+    };
+
+    // Define the board as a 2-d array of squares, backed by a set of bitboards for fast move generation.
     // Squares can be empty or occupied by a piece.
     // Also maintains metadata for the game:
     //    The game notation, move nuumber, active player, black and white player names, and the result.
     class Chessboard
     {
     public:
-        std::map<char, std::tuple<Piece, Colour>> piece_map = {
+        inline static const std::map<char, std::tuple<Piece, Colour>> piece_map = {
             { '_', {Piece::EMPTY,  Colour::EMPTY }},
             { 'P', {Piece::PAWN,   Colour::WHITE }},
             { 'R', {Piece::ROOK,   Colour::WHITE }},
@@ -88,29 +249,50 @@ namespace LogicEngine
             { 'k', {Piece::KING,   Colour::BLACK }}
         };
 
-        std::vector<std::vector<Square>> board;
-        std::map<Colour, std::vector<std::tuple<Square, std::vector<Square>>>> valid_moves;
-        std::map<Colour, std::vector<std::tuple<Square, std::vector<Square>>>> attacking_moves;
+        Board board;
+        Bitboards bitboards;
+        AttackMap attacks;
         Colour active_player;
         int move_no;
+        int castling_rights;    // mask of WHITE_OO, WHITE_OOO, BLACK_OO and BLACK_OOO
+        int ep_square;          // the square a pawn can capture onto en passant, or -1 if there is none
+        int halfmove_clock;     // plies since the last capture or pawn move, for the fifty-move rule
+        Key key;                // Zobrist key of the position, kept up to date as pieces move
+        Key pawn_key;           // Zobrist key of the pawns alone, for looking up pawn structure
+        PsqtScore psqt;         // material and piece-square score of the position, kept up to date as pieces move
+        mutable Accumulator accumulator;    // the network's first layer for the position, while a network is loaded
         std::string notation, white_name, black_name, date, result;
+        mutable MoveCache move_cache;
 
-        std::vector<Square> find_valid_moves(Square target);
+        MoveList find_valid_moves(Square target);
+        MoveList valid_moves(Colour colour) const;
+        MoveList attacking_moves(Colour colour) const;
+        bool has_any_legal_move(Colour colour) const;
+        const KingSafety& cached_king_safety(Colour colour) const;
+        Bitboard cached_piece_moves(int sq) const;
+        void set_square(int row, int col, Square square);
+        void set_active_player(Colour colour);
+        bool load_fen(std::string fen);
+        Key compute_key() const;
+        Key compute_pawn_key() const;
+        AttackMap compute_attacks() const;
+        PsqtScore compute_psqt() const;
+        UndoInfo do_move(Move move);
+        void undo_move(const UndoInfo& undo);
+        UndoInfo do_null_move();
+        void undo_null_move(const UndoInfo& undo);
 
         Chessboard(std::string start_position);
         Chessboard() : Chessboard("positions/starting_position.txt") {};
     };
 
 
-    const int DIM_SIZE = 8; // size of the chessboard
 	// Functions for finding moves, making moves, and handling the game state.
-    std::vector<Square> get_valid_square_moves(Square target, Chessboard chessboard, Colour opp_colour);
-    std::vector<std::tuple<Square, std::vector<Square>>> 
-        find_all_attackable_squares(Chessboard chessboard, Colour colour, Piece_Finding_Mode mode);
-	void get_valid_and_attacking_moves(Chessboard* chessboard);
-    Gamestate make_move(Chessboard* cb, std::vector<Square> valid_piece_moves, std::vector<int> target_position, std::vector<int> destination_position);
+    MoveList get_valid_square_moves(Square target, const Chessboard& chessboard);
+    MoveList find_all_attackable_squares(const Chessboard& chessboard, Colour colour, Piece_Finding_Mode mode);
+    Move build_move(const Chessboard& chessboard, std::vector<int> target_position, std::vector<int> destination_position, Piece promotion_choice = Piece::EMPTY);
+    Gamestate make_move(Chessboard* cb, Move move, UndoInfo* undo = nullptr);
     void loop_board(Chessboard cb, Gamestate gs);
     void switch_pieces(Chessboard* cb, std::vector<int> target_position, std::vector<int> destination_position);
-	bool is_dest_square_attackable_by_piece(std::tuple<Square, std::vector<Square>> potential_mover, std::vector<int> dest_position);
     std::vector<int> convert_chessboard_square_to_int(std::string position);
 }
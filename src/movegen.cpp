@@ -0,0 +1,361 @@
+// movegen.cpp
+
+#include "movegen.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+
+
+// Find the squares a piece attacks from a square, given the occupied squares.
+// Pawns attack their forward diagonals whether or not anything stands there.
+Bitboard LogicEngine::get_piece_attacks(Piece piece, Colour colour, int sq, Bitboard occupied)
+{
+	switch (piece)
+	{
+	case Piece::PAWN:
+		return PAWN_ATTACKS[(int)colour][sq];
+	case Piece::ROOK:
+		return rook_attacks(sq, occupied);
+	case Piece::BISHOP:
+		return bishop_attacks(sq, occupied);
+	case Piece::QUEEN:
+		return queen_attacks(sq, occupied);
+	case Piece::KNIGHT:
+		return KNIGHT_ATTACKS[sq];
+	case Piece::KING:
+		return KING_ATTACKS[sq];
+	default:
+		return 0;
+	}
+}
+
+
+// Find every piece of either colour attacking a square, given the occupied squares.
+// Each piece type is found by looking from the square as that piece type and seeing if one stands there.
+Bitboard LogicEngine::get_attackers_to(const Bitboards& bitboards, int sq, Bitboard occupied)
+{
+	Bitboard queens = bitboards.of(Colour::WHITE, Piece::QUEEN) | bitboards.of(Colour::BLACK, Piece::QUEEN);
+	Bitboard rooks = bitboards.of(Colour::WHITE, Piece::ROOK) | bitboards.of(Colour::BLACK, Piece::ROOK) | queens;
+	Bitboard bishops = bitboards.of(Colour::WHITE, Piece::BISHOP) | bitboards.of(Colour::BLACK, Piece::BISHOP) | queens;
+	Bitboard knights = bitboards.of(Colour::WHITE, Piece::KNIGHT) | bitboards.of(Colour::BLACK, Piece::KNIGHT);
+	Bitboard kings = bitboards.of(Colour::WHITE, Piece::KING) | bitboards.of(Colour::BLACK, Piece::KING);
+
+	// a white pawn attacks the square if a black pawn standing there would attack the white pawn, and vice versa
+	return (PAWN_ATTACKS[(int)Colour::BLACK][sq] & bitboards.of(Colour::WHITE, Piece::PAWN))
+		| (PAWN_ATTACKS[(int)Colour::WHITE][sq] & bitboards.of(Colour::BLACK, Piece::PAWN))
+		| (KNIGHT_ATTACKS[sq] & knights)
+		| (KING_ATTACKS[sq] & kings)
+		| (rook_attacks(sq, occupied) & rooks)
+		| (bishop_attacks(sq, occupied) & bishops);
+}
+
+
+// Find every square a colour attacks, whether or not anything stands there.
+// Pawns attack their forward diagonals even when empty, which is what matters for where the opponent king may step.
+Bitboard LogicEngine::get_attacked_squares(const Bitboards& bitboards, Colour colour, Bitboard occupied)
+{
+	Bitboard attacked = 0;
+	Bitboard pieces;
+
+	pieces = bitboards.of(colour, Piece::PAWN);
+	while (pieces) attacked |= PAWN_ATTACKS[(int)colour][pop_lsb(&pieces)];
+
+	pieces = bitboards.of(colour, Piece::KNIGHT);
+	while (pieces) attacked |= KNIGHT_ATTACKS[pop_lsb(&pieces)];
+
+	pieces = bitboards.of(colour, Piece::KING);
+	while (pieces) attacked |= KING_ATTACKS[pop_lsb(&pieces)];
+
+	pieces = bitboards.of(colour, Piece::ROOK) | bitboards.of(colour, Piece::QUEEN);
+	while (pieces) attacked |= rook_attacks(pop_lsb(&pieces), occupied);
+
+	pieces = bitboards.of(colour, Piece::BISHOP) | bitboards.of(colour, Piece::QUEEN);
+	while (pieces) attacked |= bishop_attacks(pop_lsb(&pieces), occupied);
+
+	return attacked;
+}
+
+
+// Look for any opponent piece attacking the king of the given colour, including pawns and the opponent king.
+bool LogicEngine::is_king_attacked(const Chessboard& chessboard, Colour colour)
+{
+	Bitboard king = chessboard.bitboards.of(colour, Piece::KING);
+	if (!king) return false;
+
+	Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	return chessboard.attacks.count(opp_colour, lsb(king)) > 0;
+}
+
+
+// Work out the checks, pins and attacked squares around the king of the given colour.
+// - If one piece gives check, other pieces must capture it or block the line between it and the king.
+// - If two pieces give check, only the king can move.
+// - A piece is pinned if it is the only piece between the king and an opponent slider looking along that line.
+KingSafety LogicEngine::get_king_safety(const Chessboard& chessboard, Colour colour)
+{
+	const Bitboards& bitboards = chessboard.bitboards;
+	Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	Bitboard occupied = bitboards.all();
+	Bitboard king = bitboards.of(colour, Piece::KING);
+
+	KingSafety king_safety;
+	king_safety.checkers = 0;
+	king_safety.check_mask = ~0ULL;
+	king_safety.pinned = 0;
+	king_safety.enemy_attacks = chessboard.attacks.attacked[(int)opp_colour];
+
+	// boards without a king (e.g. when testing single pieces) have no checks or pins to worry about
+	if (!king)
+	{
+		king_safety.king_sq = -1;
+		return king_safety;
+	}
+	int king_sq = lsb(king);
+	king_safety.king_sq = king_sq;
+
+	king_safety.checkers = get_attackers_to(bitboards, king_sq, occupied) & bitboards.occupancy[(int)opp_colour];
+	if (pop_count(king_safety.checkers) == 1)
+		king_safety.check_mask = king_safety.checkers | BETWEEN[king_sq][lsb(king_safety.checkers)];
+	else if (king_safety.checkers)
+		king_safety.check_mask = 0;
+
+	// the attack map has the king blocking the sliders that check it, but the king can't step back along their line,
+	// so those sliders' attacks are taken again as if the king were not there
+	Bitboard slider_checkers = king_safety.checkers & ~(bitboards.of(opp_colour, Piece::PAWN) | bitboards.of(opp_colour, Piece::KNIGHT));
+	while (slider_checkers)
+	{
+		int sq = pop_lsb(&slider_checkers);
+		Square checker = chessboard.board[square_row(sq)][square_col(sq)];
+		king_safety.enemy_attacks |= get_piece_attacks(checker.piece, checker.colour, sq, occupied & ~king);
+	}
+
+	// sliders that would see the king on an empty board, with exactly one piece in the way
+	Bitboard snipers = ((rook_attacks(king_sq, 0) & (bitboards.of(opp_colour, Piece::ROOK) | bitboards.of(opp_colour, Piece::QUEEN)))
+		| (bishop_attacks(king_sq, 0) & (bitboards.of(opp_colour, Piece::BISHOP) | bitboards.of(opp_colour, Piece::QUEEN))));
+	while (snipers)
+	{
+		Bitboard blockers = BETWEEN[king_sq][pop_lsb(&snipers)] & occupied;
+		if (pop_count(blockers) == 1 && (blockers & bitboards.occupancy[(int)colour]))
+			king_safety.pinned |= blockers;
+	}
+
+	return king_safety;
+}
+
+
+// For pawns, look a square ahead in the direction a pawn can move in, or two if the pawn hasn't moved yet.
+// Then add the forward diagonals that hold an opponent piece.
+Bitboard get_prospective_pawn_moves(const Chessboard& chessboard, Square target)
+{
+	Colour opp_colour = (target.colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	Bitboard empty = ~chessboard.bitboards.all();
+	int dir = (target.colour == Colour::WHITE) ? 1 : -1;
+	int start_row = (target.colour == Colour::WHITE) ? 1 : 6;
+	Bitboard moves = 0;
+
+	int push_row = target.row + dir;
+	if (push_row >= 0 && push_row < DIM_SIZE && (empty & square_bb(square_index(push_row, target.col))))
+	{
+		moves |= square_bb(square_index(push_row, target.col));
+
+		// case for pawns on the starting rank
+		if (target.row == start_row && (empty & square_bb(square_index(push_row + dir, target.col))))
+			moves |= square_bb(square_index(push_row + dir, target.col));
+	}
+
+	moves |= PAWN_ATTACKS[(int)target.colour][square_index(target.row, target.col)] & chessboard.bitboards.occupancy[(int)opp_colour];
+	return moves;
+}
+
+
+// Find the squares a piece could move to if we do not worry about putting its own king in check.
+// Leapers and sliders are a lookup into their attack tables, removing squares held by the piece's own colour.
+// Castling and en passant are left to get_legal_moves(), as they depend on more than the squares around the piece.
+Bitboard LogicEngine::get_prospective_moves(const Chessboard& chessboard, Square target)
+{
+	int sq = square_index(target.row, target.col);
+	Bitboard own = chessboard.bitboards.occupancy[(int)target.colour];
+	Bitboard occupied = chessboard.bitboards.all();
+
+	switch (target.piece)
+	{
+	case Piece::PAWN:
+		return get_prospective_pawn_moves(chessboard, target);
+	case Piece::ROOK:
+		return rook_attacks(sq, occupied) & ~own;
+	case Piece::BISHOP:
+		return bishop_attacks(sq, occupied) & ~own;
+	case Piece::QUEEN:
+		return queen_attacks(sq, occupied) & ~own;
+	case Piece::KNIGHT:
+		return KNIGHT_ATTACKS[sq] & ~own;
+	case Piece::KING:
+		return KING_ATTACKS[sq] & ~own;
+	default:
+		return 0;
+	}
+}
+
+
+// Detect castling moves for a king on its starting square, using the board's castling rights.
+// The rook must still stand in its corner, the squares between the king and rook must be empty,
+// and the king cannot be in check or pass through or land on an attacked square.
+Bitboard get_castling_moves(const Chessboard& chessboard, const KingSafety& king_safety, Square king)
+{
+	const Board& board = chessboard.board;
+	int back_row = (king.colour == Colour::WHITE) ? 0 : 7;
+	int rights = chessboard.castling_rights & ((king.colour == Colour::WHITE) ? (WHITE_OO | WHITE_OOO) : (BLACK_OO | BLACK_OOO));
+	Bitboard occupied = chessboard.bitboards.all();
+	Bitboard moves = 0;
+
+	if (!rights || king.row != back_row || king.col != 4 || king_safety.checkers) return 0;
+
+	// queenside O-O-O: b, c and d must be empty, c and d must be unattacked
+	Square rook = board[back_row][0];
+	if ((rights & (WHITE_OOO | BLACK_OOO)) && rook.piece == Piece::ROOK && rook.colour == king.colour
+		&& !(occupied & (square_bb(square_index(back_row, 1)) | square_bb(square_index(back_row, 2)) | square_bb(square_index(back_row, 3))))
+		&& !(king_safety.enemy_attacks & (square_bb(square_index(back_row, 2)) | square_bb(square_index(back_row, 3)))))
+		moves |= square_bb(square_index(back_row, 2));
+
+	// kingside O-O: f and g must be empty and unattacked
+	rook = board[back_row][7];
+	Bitboard kingside_squares = square_bb(square_index(back_row, 5)) | square_bb(square_index(back_row, 6));
+	if ((rights & (WHITE_OO | BLACK_OO)) && rook.piece == Piece::ROOK && rook.colour == king.colour
+		&& !(occupied & kingside_squares)
+		&& !(king_safety.enemy_attacks & kingside_squares))
+		moves |= square_bb(square_index(back_row, 6));
+
+	return moves;
+}
+
+
+// Detect en passant captures for a pawn onto the board's en passant square.
+// These are checked by taking both pawns off the board and looking for attacks on the king,
+// as removing two pieces from the same rank can uncover an attack that no pin would catch.
+Bitboard get_en_passant_moves(const Chessboard& chessboard, const KingSafety& king_safety, Square pawn)
+{
+	int sq = square_index(pawn.row, pawn.col);
+	if (chessboard.ep_square < 0 || !(PAWN_ATTACKS[(int)pawn.colour][sq] & square_bb(chessboard.ep_square))) return 0;
+
+	Colour opp_colour = (pawn.colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	int dest_sq = chessboard.ep_square;
+	int captured_sq = square_index(pawn.row, square_col(dest_sq));
+	if (!(chessboard.bitboards.of(opp_colour, Piece::PAWN) & square_bb(captured_sq))) return 0;
+	if (king_safety.king_sq < 0) return square_bb(dest_sq);
+
+	Bitboard occupied = (chessboard.bitboards.all() ^ square_bb(sq) ^ square_bb(captured_sq)) | square_bb(dest_sq);
+	Bitboard attackers = get_attackers_to(chessboard.bitboards, king_safety.king_sq, occupied)
+		& chessboard.bitboards.occupancy[(int)opp_colour] & ~square_bb(captured_sq);
+
+	return attackers ? 0 : square_bb(dest_sq);
+}
+
+
+// Find the legal moves for a piece from its prospective moves:
+// - The king can step to any square the opponent does not attack, or castle.
+// - Other pieces can't move at all in double check, and otherwise must land on the check mask.
+// - Pinned pieces can only move along the line through their king and the pinning piece.
+Bitboard LogicEngine::get_legal_moves(const Chessboard& chessboard, const KingSafety& king_safety, Square target)
+{
+	if (target.piece == Piece::EMPTY || target.colour == Colour::EMPTY) return 0;
+
+	if (target.piece == Piece::KING)
+		return (get_prospective_moves(chessboard, target) & ~king_safety.enemy_attacks)
+			| get_castling_moves(chessboard, king_safety, target);
+
+	if (pop_count(king_safety.checkers) > 1) return 0;
+
+	int sq = square_index(target.row, target.col);
+	Bitboard moves = get_prospective_moves(chessboard, target) & king_safety.check_mask;
+	if (target.piece == Piece::PAWN)
+		moves |= get_en_passant_moves(chessboard, king_safety, target);
+	if (king_safety.pinned & square_bb(sq))
+		moves &= LINE[king_safety.king_sq][sq];
+
+	return moves;
+}
+
+
+// Add the moves of a piece to each of a set of destination squares to a move list, flagging the special moves.
+// A pawn reaching the last rank can promote to any of four pieces: with all_promotions each is added as its own move,
+// and otherwise a single promotion stands for the choice, for lists of where pieces can go rather than of moves to search.
+void LogicEngine::add_moves(const Chessboard& chessboard, Square target, Bitboard destinations, MoveList* moves, bool all_promotions)
+{
+	int from = square_index(target.row, target.col);
+	int last_row = (target.colour == Colour::WHITE) ? 7 : 0;
+
+	while (destinations)
+	{
+		int to = pop_lsb(&destinations);
+		MoveFlag flag = MoveFlag::NORMAL;
+
+		if (target.piece == Piece::KING && abs(square_col(to) - square_col(from)) == 2)
+			flag = MoveFlag::CASTLING;
+		else if (target.piece == Piece::PAWN)
+		{
+			if (square_row(to) == last_row)
+			{
+				if (!all_promotions)
+				{
+					moves->push_back(Move(from, to, MoveFlag::PROMOTION));
+					continue;
+				}
+				for (Piece promotion : { Piece::QUEEN, Piece::ROOK, Piece::BISHOP, Piece::KNIGHT })
+					moves->push_back(Move(from, to, MoveFlag::PROMOTION, promotion));
+				continue;
+			}
+			if (abs(square_row(to) - square_row(from)) == 2)
+				flag = MoveFlag::DOUBLE_PUSH;
+			else if (square_col(to) != square_col(from) && !(chessboard.bitboards.all() & square_bb(to)))
+				flag = MoveFlag::EN_PASSANT;
+		}
+
+		moves->push_back(Move(from, to, flag));
+	}
+}
+
+
+// Generate the legal moves of a type for the side to move, as moves ready to pass to do_move().
+// Promotions are expanded into one move for each piece the pawn can become.
+// When generating by type, each piece's destinations come from the board's move cache, so generating the noisy and then
+// the quiet moves of a position only works out each piece's moves once. All moves skip the cache, as perft runs faster without it.
+MoveList LogicEngine::get_all_legal_moves(const Chessboard& chessboard, MoveGenType type)
+{
+	MoveList moves;
+	Colour colour = chessboard.active_player;
+	Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+
+	Bitboard noisy = chessboard.bitboards.occupancy[(int)opp_colour];
+	Bitboard pawn_noisy = noisy | ((colour == Colour::WHITE) ? 0xFF00000000000000ULL : 0xFFULL);
+	if (chessboard.ep_square >= 0) pawn_noisy |= square_bb(chessboard.ep_square);
+
+	KingSafety king_safety;
+	if (type == MoveGenType::ALL) king_safety = get_king_safety(chessboard, colour);
+
+	Bitboard pieces = chessboard.bitboards.occupancy[(int)colour];
+	while (pieces)
+	{
+		int from = pop_lsb(&pieces);
+		Square target = chessboard.board[square_row(from)][square_col(from)];
+		Bitboard destinations = (type == MoveGenType::ALL) ? get_legal_moves(chessboard, king_safety, target) : chessboard.cached_piece_moves(from);
+		Bitboard mask = (target.piece == Piece::PAWN) ? pawn_noisy : noisy;
+
+		if (type == MoveGenType::NOISY) destinations &= mask;
+		else if (type == MoveGenType::QUIET) destinations &= ~mask;
+		add_moves(chessboard, target, destinations, &moves, true);
+	}
+
+	return moves;
+}
+
+
+// Check whether a move is legal for the side to move, such as a move remembered from another position which may not be.
+bool LogicEngine::is_legal_move(const Chessboard& chessboard, Move move)
+{
+	Square target = chessboard.board[square_row(move.from())][square_col(move.from())];
+	if (move == Move() || target.colour != chessboard.active_player) return false;
+
+	MoveList moves;
+	add_moves(chessboard, target, chessboard.cached_piece_moves(move.from()) & square_bb(move.to()), &moves, true);
+	return moves.contains(move);
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "logic.hpp"
+
+namespace LogicEngine
+{
+    // Which legal moves to generate: all of them, only the noisy ones (captures, including en passant, and promotions), or only the rest.
+    enum class MoveGenType
+    {
+        ALL,
+        NOISY,
+        QUIET
+    };
+
+    Bitboard get_piece_attacks(Piece piece, Colour colour, int sq, Bitboard occupied);
+    Bitboard get_attackers_to(const Bitboards& bitboards, int sq, Bitboard occupied);
+    Bitboard get_attacked_squares(const Bitboards& bitboards, Colour colour, Bitboard occupied);
+    bool is_king_attacked(const Chessboard& chessboard, Colour colour);
+    KingSafety get_king_safety(const Chessboard& chessboard, Colour colour);
+    Bitboard get_prospective_moves(const Chessboard& chessboard, Square target);
+    Bitboard get_legal_moves(const Chessboard& chessboard, const KingSafety& king_safety, Square target);
+    void add_moves(const Chessboard& chessboard, Square target, Bitboard destinations, MoveList* moves, bool all_promotions);
+    MoveList get_all_legal_moves(const Chessboard& chessboard, MoveGenType type = MoveGenType::ALL);
+    bool is_legal_move(const Chessboard& chessboard, Move move);
+}
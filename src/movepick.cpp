@@ -0,0 +1,169 @@
+// movepick.cpp
+
+#include "movepick.hpp"
+#include "movegen.hpp"
+#include "evaluate.hpp"
+#include "see.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+
+
+const int HISTORY_LIMIT = 1 << 20;
+
+
+// Credit a quiet move with a cutoff, by the square of the depth it was found at.
+void HistoryTable::add(Colour colour, Move move, int depth)
+{
+	int& score = scores[(int)colour][move.from()][move.to()];
+	score += depth * depth;
+	if (score < HISTORY_LIMIT) return;
+
+	for (auto& from_scores : scores)
+		for (auto& to_scores : from_scores)
+			for (int& s : to_scores) s /= 2;
+}
+
+
+void HistoryTable::clear()
+{
+	for (auto& from_scores : scores)
+		for (auto& to_scores : from_scores)
+			for (int& s : to_scores) s = 0;
+}
+
+
+// Whether a move captures or promotes, rather than just moving a piece to an empty square.
+bool SearchEngine::is_noisy(const Chessboard& chessboard, Move move)
+{
+	return (chessboard.bitboards.all() & square_bb(move.to())) || move.flag() == MoveFlag::EN_PASSANT || move.flag() == MoveFlag::PROMOTION;
+}
+
+
+// The piece a move captures, or Piece::EMPTY for a move to an empty square.
+Piece captured_piece(const Chessboard& chessboard, Move move)
+{
+	if (move.flag() == MoveFlag::EN_PASSANT) return Piece::PAWN;
+	return chessboard.board[square_row(move.to())][square_col(move.to())].piece;
+}
+
+
+// Whether a capture or promotion loses material once the exchange on its square plays out.
+// Taking a piece worth at least as much as the capturing one can't lose material, so only cheaper victims need the exchange worked out.
+bool is_losing_capture(const Chessboard& chessboard, Move move)
+{
+	Piece attacker = chessboard.board[square_row(move.from())][square_col(move.from())].piece;
+	if (PIECE_VALUES[(int)captured_piece(chessboard, move)] >= PIECE_VALUES[(int)attacker]) return false;
+	return see(chessboard, move) < 0;
+}
+
+
+MovePicker::MovePicker(const Chessboard& chessboard, Move tt_move, const Move* killer_moves, const HistoryTable& history)
+	: chessboard(chessboard), history(history), tt_move(tt_move)
+{
+	killers[0] = (killer_moves != nullptr) ? killer_moves[0] : Move();
+	killers[1] = (killer_moves != nullptr) ? killer_moves[1] : Move();
+}
+
+
+MovePicker::MovePicker(const Chessboard& chessboard, const HistoryTable& history)
+	: chessboard(chessboard), history(history), noisy_only(true), stage(Stage::GENERATE_CAPTURES)
+{
+}
+
+
+// Return the next move to search, or an empty move once every legal move has been given.
+Move MovePicker::next()
+{
+	switch (stage)
+	{
+	case Stage::TT_MOVE:
+		stage = Stage::GENERATE_CAPTURES;
+		if (is_legal_move(chessboard, tt_move)) return tt_move;
+		[[fallthrough]];
+
+	case Stage::GENERATE_CAPTURES:
+		moves = get_all_legal_moves(chessboard, MoveGenType::NOISY);
+		for (int i = 0; i < moves.size(); i++)
+		{
+			Move move = moves[i];
+			Piece attacker = chessboard.board[square_row(move.from())][square_col(move.from())].piece;
+			scores[i] = 16 * PIECE_VALUES[(int)captured_piece(chessboard, move)] - PIECE_VALUES[(int)attacker] + 16 * PIECE_VALUES[(int)move.promotion()];
+		}
+		current = 0;
+		stage = Stage::CAPTURES;
+		[[fallthrough]];
+
+	case Stage::CAPTURES:
+		while (current < moves.size())
+		{
+			Move move = pick_best();
+			if (move == tt_move) continue;
+			if (!is_losing_capture(chessboard, move)) return move;
+			if (!noisy_only) bad_captures.push_back(move);
+		}
+		if (noisy_only)
+		{
+			stage = Stage::DONE;
+			return Move();
+		}
+		stage = Stage::KILLERS;
+		[[fallthrough]];
+
+	case Stage::KILLERS:
+		while (killer_index < 2)
+		{
+			Move killer = killers[killer_index++];
+			if (killer != tt_move && !is_noisy(chessboard, killer) && is_legal_move(chessboard, killer)) return killer;
+		}
+		stage = Stage::GENERATE_QUIETS;
+		[[fallthrough]];
+
+	case Stage::GENERATE_QUIETS:
+		moves = get_all_legal_moves(chessboard, MoveGenType::QUIET);
+		for (int i = 0; i < moves.size(); i++) scores[i] = history.get(chessboard.active_player, moves[i]);
+		current = 0;
+		stage = Stage::QUIETS;
+		[[fallthrough]];
+
+	case Stage::QUIETS:
+		while (current < moves.size())
+		{
+			Move move = pick_best();
+			if (!is_picked_early(move)) return move;
+		}
+		current = 0;
+		stage = Stage::BAD_CAPTURES;
+		[[fallthrough]];
+
+	case Stage::BAD_CAPTURES:
+		if (current < bad_captures.size()) return bad_captures[current++];
+		stage = Stage::DONE;
+		[[fallthrough]];
+
+	default:
+		return Move();
+	}
+}
+
+
+// Swap the best scoring move left in the list to the front of what's left, and return it.
+Move MovePicker::pick_best()
+{
+	int best = current;
+	for (int i = current + 1; i < moves.size(); i++)
+	{
+		if (scores[i] > scores[best]) best = i;
+	}
+	swap(moves[current], moves[best]);
+	swap(scores[current], scores[best]);
+	return moves[current++];
+}
+
+
+// Whether a quiet move was already given out as the table move or a killer.
+bool MovePicker::is_picked_early(Move move) const
+{
+	return move == tt_move || (move == killers[0] && killer_index > 0) || (move == killers[1] && killer_index > 1);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "logic.hpp"
+
+namespace SearchEngine
+{
+    // How often each quiet move has caused a cutoff, by side to move and from and to squares, weighted towards deeper cutoffs.
+    // Scores are halved when any grows too large, so recent cutoffs count for more than old ones.
+    struct HistoryTable
+    {
+        int scores[2][LogicEngine::NUM_SQUARES][LogicEngine::NUM_SQUARES] = {};
+
+        int get(LogicEngine::Colour colour, LogicEngine::Move move) const { return scores[(int)colour][move.from()][move.to()]; }
+        void add(LogicEngine::Colour colour, LogicEngine::Move move, int depth);
+        void clear();
+    };
+
+    bool is_noisy(const LogicEngine::Chessboard& chessboard, LogicEngine::Move move);
+
+    // Hands out the legal moves of a position one at a time, most promising first, in stages:
+    //    the transposition table move, then captures and promotions by most valuable victim and least valuable attacker (MVV-LVA),
+    //    then the killer moves which caused cutoffs in sibling positions, then the other quiet moves by their history scores,
+    //    and last the captures which static exchange evaluation (SEE) finds lose material.
+    // Each stage is only generated once the one before is used up, so a cutoff early on saves generating the rest,
+    // and the best move of a stage is only picked out when it is asked for.
+    // For quiescence search, a picker made without a table move or killers only gives the captures and promotions which don't lose material.
+    class MovePicker
+    {
+    public:
+        MovePicker(const LogicEngine::Chessboard& chessboard, LogicEngine::Move tt_move, const LogicEngine::Move* killers, const HistoryTable& history);
+        MovePicker(const LogicEngine::Chessboard& chessboard, const HistoryTable& history);
+        LogicEngine::Move next();
+
+    private:
+        enum class Stage
+        {
+            TT_MOVE,
+            GENERATE_CAPTURES,
+            CAPTURES,
+            KILLERS,
+            GENERATE_QUIETS,
+            QUIETS,
+            BAD_CAPTURES,
+            DONE
+        };
+
+        LogicEngine::Move pick_best();
+        bool is_picked_early(LogicEngine::Move move) const;
+
+        const LogicEngine::Chessboard& chessboard;
+        const HistoryTable& history;
+        LogicEngine::Move tt_move;
+        LogicEngine::Move killers[2];
+        bool noisy_only = false;
+        Stage stage = Stage::TT_MOVE;
+        LogicEngine::MoveList moves;
+        LogicEngine::MoveList bad_captures;
+        int scores[LogicEngine::MoveList::MAX_MOVES];
+        int current = 0;
+        int killer_index = 0;
+    };
+}
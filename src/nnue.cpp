@@ -0,0 +1,449 @@
+// nnue.cpp
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "nnue.hpp"
+#include "logic.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NNUE_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only compile SSE4.1 and AVX2 intrinsics in functions marked for them, so the rest of the program can run on any x86-64 CPU.
+// MSVC compiles them anywhere.
+#if defined(_MSC_VER)
+#define TARGET(isa)
+#else
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+using namespace std;
+using namespace LogicEngine;
+
+
+const uint32_t FILE_MAGIC = 0x4E4E3343;    // "C3NN"
+const uint32_t FILE_VERSION = 1;
+
+const int HIDDEN_SHIFT = 6;         // hidden layer sums are divided by 64 before clipping
+const int OUTPUT_SCALE = 16;        // and the output by 16 to give centipawns
+const int MAX_NNUE_SCORE = 20000;   // kept well clear of mate scores
+
+unique_ptr<Network> current_network;
+uint64_t current_network_id = 0;    // 0 while there is no network, and a new number for each network set
+uint64_t networks_set = 0;
+
+
+// Scalar layers, for any CPU.
+void add_column_scalar(int16_t* values, const int16_t* column)
+{
+	for (int i = 0; i < NNUE_HALF; i++) values[i] += column[i];
+}
+
+void sub_column_scalar(int16_t* values, const int16_t* column)
+{
+	for (int i = 0; i < NNUE_HALF; i++) values[i] -= column[i];
+}
+
+void clip_scalar(const int16_t* values, uint8_t* output)
+{
+	for (int i = 0; i < NNUE_HALF; i++) output[i] = (uint8_t)clamp<int>(values[i], 0, 127);
+}
+
+void affine_scalar(const uint8_t* input, int in_dims, const int8_t* weights, const int32_t* biases, int32_t* output, int out_dims)
+{
+	for (int o = 0; o < out_dims; o++)
+	{
+		const int8_t* row = weights + (o * in_dims);
+		int32_t sum = biases[o];
+		for (int i = 0; i < in_dims; i++) sum += input[i] * row[i];
+		output[o] = sum;
+	}
+}
+
+
+#if defined(NNUE_X86)
+
+// SSE4.1 layers, 8 accumulator values or 16 inputs at a time.
+// Inputs are at most 127, so the pairs of products summed by maddubs never saturate, and the results match the scalar layers exactly.
+TARGET("sse4.1") void add_column_sse41(int16_t* values, const int16_t* column)
+{
+	for (int i = 0; i < NNUE_HALF; i += 8)
+	{
+		__m128i sum = _mm_add_epi16(_mm_loadu_si128((const __m128i*)(values + i)), _mm_loadu_si128((const __m128i*)(column + i)));
+		_mm_storeu_si128((__m128i*)(values + i), sum);
+	}
+}
+
+TARGET("sse4.1") void sub_column_sse41(int16_t* values, const int16_t* column)
+{
+	for (int i = 0; i < NNUE_HALF; i += 8)
+	{
+		__m128i difference = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)(values + i)), _mm_loadu_si128((const __m128i*)(column + i)));
+		_mm_storeu_si128((__m128i*)(values + i), difference);
+	}
+}
+
+TARGET("sse4.1") void clip_sse41(const int16_t* values, uint8_t* output)
+{
+	const __m128i zero = _mm_setzero_si128();
+	for (int i = 0; i < NNUE_HALF; i += 16)
+	{
+		__m128i packed = _mm_packs_epi16(_mm_loadu_si128((const __m128i*)(values + i)), _mm_loadu_si128((const __m128i*)(values + i + 8)));
+		_mm_storeu_si128((__m128i*)(output + i), _mm_max_epi8(packed, zero));
+	}
+}
+
+TARGET("sse4.1") void affine_sse41(const uint8_t* input, int in_dims, const int8_t* weights, const int32_t* biases, int32_t* output, int out_dims)
+{
+	const __m128i ones = _mm_set1_epi16(1);
+	for (int o = 0; o < out_dims; o++)
+	{
+		const int8_t* row = weights + (o * in_dims);
+		__m128i sum = _mm_setzero_si128();
+		for (int i = 0; i < in_dims; i += 16)
+		{
+			__m128i products = _mm_maddubs_epi16(_mm_loadu_si128((const __m128i*)(input + i)), _mm_loadu_si128((const __m128i*)(row + i)));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+		}
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+		sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+		output[o] = biases[o] + _mm_cvtsi128_si32(sum);
+	}
+}
+
+
+// AVX2 layers, 16 accumulator values or 32 inputs at a time.
+TARGET("avx2") void add_column_avx2(int16_t* values, const int16_t* column)
+{
+	for (int i = 0; i < NNUE_HALF; i += 16)
+	{
+		__m256i sum = _mm256_add_epi16(_mm256_loadu_si256((const __m256i*)(values + i)), _mm256_loadu_si256((const __m256i*)(column + i)));
+		_mm256_storeu_si256((__m256i*)(values + i), sum);
+	}
+}
+
+TARGET("avx2") void sub_column_avx2(int16_t* values, const int16_t* column)
+{
+	for (int i = 0; i < NNUE_HALF; i += 16)
+	{
+		__m256i difference = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i*)(values + i)), _mm256_loadu_si256((const __m256i*)(column + i)));
+		_mm256_storeu_si256((__m256i*)(values + i), difference);
+	}
+}
+
+TARGET("avx2") void clip_avx2(const int16_t* values, uint8_t* output)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	for (int i = 0; i < NNUE_HALF; i += 32)
+	{
+		// packing works within each 128-bit half, so the 64-bit quarters are put back in order afterwards
+		__m256i packed = _mm256_packs_epi16(_mm256_loadu_si256((const __m256i*)(values + i)), _mm256_loadu_si256((const __m256i*)(values + i + 16)));
+		packed = _mm256_permute4x64_epi64(packed, 0xD8);
+		_mm256_storeu_si256((__m256i*)(output + i), _mm256_max_epi8(packed, zero));
+	}
+}
+
+TARGET("avx2") void affine_avx2(const uint8_t* input, int in_dims, const int8_t* weights, const int32_t* biases, int32_t* output, int out_dims)
+{
+	const __m256i ones = _mm256_set1_epi16(1);
+	for (int o = 0; o < out_dims; o++)
+	{
+		const int8_t* row = weights + (o * in_dims);
+		__m256i sum = _mm256_setzero_si256();
+		for (int i = 0; i < in_dims; i += 32)
+		{
+			__m256i products = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(input + i)), _mm256_loadu_si256((const __m256i*)(row + i)));
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+		}
+		__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+		half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+		output[o] = biases[o] + _mm_cvtsi128_si32(half);
+	}
+}
+
+#endif
+
+
+// The versions of each layer in use, switched all together.
+struct Kernels
+{
+	void (*add_column)(int16_t* values, const int16_t* column);
+	void (*sub_column)(int16_t* values, const int16_t* column);
+	void (*clip)(const int16_t* values, uint8_t* output);
+	void (*affine)(const uint8_t* input, int in_dims, const int8_t* weights, const int32_t* biases, int32_t* output, int out_dims);
+};
+
+Kernels kernels_for(SimdPath path)
+{
+#if defined(NNUE_X86)
+	if (path == SimdPath::AVX2) return { add_column_avx2, sub_column_avx2, clip_avx2, affine_avx2 };
+	if (path == SimdPath::SSE41) return { add_column_sse41, sub_column_sse41, clip_sse41, affine_sse41 };
+#endif
+	return { add_column_scalar, sub_column_scalar, clip_scalar, affine_scalar };
+}
+
+
+// Ask the CPU (through CPUID) whether it can run a path. AVX2 also needs the operating system to save the wider registers.
+bool LogicEngine::simd_path_supported(SimdPath path)
+{
+	if (path == SimdPath::SCALAR) return true;
+#if defined(NNUE_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	bool sse41 = (info[2] >> 19) & 1;
+	bool os_saves_avx = ((info[2] >> 27) & 1) && ((info[2] >> 28) & 1) && ((_xgetbv(0) & 6) == 6);
+	__cpuidex(info, 7, 0);
+	bool avx2 = os_saves_avx && ((info[1] >> 5) & 1);
+	return (path == SimdPath::SSE41) ? sse41 : avx2;
+#elif defined(NNUE_X86)
+	__builtin_cpu_init();
+	return (path == SimdPath::SSE41) ? __builtin_cpu_supports("sse4.1") : __builtin_cpu_supports("avx2");
+#else
+	return false;
+#endif
+}
+
+SimdPath best_simd_path()
+{
+	if (simd_path_supported(SimdPath::AVX2)) return SimdPath::AVX2;
+	if (simd_path_supported(SimdPath::SSE41)) return SimdPath::SSE41;
+	return SimdPath::SCALAR;
+}
+
+SimdPath simd_path = best_simd_path();
+Kernels kernels = kernels_for(simd_path);
+
+
+// Switch every layer to a path, if the CPU supports it. Should only be called while nothing is evaluating.
+bool LogicEngine::set_simd_path(SimdPath path)
+{
+	if (!simd_path_supported(path)) return false;
+	simd_path = path;
+	kernels = kernels_for(path);
+	return true;
+}
+
+SimdPath LogicEngine::get_simd_path()
+{
+	return simd_path;
+}
+
+string LogicEngine::simd_path_name(SimdPath path)
+{
+	switch (path)
+	{
+		case SimdPath::AVX2: return "avx2";
+		case SimdPath::SSE41: return "sse4.1";
+		default: return "scalar";
+	}
+}
+
+
+// The HalfKP feature of a piece seen from one side, whose king is on king_sq.
+// Black sees the board mirrored top to bottom, and each side sees its own pieces as the first five kinds.
+int feature_index(int perspective, int king_sq, int c, int p, int sq)
+{
+	int mirror = (perspective == 0) ? 0 : 56;
+	int kind = p + ((c == perspective) ? 0 : 5);
+	return ((((king_sq ^ mirror) * 10) + kind) * 64) + (sq ^ mirror);
+}
+
+
+// Switch a piece's features on or off in each side's view that is up to date.
+// A king moving changes every feature of its own side's view, so that view is left to be worked out again instead.
+void Accumulator::update(int c, int p, int sq, bool on)
+{
+	if (p == (int)Piece::KING - 1)
+	{
+		network_id[c] = 0;
+		return;
+	}
+
+	for (int perspective = 0; perspective < 2; perspective++)
+	{
+		if (network_id[perspective] != current_network_id)
+		{
+			network_id[perspective] = 0;
+			continue;
+		}
+
+		const int16_t* column = &current_network->ft_weights[(size_t)feature_index(perspective, king_sq[perspective], c, p, sq) * NNUE_HALF];
+		if (on)
+			kernels.add_column(values[perspective], column);
+		else
+			kernels.sub_column(values[perspective], column);
+	}
+}
+
+
+// Work out one side's view from scratch, from the pieces on the board.
+void Accumulator::refresh(const Chessboard& chessboard, int perspective)
+{
+	Bitboard kings = chessboard.bitboards.pieces[perspective][(int)Piece::KING - 1];
+	network_id[perspective] = 0;
+	if (current_network == nullptr || kings == 0) return;
+
+	king_sq[perspective] = lsb(kings);
+	copy(current_network->ft_biases.begin(), current_network->ft_biases.end(), values[perspective]);
+	for (int c = 0; c < 2; c++)
+	{
+		for (int p = 0; p < (int)Piece::KING - 1; p++)
+		{
+			Bitboard pieces = chessboard.bitboards.pieces[c][p];
+			while (pieces)
+			{
+				int index = feature_index(perspective, king_sq[perspective], c, p, pop_lsb(&pieces));
+				kernels.add_column(values[perspective], &current_network->ft_weights[(size_t)index * NNUE_HALF]);
+			}
+		}
+	}
+	network_id[perspective] = current_network_id;
+}
+
+
+// Whether each side's view that is in use matches the same view worked out from scratch.
+bool Accumulator::agrees_with(const Accumulator& scratch) const
+{
+	for (int perspective = 0; perspective < 2; perspective++)
+	{
+		if (network_id[perspective] == 0 || network_id[perspective] != current_network_id) continue;
+		if (scratch.network_id[perspective] != network_id[perspective] || scratch.king_sq[perspective] != king_sq[perspective]) return false;
+		if (memcmp(values[perspective], scratch.values[perspective], sizeof(values[perspective])) != 0) return false;
+	}
+	return true;
+}
+
+
+Accumulator LogicEngine::compute_accumulator(const Chessboard& chessboard)
+{
+	Accumulator result;
+	result.refresh(chessboard, 0);
+	result.refresh(chessboard, 1);
+	return result;
+}
+
+
+bool LogicEngine::nnue_can_evaluate(const Chessboard& chessboard)
+{
+	return current_network != nullptr
+		&& chessboard.bitboards.of(Colour::WHITE, Piece::KING) != 0
+		&& chessboard.bitboards.of(Colour::BLACK, Piece::KING) != 0;
+}
+
+
+// Run the network on a board, first working out any view that isn't up to date.
+int LogicEngine::nnue_evaluate(const Chessboard& chessboard)
+{
+	const Network& network = *current_network;
+	Accumulator& accumulator = chessboard.accumulator;
+	for (int perspective = 0; perspective < 2; perspective++)
+		if (accumulator.network_id[perspective] != current_network_id) accumulator.refresh(chessboard, perspective);
+
+	int us = (int)chessboard.active_player;
+	uint8_t input[2 * NNUE_HALF];
+	kernels.clip(accumulator.values[us], input);
+	kernels.clip(accumulator.values[us ^ 1], input + NNUE_HALF);
+
+	int32_t sums[NNUE_HIDDEN];
+	uint8_t hidden1[NNUE_HIDDEN], hidden2[NNUE_HIDDEN];
+	kernels.affine(input, 2 * NNUE_HALF, network.l1_weights.data(), network.l1_biases.data(), sums, NNUE_HIDDEN);
+	for (int i = 0; i < NNUE_HIDDEN; i++) hidden1[i] = (uint8_t)clamp(sums[i] >> HIDDEN_SHIFT, 0, 127);
+	kernels.affine(hidden1, NNUE_HIDDEN, network.l2_weights.data(), network.l2_biases.data(), sums, NNUE_HIDDEN);
+	for (int i = 0; i < NNUE_HIDDEN; i++) hidden2[i] = (uint8_t)clamp(sums[i] >> HIDDEN_SHIFT, 0, 127);
+
+	int32_t output;
+	kernels.affine(hidden2, NNUE_HIDDEN, network.out_weights.data(), network.out_bias.data(), &output, 1);
+	return clamp(output / OUTPUT_SCALE, -MAX_NNUE_SCORE, MAX_NNUE_SCORE);
+}
+
+
+void LogicEngine::set_network(unique_ptr<Network> network)
+{
+	current_network = std::move(network);
+	current_network_id = (current_network != nullptr) ? ++networks_set : 0;
+}
+
+bool LogicEngine::nnue_enabled()
+{
+	return current_network != nullptr;
+}
+
+
+template <typename T>
+void write_values(ofstream& file, const vector<T>& values)
+{
+	file.write((const char*)values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool read_values(ifstream& file, vector<T>& values)
+{
+	file.read((char*)values.data(), values.size() * sizeof(T));
+	return (bool)file;
+}
+
+// The header: the magic number and version, then the size of each layer, which must match the ones this program was built with.
+const uint32_t FILE_HEADER[5] = { FILE_MAGIC, FILE_VERSION, NNUE_FEATURES, NNUE_HALF, NNUE_HIDDEN };
+
+
+bool LogicEngine::save_network(const Network& network, const string& path)
+{
+	ofstream file(path, ios::binary);
+	if (!file) return false;
+
+	file.write((const char*)FILE_HEADER, sizeof(FILE_HEADER));
+	write_values(file, network.ft_biases);
+	write_values(file, network.ft_weights);
+	write_values(file, network.l1_biases);
+	write_values(file, network.l1_weights);
+	write_values(file, network.l2_biases);
+	write_values(file, network.l2_weights);
+	write_values(file, network.out_bias);
+	write_values(file, network.out_weights);
+	return (bool)file;
+}
+
+
+// Load a network from a file and start evaluating with it. Returns false and keeps the network in use if the file can't be read.
+bool LogicEngine::load_network(const string& path)
+{
+	ifstream file(path, ios::binary);
+	uint32_t header[5];
+	if (!file.read((char*)header, sizeof(header)) || !equal(begin(header), end(header), begin(FILE_HEADER))) return false;
+
+	auto network = make_unique<Network>();
+	bool read = read_values(file, network->ft_biases) && read_values(file, network->ft_weights)
+		&& read_values(file, network->l1_biases) && read_values(file, network->l1_weights)
+		&& read_values(file, network->l2_biases) && read_values(file, network->l2_weights)
+		&& read_values(file, network->out_bias) && read_values(file, network->out_weights);
+	if (!read || file.peek() != ifstream::traits_type::eof()) return false;
+
+	set_network(std::move(network));
+	return true;
+}
+
+
+// A network of small random weights from a seed, for testing and timing the evaluation without a trained network.
+unique_ptr<Network> LogicEngine::random_network(uint64_t seed)
+{
+	Key state = seed;
+	auto random = [&state](int low, int high) { return low + (int)(splitmix64(&state) % (uint64_t)(high - low + 1)); };
+
+	auto network = make_unique<Network>();
+	for (int16_t& bias : network->ft_biases) bias = (int16_t)random(0, 64);
+	for (int16_t& weight : network->ft_weights) weight = (int16_t)random(-8, 8);
+	for (int32_t& bias : network->l1_biases) bias = random(-512, 512);
+	for (int8_t& weight : network->l1_weights) weight = (int8_t)random(-16, 16);
+	for (int32_t& bias : network->l2_biases) bias = random(-512, 512);
+	for (int8_t& weight : network->l2_weights) weight = (int8_t)random(-32, 32);
+	network->out_bias[0] = random(-256, 256);
+	for (int8_t& weight : network->out_weights) weight = (int8_t)random(-64, 64);
+	return network;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace LogicEngine
+{
+    class Chessboard;
+
+    // An efficiently updatable neural network (NNUE) evaluation, used in place of the piece-square tables when a network is loaded.
+    //
+    // The inputs are HalfKP features, seen from each side in turn: one for every piece other than a king, by its square,
+    // its type and colour, and the square of the king of the side looking. Each side's view is summed through the first layer
+    // (the feature transformer) into its accumulator. A move only switches a few features on or off, so the board keeps both
+    // accumulators up to date as pieces move, adding and subtracting columns of weights, rather than summing every feature again.
+    // A king move changes every feature of its own side's view, so that view is worked out again the next time the board is evaluated.
+    //
+    // The two accumulators, the side to move's first, are clipped to 0-127 and pass through two small hidden layers to the score.
+    // Everything after the inputs is integer arithmetic, so the scalar, SSE4.1 and AVX2 versions of each layer give identical results.
+    // Black's view is the board mirrored top to bottom, so swapping the colours of a position swaps the two views: the side to move
+    // then sees exactly what the other side saw before.
+    const int NNUE_FEATURES = 64 * 10 * 64;     // king square, piece type and colour (kings left out), piece square
+    const int NNUE_HALF = 256;                  // size of each side's accumulator
+    const int NNUE_HIDDEN = 32;                 // size of each hidden layer
+
+    // The weights of a network. The first layer's are 16-bit and the rest 8-bit, with 32-bit biases.
+    // Each layer's weights are stored by output, so a row holds the weights of all the inputs to one output,
+    // except for the feature transformer's, which are stored by feature so that a feature's weights are one column to add.
+    struct Network
+    {
+        std::vector<int16_t> ft_biases = std::vector<int16_t>(NNUE_HALF);
+        std::vector<int16_t> ft_weights = std::vector<int16_t>((size_t)NNUE_FEATURES * NNUE_HALF);
+        std::vector<int32_t> l1_biases = std::vector<int32_t>(NNUE_HIDDEN);
+        std::vector<int8_t> l1_weights = std::vector<int8_t>(NNUE_HIDDEN * 2 * NNUE_HALF);
+        std::vector<int32_t> l2_biases = std::vector<int32_t>(NNUE_HIDDEN);
+        std::vector<int8_t> l2_weights = std::vector<int8_t>(NNUE_HIDDEN * NNUE_HIDDEN);
+        std::vector<int32_t> out_bias = std::vector<int32_t>(1);
+        std::vector<int8_t> out_weights = std::vector<int8_t>(NNUE_HIDDEN);
+    };
+
+    // Each side's first layer sums for a board. Kept on the board and updated by set_square() as pieces move.
+    // A side's view is only used while it was worked out with the network loaded now; otherwise, and after its king moves,
+    // it is worked out again from scratch when next needed.
+    struct Accumulator
+    {
+        int16_t values[2][NNUE_HALF];
+        int king_sq[2] = { -1, -1 };
+        uint64_t network_id[2] = {};    // the network each side's values were worked out with, or 0 if they need working out
+
+        // Switch a piece's features on or off, taking its colour and piece as indices like PsqtScore.
+        void add(int c, int p, int sq) { if (network_id[0] | network_id[1]) update(c, p, sq, true); }
+        void remove(int c, int p, int sq) { if (network_id[0] | network_id[1]) update(c, p, sq, false); }
+        void refresh(const Chessboard& chessboard, int perspective);
+        bool agrees_with(const Accumulator& scratch) const;
+
+    private:
+        void update(int c, int p, int sq, bool on);
+    };
+
+    // The network in use is shared by every board and thread, so should only be changed while nothing is searching.
+    // Files hold the layers in the order of Network's members after a short header, as little-endian integers.
+    bool load_network(const std::string& path);
+    bool save_network(const Network& network, const std::string& path);
+    void set_network(std::unique_ptr<Network> network);    // nullptr goes back to evaluating with the piece-square tables
+    std::unique_ptr<Network> random_network(uint64_t seed);
+    bool nnue_enabled();
+
+    // Both accumulators worked out from scratch, for checking the updates made as pieces move.
+    Accumulator compute_accumulator(const Chessboard& chessboard);
+
+    // Score a position with the network, in centipawns from the side to move's point of view.
+    // Needs a network to be loaded and both kings to be on the board.
+    bool nnue_can_evaluate(const Chessboard& chessboard);
+    int nnue_evaluate(const Chessboard& chessboard);
+
+    // The instruction sets the layers can be computed with. The best the CPU supports is picked when the program starts,
+    // and the others can be chosen for comparing them.
+    enum class SimdPath
+    {
+        SCALAR,
+        SSE41,
+        AVX2
+    };
+
+    bool simd_path_supported(SimdPath path);
+    bool set_simd_path(SimdPath path);
+    SimdPath get_simd_path();
+    std::string simd_path_name(SimdPath path);
+}
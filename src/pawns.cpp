@@ -0,0 +1,135 @@
+// pawns.cpp
+
+#include "pawns.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+
+
+const int DOUBLED_MG = -10, DOUBLED_EG = -20;
+const int ISOLATED_MG = -10, ISOLATED_EG = -15;
+const int BACKWARD_MG = -8, BACKWARD_EG = -10;
+
+// Bonuses for a passed pawn by how many rows it has advanced from its own back rank
+const int PASSED_MG[8] = { 0, 5, 10, 15, 25, 40, 60, 0 };
+const int PASSED_EG[8] = { 0, 10, 20, 35, 60, 90, 130, 0 };
+
+const Bitboard FILE_A = 0x0101010101010101ULL;
+
+
+// Masks of squares relative to a pawn, by colour and square, built at compile time.
+struct PawnMasks
+{
+	Bitboard front_span[2][NUM_SQUARES];	// the squares ahead of the pawn on its own and neighbouring files: no enemy pawns there means it is passed
+	Bitboard support[2][NUM_SQUARES];		// the squares beside and behind the pawn on neighbouring files, from where own pawns could defend it
+	Bitboard adjacent_files[8];
+};
+
+constexpr PawnMasks make_pawn_masks()
+{
+	PawnMasks masks = {};
+	for (int col = 0; col < 8; col++)
+	{
+		if (col > 0) masks.adjacent_files[col] |= FILE_A << (col - 1);
+		if (col < 7) masks.adjacent_files[col] |= FILE_A << (col + 1);
+	}
+
+	for (int sq = 0; sq < NUM_SQUARES; sq++)
+	{
+		Bitboard files = masks.adjacent_files[square_col(sq)] | (FILE_A << square_col(sq));
+		for (int row = 0; row < 8; row++)
+		{
+			Bitboard rank = 0xFFULL << (row * 8);
+			if (row > square_row(sq)) masks.front_span[0][sq] |= files & rank;
+			if (row < square_row(sq)) masks.front_span[1][sq] |= files & rank;
+			if (row <= square_row(sq)) masks.support[0][sq] |= masks.adjacent_files[square_col(sq)] & rank;
+			if (row >= square_row(sq)) masks.support[1][sq] |= masks.adjacent_files[square_col(sq)] & rank;
+		}
+	}
+	return masks;
+}
+
+constexpr PawnMasks PAWN_MASKS = make_pawn_masks();
+
+
+// Work out the pawn structure of the board from scratch.
+PawnEntry SearchEngine::evaluate_pawns(const Chessboard& chessboard)
+{
+	PawnEntry entry;
+	entry.key = chessboard.pawn_key;
+
+	for (int c = 0; c < 2; c++)
+	{
+		Colour colour = (Colour)c;
+		Colour opp_colour = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+		Bitboard own_pawns = chessboard.bitboards.of(colour, Piece::PAWN);
+		Bitboard enemy_pawns = chessboard.bitboards.of(opp_colour, Piece::PAWN);
+
+		for (int col = 0; col < 8; col++)
+		{
+			int on_file = pop_count(own_pawns & (FILE_A << col));
+			if (on_file > 1)
+			{
+				entry.mg[c] += DOUBLED_MG * (on_file - 1);
+				entry.eg[c] += DOUBLED_EG * (on_file - 1);
+			}
+		}
+
+		Bitboard pawns = own_pawns;
+		while (pawns)
+		{
+			int sq = pop_lsb(&pawns);
+			int advanced = (colour == Colour::WHITE) ? square_row(sq) : 7 - square_row(sq);
+
+			if (!(PAWN_MASKS.front_span[c][sq] & enemy_pawns))
+			{
+				entry.passed[c] |= square_bb(sq);
+				entry.mg[c] += PASSED_MG[advanced];
+				entry.eg[c] += PASSED_EG[advanced];
+			}
+
+			if (!(PAWN_MASKS.adjacent_files[square_col(sq)] & own_pawns))
+			{
+				entry.mg[c] += ISOLATED_MG;
+				entry.eg[c] += ISOLATED_EG;
+			}
+			// a backward pawn can't be defended by its neighbours, and can't safely step forward either
+			else if (!(PAWN_MASKS.support[c][sq] & own_pawns) && advanced < 7)
+			{
+				int stop_sq = (colour == Colour::WHITE) ? sq + 8 : sq - 8;
+				if (PAWN_ATTACKS[c][stop_sq] & enemy_pawns)
+				{
+					entry.mg[c] += BACKWARD_MG;
+					entry.eg[c] += BACKWARD_EG;
+				}
+			}
+		}
+	}
+
+	return entry;
+}
+
+
+PawnTable::PawnTable(size_t num_entries)
+{
+	size_t size = 1;
+	while (size * 2 <= num_entries) size *= 2;
+
+	entries.resize(size);
+	mask = size - 1;
+}
+
+
+// Look up the pawn structure of the board, working it out and storing it if it isn't in the table.
+const PawnEntry& PawnTable::probe(const Chessboard& chessboard)
+{
+	probes++;
+	PawnEntry& entry = entries[chessboard.pawn_key & mask];
+	if (entry.key == chessboard.pawn_key)
+		hits++;
+	else
+		entry = evaluate_pawns(chessboard);
+
+	return entry;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "logic.hpp"
+
+namespace SearchEngine
+{
+    // What the pawn structure is worth to each side: penalties for doubled, isolated and backward pawns, and bonuses for passed pawns.
+    // It depends on nothing but where the pawns stand, so can be looked up by the board's pawn key.
+    struct PawnEntry
+    {
+        LogicEngine::Key key = 0;
+        int mg[2] = {};                         // per colour, each from that colour's point of view
+        int eg[2] = {};
+        LogicEngine::Bitboard passed[2] = {};   // each colour's passed pawns
+    };
+
+    PawnEntry evaluate_pawns(const LogicEngine::Chessboard& chessboard);
+
+    // A cache of pawn structure evaluations. Positions in a search mostly share their pawns with the positions around them,
+    // so most lookups find the structure already worked out.
+    // Each searcher has its own table rather than sharing one, so parallel searches never contend for it or need to guard it.
+    // A position without pawns has a pawn key of 0, which matches the empty entries, and an empty structure is worth nothing anyway.
+    class PawnTable
+    {
+    public:
+        PawnTable(size_t num_entries = 16384);
+        const PawnEntry& probe(const LogicEngine::Chessboard& chessboard);
+        uint64_t get_probes() const { return probes; }
+        uint64_t get_hits() const { return hits; }
+        void clear_stats() { probes = hits = 0; }
+
+    private:
+        std::vector<PawnEntry> entries;
+        size_t mask;    // the number of entries is a power of two, so the key's low bits pick the entry
+        uint64_t probes = 0;
+        uint64_t hits = 0;
+    };
+}
@@ -0,0 +1,122 @@
+// perft.cpp
+
+#include <thread>
+
+#include "perft.hpp"
+#include "movegen.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+
+
+// Known node counts from https://www.chessprogramming.org/Perft_Results
+const vector<PerftPosition> LogicEngine::PERFT_POSITIONS = {
+	{ "Starting position",
+	  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	  { 20, 400, 8902, 197281, 4865609, 119060324 } },
+	{ "Kiwipete",
+	  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	  { 48, 2039, 97862, 4085603, 193690690 } },
+	{ "Position 3",
+	  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	  { 14, 191, 2812, 43238, 674624, 11030083 } },
+	{ "Position 4",
+	  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	  { 6, 264, 9467, 422333, 15833292 } },
+	{ "Position 5",
+	  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	  { 44, 1486, 62379, 2103487, 89941194 } },
+	{ "Position 6",
+	  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	  { 46, 2079, 89890, 3894594, 164075551 } }
+};
+
+
+// Size the table to the largest power of two number of entries that fits in the given number of megabytes.
+PerftTable::PerftTable(size_t size_mb)
+{
+	size_t num_entries = 1;
+	while (num_entries * 2 * sizeof(Entry) <= size_mb * 1024 * 1024) num_entries *= 2;
+
+	entries = std::make_unique<Entry[]>(num_entries);
+	mask = num_entries - 1;
+}
+
+
+// Look up the count for a position at a depth, returning false if it isn't in the table.
+bool PerftTable::probe(Key key, int depth, uint64_t* nodes) const
+{
+	const Entry& entry = entries[key & mask];
+	uint64_t data = entry.data.load(memory_order_relaxed);
+	uint64_t key_xor_data = entry.key_xor_data.load(memory_order_relaxed);
+
+	if ((key_xor_data ^ data) != key || (int)(data & 0xFF) != depth) return false;
+	*nodes = data >> 8;
+	return true;
+}
+
+
+// Store the count for a position at a depth, replacing whatever was in its entry.
+void PerftTable::store(Key key, int depth, uint64_t nodes)
+{
+	Entry& entry = entries[key & mask];
+	uint64_t data = (nodes << 8) | (uint64_t)depth;
+
+	entry.key_xor_data.store(key ^ data, memory_order_relaxed);
+	entry.data.store(data, memory_order_relaxed);
+}
+
+
+// Count the positions reachable from the board in the given number of moves, making and unmaking each move in turn.
+// At the last move there is no need to make the moves, as the number of legal moves is the number of positions they reach.
+// If a table is given, counts are looked up from and stored to it.
+uint64_t LogicEngine::perft(Chessboard* cb, int depth, PerftTable* table)
+{
+	uint64_t nodes = 0;
+	if (depth > 1 && table != nullptr && table->probe(cb->key, depth, &nodes)) return nodes;
+
+	MoveList moves = get_all_legal_moves(*cb);
+	if (depth <= 1) return (depth == 1) ? moves.size() : 1;
+
+	for (int i = 0; i < moves.size(); i++)
+	{
+		UndoInfo undo = cb->do_move(moves[i]);
+		nodes += perft(cb, depth - 1, table);
+		cb->undo_move(undo);
+	}
+
+	if (table != nullptr) table->store(cb->key, depth, nodes);
+	return nodes;
+}
+
+
+// Run perft from each legal move of the board, giving the count below each move.
+// Comparing these against another move generator narrows a wrong count down to the move that causes it.
+// The root moves are shared out between threads, each with its own copy of the board, taking the next unclaimed move when done.
+// The counts are written back by move, so the results are the same whatever the number of threads.
+vector<tuple<Move, uint64_t>> LogicEngine::perft_divide(Chessboard* cb, int depth, int threads, PerftTable* table)
+{
+	MoveList moves = get_all_legal_moves(*cb);
+	vector<uint64_t> counts(moves.size(), 0);
+	atomic<int> next_move = 0;
+
+	auto count_moves = [&](Chessboard board)
+	{
+		for (int i = next_move++; i < moves.size(); i = next_move++)
+		{
+			UndoInfo undo = board.do_move(moves[i]);
+			counts[i] = perft(&board, depth - 1, table);
+			board.undo_move(undo);
+		}
+	};
+
+	vector<thread> workers;
+	for (int t = 1; t < threads; t++) workers.push_back(thread(count_moves, *cb));
+	count_moves(*cb);
+	for (int t = 0; t < workers.size(); t++) workers[t].join();
+
+	vector<tuple<Move, uint64_t>> results;
+	for (int i = 0; i < moves.size(); i++) results.push_back({ moves[i], counts[i] });
+
+	return results;
+}
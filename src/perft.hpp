@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+#include "logic.hpp"
+
+namespace LogicEngine
+{
+    // Perft counts the positions reachable from a position in a given number of moves.
+    // Comparing the counts against known values finds move generation bugs, and timing it measures move generation speed.
+
+    // A position with the node counts perft should find from it, starting at depth 1.
+    struct PerftPosition
+    {
+        std::string name;
+        std::string fen;
+        std::vector<uint64_t> node_counts;
+    };
+
+    // The standard perft test positions, with their known node counts.
+    extern const std::vector<PerftPosition> PERFT_POSITIONS;
+
+    // A hash table of perft counts keyed by position and depth, so positions reached by different move orders are only counted once.
+    // It is shared between perft threads without locks: each entry stores its key XORed with its data,
+    // so an entry torn by two threads writing at once fails the key check on probing instead of giving a wrong count.
+    class PerftTable
+    {
+    public:
+        PerftTable(size_t size_mb);
+        bool probe(Key key, int depth, uint64_t* nodes) const;
+        void store(Key key, int depth, uint64_t nodes);
+
+    private:
+        struct Entry
+        {
+            std::atomic<uint64_t> key_xor_data{ 0 };
+            std::atomic<uint64_t> data{ 0 };    // node count in the upper 56 bits, depth in the lower 8
+        };
+
+        std::unique_ptr<Entry[]> entries;
+        size_t mask;    // the number of entries is a power of two, so the key's low bits pick the entry
+    };
+
+    uint64_t perft(Chessboard* cb, int depth, PerftTable* table = nullptr);
+    std::vector<std::tuple<Move, uint64_t>> perft_divide(Chessboard* cb, int depth, int threads = 1, PerftTable* table = nullptr);
+}
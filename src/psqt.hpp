@@ -0,0 +1,157 @@
+#pragma once
+
+namespace LogicEngine
+{
+    // Piece-square tables: what each piece is worth on each square, once for the midgame and once for the endgame.
+    // The board keeps the sum of the entries for its pieces as they move, so evaluating a position only blends the two sums.
+
+    // The game phase counts the minor and major pieces left on the board, weighted by value: 24 at the start, falling to 0.
+    const int MAX_PHASE = 24;
+
+    // Tables are indexed by piece (skipping Piece::EMPTY: pawn, rook, knight, bishop, queen, king) and laid out as the board looks
+    // from white's side, with a8 first and h1 last. White's entries are read from them flipped top to bottom, black's as they are.
+    constexpr int MATERIAL_MG[6] = { 100, 500, 320, 330, 900, 0 };
+    constexpr int MATERIAL_EG[6] = { 120, 540, 300, 320, 950, 0 };
+    constexpr int PHASE_WEIGHTS[6] = { 0, 2, 1, 1, 4, 0 };
+
+    constexpr int PLACEMENT_MG[6][64] = {
+        {   0,   0,   0,   0,   0,   0,   0,   0,
+           50,  50,  50,  50,  50,  50,  50,  50,
+           10,  10,  20,  30,  30,  20,  10,  10,
+            5,   5,  10,  25,  25,  10,   5,   5,
+            0,   0,   0,  20,  20,   0,   0,   0,
+            5,  -5, -10,   0,   0, -10,  -5,   5,
+            5,  10,  10, -20, -20,  10,  10,   5,
+            0,   0,   0,   0,   0,   0,   0,   0 },
+        {   0,   0,   0,   0,   0,   0,   0,   0,
+            5,  10,  10,  10,  10,  10,  10,   5,
+           -5,   0,   0,   0,   0,   0,   0,  -5,
+           -5,   0,   0,   0,   0,   0,   0,  -5,
+           -5,   0,   0,   0,   0,   0,   0,  -5,
+           -5,   0,   0,   0,   0,   0,   0,  -5,
+           -5,   0,   0,   0,   0,   0,   0,  -5,
+            0,   0,   0,   5,   5,   0,   0,   0 },
+        { -50, -40, -30, -30, -30, -30, -40, -50,
+          -40, -20,   0,   0,   0,   0, -20, -40,
+          -30,   0,  10,  15,  15,  10,   0, -30,
+          -30,   5,  15,  20,  20,  15,   5, -30,
+          -30,   0,  15,  20,  20,  15,   0, -30,
+          -30,   5,  10,  15,  15,  10,   5, -30,
+          -40, -20,   0,   5,   5,   0, -20, -40,
+          -50, -40, -30, -30, -30, -30, -40, -50 },
+        { -20, -10, -10, -10, -10, -10, -10, -20,
+          -10,   0,   0,   0,   0,   0,   0, -10,
+          -10,   0,   5,  10,  10,   5,   0, -10,
+          -10,   5,   5,  10,  10,   5,   5, -10,
+          -10,   0,  10,  10,  10,  10,   0, -10,
+          -10,  10,  10,  10,  10,  10,  10, -10,
+          -10,   5,   0,   0,   0,   0,   5, -10,
+          -20, -10, -10, -10, -10, -10, -10, -20 },
+        { -20, -10, -10,  -5,  -5, -10, -10, -20,
+          -10,   0,   0,   0,   0,   0,   0, -10,
+          -10,   0,   5,   5,   5,   5,   0, -10,
+           -5,   0,   5,   5,   5,   5,   0,  -5,
+           -5,   0,   5,   5,   5,   5,   0,  -5,
+          -10,   5,   5,   5,   5,   5,   0, -10,
+          -10,   0,   5,   0,   0,   0,   0, -10,
+          -20, -10, -10,  -5,  -5, -10, -10, -20 },
+        { -30, -40, -40, -50, -50, -40, -40, -30,
+          -30, -40, -40, -50, -50, -40, -40, -30,
+          -30, -40, -40, -50, -50, -40, -40, -30,
+          -30, -40, -40, -50, -50, -40, -40, -30,
+          -20, -30, -30, -40, -40, -30, -30, -20,
+          -10, -20, -20, -20, -20, -20, -20, -10,
+           20,  20,   0,   0,   0,   0,  20,  20,
+           20,  30,  10,   0,   0,  10,  30,  20 }
+    };
+
+    // In the endgame, passed pawns matter more the closer they are to promoting, and the king should come to the centre.
+    constexpr int PLACEMENT_EG[6][64] = {
+        {   0,   0,   0,   0,   0,   0,   0,   0,
+           80,  80,  80,  80,  80,  80,  80,  80,
+           50,  50,  50,  50,  50,  50,  50,  50,
+           30,  30,  30,  30,  30,  30,  30,  30,
+           20,  20,  20,  20,  20,  20,  20,  20,
+           10,  10,  10,  10,  10,  10,  10,  10,
+            0,   0,   0,   0,   0,   0,   0,   0,
+            0,   0,   0,   0,   0,   0,   0,   0 },
+        {   0,   0,   0,   0,   0,   0,   0,   0,
+            5,   5,   5,   5,   5,   5,   5,   5,
+            0,   0,   0,   0,   0,   0,   0,   0,
+            0,   0,   0,   0,   0,   0,   0,   0,
+            0,   0,   0,   0,   0,   0,   0,   0,
+            0,   0,   0,   0,   0,   0,   0,   0,
+            0,   0,   0,   0,   0,   0,   0,   0,
+            0,   0,   0,   0,   0,   0,   0,   0 },
+        { -50, -40, -30, -30, -30, -30, -40, -50,
+          -40, -20,   0,   0,   0,   0, -20, -40,
+          -30,   0,  10,  15,  15,  10,   0, -30,
+          -30,   5,  15,  20,  20,  15,   5, -30,
+          -30,   0,  15,  20,  20,  15,   0, -30,
+          -30,   5,  10,  15,  15,  10,   5, -30,
+          -40, -20,   0,   5,   5,   0, -20, -40,
+          -50, -40, -30, -30, -30, -30, -40, -50 },
+        { -20, -10, -10, -10, -10, -10, -10, -20,
+          -10,   0,   0,   0,   0,   0,   0, -10,
+          -10,   0,   5,  10,  10,   5,   0, -10,
+          -10,   5,   5,  10,  10,   5,   5, -10,
+          -10,   0,  10,  10,  10,  10,   0, -10,
+          -10,  10,  10,  10,  10,  10,  10, -10,
+          -10,   5,   0,   0,   0,   0,   5, -10,
+          -20, -10, -10, -10, -10, -10, -10, -20 },
+        { -20, -10, -10,  -5,  -5, -10, -10, -20,
+          -10,   0,   0,   0,   0,   0,   0, -10,
+          -10,   0,   5,   5,   5,   5,   0, -10,
+           -5,   0,   5,   5,   5,   5,   0,  -5,
+           -5,   0,   5,   5,   5,   5,   0,  -5,
+          -10,   0,   5,   5,   5,   5,   0, -10,
+          -10,   0,   0,   0,   0,   0,   0, -10,
+          -20, -10, -10,  -5,  -5, -10, -10, -20 },
+        { -50, -40, -30, -20, -20, -30, -40, -50,
+          -30, -20, -10,   0,   0, -10, -20, -30,
+          -30, -10,  20,  30,  30,  20, -10, -30,
+          -30, -10,  30,  40,  40,  30, -10, -30,
+          -30, -10,  30,  40,  40,  30, -10, -30,
+          -30, -10,  20,  30,  30,  20, -10, -30,
+          -30, -30,   0,   0,   0,   0, -30, -30,
+          -50, -30, -30, -30, -30, -30, -30, -50 }
+    };
+
+    // The material and placement of every piece on every square, added together and signed so white's count up and black's down.
+    // Indexed by colour, piece (skipping Piece::EMPTY) and square, like the bitboards and Zobrist keys.
+    struct PsqtTables
+    {
+        int mg[2][6][64];
+        int eg[2][6][64];
+    };
+
+    constexpr PsqtTables make_psqt_tables()
+    {
+        PsqtTables tables = {};
+        for (int p = 0; p < 6; p++)
+        {
+            for (int sq = 0; sq < 64; sq++)
+            {
+                tables.mg[0][p][sq] = MATERIAL_MG[p] + PLACEMENT_MG[p][sq ^ 56];
+                tables.eg[0][p][sq] = MATERIAL_EG[p] + PLACEMENT_EG[p][sq ^ 56];
+                tables.mg[1][p][sq] = -(MATERIAL_MG[p] + PLACEMENT_MG[p][sq]);
+                tables.eg[1][p][sq] = -(MATERIAL_EG[p] + PLACEMENT_EG[p][sq]);
+            }
+        }
+        return tables;
+    }
+
+    inline constexpr PsqtTables PSQT = make_psqt_tables();
+
+    // The running sum of the table entries for the pieces on a board, from white's point of view, and the game phase.
+    struct PsqtScore
+    {
+        int mg = 0;
+        int eg = 0;
+        int phase = 0;
+
+        void add(int colour, int piece, int sq) { mg += PSQT.mg[colour][piece][sq]; eg += PSQT.eg[colour][piece][sq]; phase += PHASE_WEIGHTS[piece]; }
+        void remove(int colour, int piece, int sq) { mg -= PSQT.mg[colour][piece][sq]; eg -= PSQT.eg[colour][piece][sq]; phase -= PHASE_WEIGHTS[piece]; }
+        bool operator==(const PsqtScore& rhs) const { return mg == rhs.mg && eg == rhs.eg && phase == rhs.phase; }
+    };
+}
@@ -0,0 +1,528 @@
+// search.cpp
+
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <cmath>
+#include <array>
+
+#include "search.hpp"
+#include "evaluate.hpp"
+#include "movegen.hpp"
+#include "movepick.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+
+
+// The clock is only read every this many nodes, as reading it costs more than searching a node.
+const uint64_t CLOCK_CHECK_INTERVAL = 2048;
+
+// Delta pruning skips a capture in quiescence search when even winning the captured piece, plus this margin, can't raise alpha.
+const int DELTA_MARGIN = 200;
+
+// Reverse futility pruning cuts off at up to this depth when the static evaluation beats beta by the margin for each ply left.
+const int REVERSE_FUTILITY_DEPTH = 6;
+const int REVERSE_FUTILITY_MARGIN = 80;
+
+// Futility pruning skips quiet moves at up to this depth when the static evaluation plus the margin for each ply left can't reach alpha.
+const int FUTILITY_DEPTH = 3;
+const int FUTILITY_MARGIN = 100;
+
+// A null move is searched this many plies shallower, and one more for every 6 plies of depth, from at least the minimum depth.
+// From the verification depth, a null move cutoff is only taken once a search without null moves agrees.
+const int NULL_MOVE_MIN_DEPTH = 3;
+const int NULL_MOVE_REDUCTION = 3;
+const int NULL_MOVE_VERIFY_DEPTH = 5;
+
+// Late move reductions start after this many moves have been searched at this depth or more.
+// Quiet moves with history scores past the threshold have proved themselves before, so are reduced a ply less.
+const int LMR_MIN_DEPTH = 3;
+const int LMR_MIN_MOVES = 3;
+const int LMR_HISTORY_THRESHOLD = 2048;
+
+// How far late moves are reduced, by depth and number of moves searched: the later the move and the deeper the search, the more.
+const auto LMR_REDUCTIONS = []()
+{
+	array<array<int, 64>, 64> table = {};
+	for (int depth = 1; depth < 64; depth++)
+		for (int moves = 1; moves < 64; moves++)
+			table[depth][moves] = (int)(0.75 + log(depth) * log(moves) / 2.25);
+	return table;
+}();
+
+// Which depths each helper skips, cycling through the rows by thread index. Helper i skips a depth
+// when (depth + SKIP_PHASE[i]) / SKIP_SIZE[i] is odd, so helpers skip runs of 1 to 4 depths at different offsets.
+const int SKIP_ROWS = 20;
+const int SKIP_SIZE[SKIP_ROWS] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+const int SKIP_PHASE[SKIP_ROWS] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+
+// Mate scores count plies from the root, but the same position can be reached at any ply,
+// so they are stored in the transposition table counting plies from the position instead.
+int score_to_tt(int score, int ply)
+{
+	if (score >= MATE_SCORE - MAX_PLY) return score + ply;
+	if (score <= -MATE_SCORE + MAX_PLY) return score - ply;
+	return score;
+}
+
+
+int score_from_tt(int score, int ply)
+{
+	if (score >= MATE_SCORE - MAX_PLY) return score - ply;
+	if (score <= -MATE_SCORE + MAX_PLY) return score + ply;
+	return score;
+}
+
+
+// Search the board to deeper and deeper depths until a limit is reached, returning the last iteration to complete.
+// Each iteration starts from the best move of the one before, and is passed to on_iteration as it completes.
+SearchInfo Searcher::search(Chessboard* cb, const SearchLimits& search_limits, function<void(const SearchInfo&)> on_iteration,
+	const vector<Key>& keys_before_root)
+{
+	limits = search_limits;
+	game_keys = keys_before_root;
+	start = chrono::steady_clock::now();
+	time.start(limits.time_ms, limits.clock_ms, limits.increment_ms, limits.moves_to_go);
+	stopped = false;
+	nodes = 0;
+	qnodes = 0;
+	tt_probes = 0;
+	tt_hits = 0;
+	cutoffs = 0;
+	first_move_cutoffs = 0;
+	root_best = Move();
+	history.clear();
+	pawn_table.clear_stats();
+	for (Move* ply_killers : killers) ply_killers[0] = ply_killers[1] = Move();
+
+	SearchInfo info;
+	uint64_t last_iteration_nodes = 0;
+	int max_depth = (limits.depth > 0) ? min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+	for (iteration_depth = 1; iteration_depth <= max_depth; iteration_depth++)
+	{
+		if (iteration_depth > 1 && iteration_depth < max_depth && skip_depth(iteration_depth)) continue;
+
+		uint64_t nodes_before = get_nodes();
+		int score = negamax(cb, iteration_depth, 0, -INFINITE_SCORE, INFINITE_SCORE);
+		if (stopped) break;
+
+		uint64_t iteration_nodes = get_nodes() - nodes_before;
+		info.branching_factor = (last_iteration_nodes > 0) ? (double)iteration_nodes / last_iteration_nodes : 0;
+		last_iteration_nodes = iteration_nodes;
+
+		info.depth = iteration_depth;
+		info.score = score;
+		info.nodes = get_nodes();
+		info.qnodes = qnodes;
+		info.seconds = elapsed_seconds();
+		info.nps = (info.seconds > 0) ? (uint64_t)(info.nodes / info.seconds) : 0;
+		info.pv.assign(pv_table[0], pv_table[0] + pv_length[0]);
+		info.tt_probes = tt_probes;
+		info.tt_hits = tt_hits;
+		info.cutoffs = cutoffs;
+		info.first_move_cutoffs = first_move_cutoffs;
+		info.hashfull = (tt != nullptr) ? tt->hashfull() : 0;
+		info.pawn_probes = pawn_table.get_probes();
+		info.pawn_hits = pawn_table.get_hits();
+		root_best = info.best_move();
+
+		if (on_iteration) on_iteration(info);
+
+		// no deeper search can change a forced mate that has been seen all the way to the end, or a position without moves
+		if (stop_requested || info.pv.empty() || (is_mate_score(score) && MATE_SCORE - abs(score) <= iteration_depth)) break;
+
+		// another iteration would likely run past the time the move should take, unless the move is still in doubt
+		time.update(root_best, score);
+		if (!pondering && time.soft_limit_reached()) break;
+	}
+
+	pondering = false;
+	return info;
+}
+
+
+// Whether a side has any pieces besides pawns and its king. Without them, zugzwang is likely enough that passing can't be trusted.
+bool has_non_pawn_material(const Chessboard& cb, Colour colour)
+{
+	return (cb.bitboards.occupancy[(int)colour] & ~cb.bitboards.of(colour, Piece::PAWN) & ~cb.bitboards.of(colour, Piece::KING)) != 0;
+}
+
+
+// Score the board to the given depth, returning a score within alpha and beta if the true score lies between them,
+// and otherwise a bound on the score on the side of the window it falls.
+int Searcher::negamax(Chessboard* cb, int depth, int ply, int alpha, int beta)
+{
+	pv_length[ply] = ply;
+	path_keys[ply] = cb->key;
+	null_moves[ply] = false;
+
+	bool in_check = is_king_attacked(*cb, cb->active_player);
+	if (in_check && pruning.check_extensions && ply > 0) depth++;
+	if (depth <= 0) return quiescence(cb, ply, alpha, beta);
+	if (check_limits()) return 0;
+	count_node();
+
+	if (ply > 0 && (cb->halfmove_clock >= 100 || is_repetition(*cb, ply))) return 0;
+	if (ply >= MAX_PLY - 1) return evaluate(*cb, &pawn_table);
+
+	// a stored result searched at least as deep ends the search here if it falls outside the window,
+	// but not if it falls inside, as that would cut the principal variation short
+	TTEntry entry = { Move(), 0, 0, Bound::NONE };
+	if (tt != nullptr)
+	{
+		tt_probes++;
+		if (tt->probe(cb->key, &entry))
+		{
+			tt_hits++;
+			int tt_score = score_from_tt(entry.score, ply);
+			if (ply > 0 && entry.depth >= depth)
+			{
+				if (entry.bound != Bound::UPPER && tt_score >= beta) return tt_score;
+				if (entry.bound != Bound::LOWER && tt_score <= alpha) return tt_score;
+			}
+		}
+	}
+
+	// only nodes searched with a null window are pruned, so the principal variation is always searched in full
+	bool pv_node = beta - alpha > 1;
+	int static_eval = 0;
+	if (!pv_node && !in_check)
+	{
+		static_eval = evaluate(*cb, &pawn_table);
+
+		if (pruning.reverse_futility && depth <= REVERSE_FUTILITY_DEPTH && !is_mate_score(beta)
+			&& static_eval - REVERSE_FUTILITY_MARGIN * depth >= beta)
+			return static_eval;
+
+		// if the opponent can't bring the score below beta even when given a free move, a real move will surely do at least as well
+		if (pruning.null_move && depth >= NULL_MOVE_MIN_DEPTH && static_eval >= beta && ply >= null_move_min_ply
+			&& !null_moves[ply - 1] && has_non_pawn_material(*cb, cb->active_player))
+		{
+			int null_depth = depth - 1 - NULL_MOVE_REDUCTION - depth / 6;
+			null_moves[ply] = true;
+			UndoInfo undo = cb->do_null_move();
+			int score = -negamax(cb, null_depth, ply + 1, -beta, -beta + 1);
+			cb->undo_null_move(undo);
+			null_moves[ply] = false;
+			if (stopped) return 0;
+
+			if (score >= beta)
+			{
+				// a mate found after passing isn't a real mate
+				if (is_mate_score(score)) score = beta;
+				if (depth < NULL_MOVE_VERIFY_DEPTH) return score;
+
+				int outer_min_ply = null_move_min_ply;
+				null_move_min_ply = ply + 3 * null_depth / 4;
+				int verified = negamax(cb, null_depth, ply, beta - 1, beta);
+				null_move_min_ply = outer_min_ply;
+				if (stopped) return 0;
+				if (verified >= beta) return score;
+			}
+		}
+	}
+
+	// quiet moves which don't give check can't make up the difference to alpha this near the horizon
+	bool futile = pruning.futility && !pv_node && !in_check && depth <= FUTILITY_DEPTH && !is_mate_score(alpha)
+		&& static_eval + FUTILITY_MARGIN * depth <= alpha;
+
+	// the best move found here before, or at the root the best move of the last iteration, is most likely still the best,
+	// and searching it first gives the tightest window for the rest
+	MovePicker picker(*cb, (ply == 0 && root_best != Move()) ? root_best : entry.move, killers[ply], history);
+
+	Colour colour = cb->active_player;
+	int original_alpha = alpha;
+	int best_score = -INFINITE_SCORE;
+	int legal_moves = 0;
+	int moves_searched = 0;
+	Move best_move;
+	for (Move move = picker.next(); move != Move(); move = picker.next())
+	{
+		bool quiet = !is_noisy(*cb, move);
+		bool killer = (move == killers[ply][0] || move == killers[ply][1]);
+		legal_moves++;
+
+		UndoInfo undo = cb->do_move(move);
+		bool gives_check = is_king_attacked(*cb, cb->active_player);
+		if (futile && quiet && !gives_check && moves_searched > 0)
+		{
+			cb->undo_move(undo);
+			best_score = max(best_score, static_eval + FUTILITY_MARGIN * depth);
+			continue;
+		}
+		moves_searched++;
+
+		// the first move is searched with the full window, and the rest with a null window around alpha, only to show they are no better.
+		// Late quiet moves are also searched less deeply. A move which does turn out better is searched again in full.
+		int score;
+		if (moves_searched == 1)
+			score = -negamax(cb, depth - 1, ply + 1, -beta, -alpha);
+		else
+		{
+			int reduction = 0;
+			if (pruning.late_move_reductions && depth >= LMR_MIN_DEPTH && moves_searched > LMR_MIN_MOVES && quiet && !killer && !in_check && !gives_check)
+			{
+				reduction = LMR_REDUCTIONS[min(depth, 63)][min(moves_searched, 63)];
+				if (history.get(colour, move) >= LMR_HISTORY_THRESHOLD) reduction--;
+				if (pv_node) reduction--;
+				reduction = clamp(reduction, 0, depth - 2);
+			}
+
+			score = -negamax(cb, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+			if (score > alpha && reduction > 0)
+				score = -negamax(cb, depth - 1, ply + 1, -alpha - 1, -alpha);
+			if (score > alpha && score < beta)
+				score = -negamax(cb, depth - 1, ply + 1, -beta, -alpha);
+		}
+		cb->undo_move(undo);
+		if (stopped) return 0;
+
+		if (score > best_score)
+		{
+			best_score = score;
+			if (score > alpha)
+			{
+				alpha = score;
+				best_move = move;
+				pv_table[ply][ply] = move;
+				for (int i = ply + 1; i < pv_length[ply + 1]; i++) pv_table[ply][i] = pv_table[ply + 1][i];
+				pv_length[ply] = max(pv_length[ply + 1], ply + 1);
+				if (alpha >= beta)
+				{
+					// a quiet move which refutes the last move is likely to refute other moves at this ply too
+					cutoffs++;
+					if (moves_searched == 1) first_move_cutoffs++;
+					if (quiet)
+					{
+						if (killers[ply][0] != move)
+						{
+							killers[ply][1] = killers[ply][0];
+							killers[ply][0] = move;
+						}
+						history.add(colour, move, depth);
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	if (legal_moves == 0) return in_check ? -MATE_SCORE + ply : 0;
+
+	if (tt != nullptr)
+	{
+		Bound bound = (best_score >= beta) ? Bound::LOWER : (best_score > original_alpha) ? Bound::EXACT : Bound::UPPER;
+		tt->store(cb->key, best_move, score_to_tt(best_score, ply), depth, bound);
+	}
+
+	return best_score;
+}
+
+
+// Search only the captures and promotions from a position at the horizon, until it is quiet, so the search doesn't stop in the middle
+// of an exchange and score a position where a piece is about to be taken back.
+// The side to move can stand pat on the static evaluation rather than capture, unless it is in check, when every evasion is searched.
+// Captures which lose material by SEE are never searched, nor are those which can't raise alpha even if the captured piece came for free (delta pruning).
+int Searcher::quiescence(Chessboard* cb, int ply, int alpha, int beta)
+{
+	pv_length[ply] = ply;
+	if (check_limits()) return 0;
+	count_node();
+	qnodes++;
+
+	if (ply >= MAX_PLY - 1) return evaluate(*cb, &pawn_table);
+
+	bool in_check = is_king_attacked(*cb, cb->active_player);
+	int stand_pat = -INFINITE_SCORE;
+	if (!in_check)
+	{
+		stand_pat = evaluate(*cb, &pawn_table);
+		if (stand_pat >= beta) return stand_pat;
+		alpha = max(alpha, stand_pat);
+	}
+
+	MovePicker picker = in_check ? MovePicker(*cb, Move(), killers[ply], history) : MovePicker(*cb, history);
+	int best_score = stand_pat;
+	int moves_searched = 0;
+	for (Move move = picker.next(); move != Move(); move = picker.next())
+	{
+		moves_searched++;
+		if (!in_check && move.flag() != MoveFlag::PROMOTION)
+		{
+			Piece captured = (move.flag() == MoveFlag::EN_PASSANT) ? Piece::PAWN : cb->board[square_row(move.to())][square_col(move.to())].piece;
+			if (stand_pat + PIECE_VALUES[(int)captured] + DELTA_MARGIN <= alpha) continue;
+		}
+
+		UndoInfo undo = cb->do_move(move);
+		int score = -quiescence(cb, ply + 1, -beta, -alpha);
+		cb->undo_move(undo);
+		if (stopped) return 0;
+
+		if (score > best_score)
+		{
+			best_score = score;
+			if (score > alpha)
+			{
+				alpha = score;
+				if (alpha >= beta) break;
+			}
+		}
+	}
+
+	if (in_check && moves_searched == 0) return -MATE_SCORE + ply;
+	return best_score;
+}
+
+
+void Searcher::count_node()
+{
+	nodes.store(nodes.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+
+// Whether this searcher should skip an iteration. The main searcher searches every depth.
+bool Searcher::skip_depth(int depth) const
+{
+	if (thread_index == 0) return false;
+	int row = (thread_index - 1) % SKIP_ROWS;
+	return ((depth + SKIP_PHASE[row]) / SKIP_SIZE[row]) % 2 == 1;
+}
+
+
+// Check whether the position at this ply has already been reached on the path from the root, or in the game before it.
+// Only positions since the last capture or pawn move with the same side to move can repeat it,
+// and a position before a null move isn't one the game could come back to.
+bool Searcher::is_repetition(const Chessboard& cb, int ply) const
+{
+	for (int i = ply - 2; i >= ply - cb.halfmove_clock; i -= 2)
+	{
+		// plies before the root are counted back from the last of the game's positions
+		if (i < 0)
+		{
+			if (-i > (int)game_keys.size()) return false;
+			if (game_keys[game_keys.size() + i] == cb.key) return true;
+			continue;
+		}
+		if (null_moves[i] || null_moves[i + 1]) return false;
+		if (path_keys[i] == cb.key) return true;
+	}
+	return false;
+}
+
+
+// Check whether the search has been stopped or has run out of nodes or time, stopping it if so.
+// The first iteration is never cut short.
+bool Searcher::check_limits()
+{
+	if (stopped) return true;
+	if (iteration_depth <= 1) return false;
+
+	uint64_t searched = get_nodes();
+	if (stop_requested || (limits.nodes > 0 && searched >= limits.nodes) ||
+		(time.limited() && searched % CLOCK_CHECK_INTERVAL == 0 && !pondering && time.hard_limit_reached()))
+		stopped = true;
+
+	return stopped;
+}
+
+
+// The move being pondered on was played, so search on as if the search had just started, with the time it was given.
+void Searcher::ponderhit()
+{
+	time.restart();
+	pondering = false;
+}
+
+
+double Searcher::elapsed_seconds() const
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+ParallelSearcher::ParallelSearcher(TranspositionTable* tt, int threads) : tt(tt)
+{
+	for (int i = 0; i < max(1, threads); i++) searchers.push_back(make_unique<Searcher>(tt, i));
+}
+
+
+// Search the board on every thread until the main searcher finishes, returning its result.
+// Each helper gets its own copy of the board, made before any thread starts moving pieces on the original.
+SearchInfo ParallelSearcher::search(Chessboard* cb, const SearchLimits& limits, function<void(const SearchInfo&)> on_iteration,
+	const vector<Key>& game_keys)
+{
+	if (tt != nullptr) tt->new_search();
+
+	SearchLimits helper_limits;
+	helper_limits.depth = limits.depth;
+	vector<Chessboard> boards(searchers.size() - 1, *cb);
+
+	// the helpers were stopped at the end of the last search, so clear that before they start
+	vector<thread> helpers;
+	for (int i = 0; i < boards.size(); i++)
+	{
+		searchers[i + 1]->clear_stop();
+		helpers.push_back(thread([&, i]() { searchers[i + 1]->search(&boards[i], helper_limits, nullptr, game_keys); }));
+	}
+
+	auto add_helper_nodes = [&](SearchInfo info)
+	{
+		info.nodes = total_nodes();
+		info.nps = (info.seconds > 0) ? (uint64_t)(info.nodes / info.seconds) : 0;
+		return info;
+	};
+	SearchInfo info = searchers[0]->search(cb, limits, [&](const SearchInfo& iteration)
+	{
+		if (on_iteration) on_iteration(add_helper_nodes(iteration));
+	}, game_keys);
+	info = add_helper_nodes(info);
+
+	for (int i = 1; i < searchers.size(); i++) searchers[i]->stop();
+	for (thread& helper : helpers) helper.join();
+
+	return info;
+}
+
+
+void ParallelSearcher::set_pruning(const PruningOptions& options)
+{
+	for (unique_ptr<Searcher>& searcher : searchers) searcher->set_pruning(options);
+}
+
+
+uint64_t ParallelSearcher::total_nodes() const
+{
+	uint64_t nodes = 0;
+	for (const unique_ptr<Searcher>& searcher : searchers) nodes += searcher->get_nodes();
+	return nodes;
+}
+
+
+// Describe an iteration in one line: its depth, score, node count (and how many were quiescence nodes), speed, transposition table use,
+// effective branching factor (nodes searched for the iteration over those for the one before), first-move-cutoff rate and principal variation.
+// Mate scores are given as the number of moves to mate, negative if the side to move is being mated.
+string SearchEngine::format_info(const SearchInfo& info)
+{
+	stringstream ss;
+	ss << "depth " << info.depth << " score ";
+	if (is_mate_score(info.score))
+	{
+		int plies = MATE_SCORE - abs(info.score);
+		ss << "mate " << ((info.score > 0) ? (plies + 1) / 2 : -plies / 2);
+	}
+	else
+		ss << "cp " << info.score;
+
+	ss << " nodes " << info.nodes << " qnodes " << info.qnodes << " time " << (int64_t)(info.seconds * 1000) << " nps " << info.nps;
+	if (info.tt_probes > 0) ss << " hashfull " << info.hashfull << " tthits " << (info.tt_hits * 100 / info.tt_probes) << "%";
+	if (info.pawn_probes > 0) ss << " pawnhits " << (info.pawn_hits * 100 / info.pawn_probes) << "%";
+	if (info.branching_factor > 0) ss << " ebf " << fixed << setprecision(2) << info.branching_factor;
+	if (info.cutoffs > 0) ss << " firstcut " << (info.first_move_cutoffs * 100 / info.cutoffs) << "%";
+	ss << " pv";
+	for (Move move : info.pv) ss << " " << move.to_long_algebraic();
+
+	return ss.str();
+}
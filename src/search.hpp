@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "logic.hpp"
+#include "transposition.hpp"
+#include "movepick.hpp"
+#include "pawns.hpp"
+#include "timeman.hpp"
+
+namespace SearchEngine
+{
+    // Scores are in centipawns, from the point of view of the side to move.
+    // A mate is scored as MATE_SCORE less the number of plies to it, so nearer mates score higher.
+    const int INFINITE_SCORE = 32000;
+    const int MATE_SCORE = 31000;
+    const int MAX_PLY = 128;
+
+    inline bool is_mate_score(int score) { return std::abs(score) >= MATE_SCORE - MAX_PLY; }
+
+    // What to stop the search at. Zero means no limit; the search stops at whichever limit it reaches first.
+    // The first iteration always runs to the end, so there is always a move to play.
+    // Playing on a clock, the time manager works out how long to search from the time left, the increment and the moves to go,
+    // all for the side to move. A move time overrides the clock.
+    struct SearchLimits
+    {
+        int depth = 0;
+        uint64_t nodes = 0;
+        int64_t time_ms = 0;
+        int64_t clock_ms = 0;
+        int64_t increment_ms = 0;
+        int moves_to_go = 0;
+    };
+
+    // Which of the ways of searching less than the whole tree to use. All are on by default;
+    // turning one off and comparing the nodes needed to reach a depth shows what it saves.
+    struct PruningOptions
+    {
+        bool null_move = true;              // pass the move, and cut off if even a free move for the opponent leaves the score above beta
+        bool late_move_reductions = true;   // search quiet moves late in the ordering less deeply, unless they turn out to raise alpha
+        bool futility = true;               // near the horizon, skip quiet moves when the static evaluation is far below alpha
+        bool reverse_futility = true;       // near the horizon, cut off when the static evaluation is far above beta
+        bool check_extensions = true;       // search a ply deeper in check, so the horizon never falls in the middle of a check
+    };
+
+    // The outcome of one completed iteration of the search.
+    struct SearchInfo
+    {
+        int depth = 0;
+        int score = 0;
+        uint64_t nodes = 0;
+        uint64_t qnodes = 0;                // how many of the nodes were in quiescence search
+        double seconds = 0;
+        uint64_t nps = 0;
+        std::vector<LogicEngine::Move> pv;  // the principal variation, starting with the best move
+        uint64_t tt_probes = 0;
+        uint64_t tt_hits = 0;
+        int hashfull = 0;                   // parts per thousand of the transposition table used by this search
+        uint64_t pawn_probes = 0;           // pawn structure lookups, and how many found the structure already in the pawn table
+        uint64_t pawn_hits = 0;
+        double branching_factor = 0;        // nodes searched for this iteration over those for the one before
+        uint64_t cutoffs = 0;               // beta cutoffs, and how many of them came from the first move searched
+        uint64_t first_move_cutoffs = 0;
+
+        LogicEngine::Move best_move() const { return pv.empty() ? LogicEngine::Move() : pv[0]; }
+    };
+
+    // A negamax alpha-beta search with iterative deepening.
+    // Moves are made and taken back on the board given, so the board is never copied, and is left as it was found.
+    // stop() can be called from another thread to end the search early. A stop lasts until clear_stop() is called, so one that comes
+    // before the search has started isn't lost: clear it before starting a search that may be stopped. Even a stopped search
+    // completes its first iteration, so there is always a move to play.
+    // Repetitions are found on the path from the root, and back into the game given as the keys of the positions before the root, oldest first.
+    // A search started after ponder() ignores its time until ponderhit() is called, which starts its clock from then.
+    // Results are stored to and looked up from the transposition table if one is given, which can be shared with other searchers.
+    // A helper (any thread index but 0) skips some depths, so helpers sharing a table spread out over different depths.
+    // Each searcher keeps its own pawn table, which lasts from one search to the next.
+    // Moves after the first at each node are searched with a null window (principal variation search), and most of the tree is pruned
+    // or reduced as set by the pruning options.
+    class Searcher
+    {
+    public:
+        Searcher(TranspositionTable* tt = nullptr, int thread_index = 0) : tt(tt), thread_index(thread_index) {};
+        SearchInfo search(LogicEngine::Chessboard* cb, const SearchLimits& limits,
+            std::function<void(const SearchInfo&)> on_iteration = nullptr, const std::vector<LogicEngine::Key>& game_keys = {});
+        void stop() { stop_requested = true; }
+        void clear_stop() { stop_requested = false; }
+        void ponder() { pondering = true; }
+        void ponderhit();
+        void set_pruning(const PruningOptions& options) { pruning = options; }
+        uint64_t get_nodes() const { return nodes.load(std::memory_order_relaxed); }
+
+    private:
+        int negamax(LogicEngine::Chessboard* cb, int depth, int ply, int alpha, int beta);
+        int quiescence(LogicEngine::Chessboard* cb, int ply, int alpha, int beta);
+        void count_node();
+        bool is_repetition(const LogicEngine::Chessboard& cb, int ply) const;
+        bool check_limits();
+        double elapsed_seconds() const;
+
+        bool skip_depth(int depth) const;
+
+        TranspositionTable* tt;
+        int thread_index;
+        SearchLimits limits;
+        PruningOptions pruning;
+        TimeManager time;
+        std::chrono::steady_clock::time_point start;
+        std::atomic<bool> stop_requested{ false };  // set by stop(), from any thread
+        bool stopped = false;                       // whether this search has stopped, for a stop or a limit
+        std::atomic<bool> pondering{ false };
+        std::atomic<uint64_t> nodes{ 0 };  // only written by the searching thread, but read by others for reports
+        uint64_t qnodes = 0;
+        uint64_t tt_probes = 0;
+        uint64_t tt_hits = 0;
+        uint64_t cutoffs = 0;
+        uint64_t first_move_cutoffs = 0;
+        int iteration_depth = 0;
+        LogicEngine::Move root_best;
+
+        // The principal variation found below each ply, as a triangular table: row ply holds the moves from ply to pv_length[ply].
+        LogicEngine::Move pv_table[MAX_PLY][MAX_PLY];
+        int pv_length[MAX_PLY] = {};
+        LogicEngine::Key path_keys[MAX_PLY] = {};  // keys of the positions on the path from the root, for finding repetitions
+        std::vector<LogicEngine::Key> game_keys;    // and of the positions the game passed through before the root
+        bool null_moves[MAX_PLY] = {};              // whether the move from each ply on the path is a null move
+        int null_move_min_ply = 0;                  // no null moves before this ply, while verifying a null move cutoff
+        LogicEngine::Move killers[MAX_PLY][2];      // the last two quiet moves to cause a cutoff at each ply
+        HistoryTable history;
+        PawnTable pawn_table;
+    };
+
+    // A Lazy SMP search: the main searcher and its helpers all search the same position on their own threads and copies of the board,
+    // sharing only the transposition table. Nothing else is passed between them; each helps the others by filling the table
+    // with results they then find instead of searching, so the main searcher reaches each depth sooner.
+    // Only the main searcher reports iterations and gives the result, and only it is held to the node and time limits;
+    // when it finishes, the helpers are stopped. The node counts reported are for all threads together.
+    class ParallelSearcher
+    {
+    public:
+        ParallelSearcher(TranspositionTable* tt, int threads);
+        SearchInfo search(LogicEngine::Chessboard* cb, const SearchLimits& limits,
+            std::function<void(const SearchInfo&)> on_iteration = nullptr, const std::vector<LogicEngine::Key>& game_keys = {});
+        void stop() { searchers[0]->stop(); }
+        void clear_stop() { searchers[0]->clear_stop(); }
+        void ponder() { searchers[0]->ponder(); }
+        void ponderhit() { searchers[0]->ponderhit(); }
+        void set_pruning(const PruningOptions& options);
+        int thread_count() const { return (int)searchers.size(); }
+
+    private:
+        uint64_t total_nodes() const;
+
+        TranspositionTable* tt;
+        std::vector<std::unique_ptr<Searcher>> searchers;   // the main searcher first, then the helpers
+    };
+
+    std::string format_info(const SearchInfo& info);
+}
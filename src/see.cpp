@@ -0,0 +1,84 @@
+// see.cpp
+
+#include "see.hpp"
+#include "evaluate.hpp"
+#include "movegen.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+
+
+// Static exchange evaluation: the material the side making a move can expect to win or lose on the square it moves to,
+// if both sides then take turns capturing there with their least valuable attacker, each stopping when capturing would lose more.
+// Works on bitboards alone, without making any moves. As each attacker is used up it is taken off the occupied squares,
+// so sliders lined up behind it (x-rays) join in. A king only captures if the square is no longer attacked afterwards.
+// Pins are not taken into account.
+int SearchEngine::see(const Chessboard& chessboard, Move move)
+{
+	const Bitboards& bitboards = chessboard.bitboards;
+	int from = move.from();
+	int to = move.to();
+	Colour colour = chessboard.board[square_row(from)][square_col(from)].colour;
+	Piece on_square = chessboard.board[square_row(from)][square_col(from)].piece;
+	Bitboard occupied = bitboards.all() ^ square_bb(from);
+
+	// gain[d] is the material won by the side making the d-th capture, if the capture sequence stopped after it
+	int gain[32];
+	int d = 0;
+	gain[0] = PIECE_VALUES[(int)chessboard.board[square_row(to)][square_col(to)].piece];
+	if (move.flag() == MoveFlag::EN_PASSANT)
+	{
+		gain[0] = PIECE_VALUES[(int)Piece::PAWN];
+		occupied ^= square_bb(square_index(square_row(from), square_col(to)));
+	}
+	else if (move.flag() == MoveFlag::PROMOTION)
+	{
+		gain[0] += PIECE_VALUES[(int)move.promotion()] - PIECE_VALUES[(int)Piece::PAWN];
+		on_square = move.promotion();
+	}
+
+	Bitboard diagonal_sliders = bitboards.of(Colour::WHITE, Piece::BISHOP) | bitboards.of(Colour::BLACK, Piece::BISHOP)
+		| bitboards.of(Colour::WHITE, Piece::QUEEN) | bitboards.of(Colour::BLACK, Piece::QUEEN);
+	Bitboard straight_sliders = bitboards.of(Colour::WHITE, Piece::ROOK) | bitboards.of(Colour::BLACK, Piece::ROOK)
+		| bitboards.of(Colour::WHITE, Piece::QUEEN) | bitboards.of(Colour::BLACK, Piece::QUEEN);
+	Bitboard attackers = get_attackers_to(bitboards, to, occupied) & occupied;
+
+	Colour side = (colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+	while (d < 31)
+	{
+		Bitboard own_attackers = attackers & bitboards.occupancy[(int)side];
+		if (!own_attackers) break;
+
+		Piece attacker = Piece::EMPTY;
+		for (Piece p : { Piece::PAWN, Piece::KNIGHT, Piece::BISHOP, Piece::ROOK, Piece::QUEEN, Piece::KING })
+		{
+			if (own_attackers & bitboards.of(side, p))
+			{
+				attacker = p;
+				break;
+			}
+		}
+
+		occupied ^= square_bb(lsb(own_attackers & bitboards.of(side, attacker)));
+		attackers |= (bishop_attacks(to, occupied) & diagonal_sliders) | (rook_attacks(to, occupied) & straight_sliders);
+		attackers &= occupied;
+
+		Colour opp_side = (side == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+		if (attacker == Piece::KING && (attackers & bitboards.occupancy[(int)opp_side])) break;
+
+		d++;
+		gain[d] = PIECE_VALUES[(int)on_square] - gain[d - 1];
+		on_square = attacker;
+		side = opp_side;
+	}
+
+	// each side only makes its capture if it does better than stopping before it
+	while (d > 0)
+	{
+		gain[d - 1] = -max(-gain[d - 1], gain[d]);
+		d--;
+	}
+
+	return gain[0];
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include "logic.hpp"
+
+namespace SearchEngine
+{
+    int see(const LogicEngine::Chessboard& chessboard, LogicEngine::Move move);
+}
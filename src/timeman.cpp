@@ -0,0 +1,98 @@
+// timeman.cpp
+
+#include <algorithm>
+
+#include "timeman.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+
+
+// Without being told how many moves are left to the next time control, assume this many.
+// Told more than the most, the share is worked out for the most, so time isn't saved for moves a long way off.
+const int DEFAULT_MOVES_TO_GO = 30;
+const int MAX_MOVES_TO_GO = 50;
+
+// Time kept back on the clock for passing the move to the GUI and any delay in between.
+const int64_t MOVE_OVERHEAD_MS = 50;
+
+// How much of the increment counts towards the soft limit, how many times the soft limit the hard limit is,
+// and the most of the clock the hard limit can take.
+const double INCREMENT_SHARE = 0.75;
+const double HARD_LIMIT_SCALE = 5.0;
+const double MAX_CLOCK_SHARE = 0.5;
+
+// The soft limit grows by this much for each recent change of best move, and by up to the most for a score that has dropped
+// by the fail-low drop or more. Together they stretch it no more than the most.
+const double BEST_MOVE_CHANGE_SCALE = 0.5;
+const int FAIL_LOW_DROP = 100;
+const double MAX_FAIL_LOW_SCALE = 2.0;
+const double MAX_SCALE = 3.0;
+
+
+// Work out the limits for a move. A move time of 0 and a clock of 0 mean no limit.
+void TimeManager::start(int64_t move_time_ms, int64_t clock_ms, int64_t increment_ms, int moves_to_go)
+{
+	restart();
+	iterations = 0;
+	last_best_move = Move();
+	last_score = 0;
+	best_move_changes = 0;
+	fail_low_scale = 1;
+
+	fixed = move_time_ms > 0;
+	if (fixed)
+	{
+		soft_ms = hard_ms = move_time_ms;
+		return;
+	}
+	if (clock_ms <= 0)
+	{
+		soft_ms = hard_ms = 0;
+		return;
+	}
+
+	int64_t available = max<int64_t>(1, clock_ms - MOVE_OVERHEAD_MS);
+	int moves = (moves_to_go > 0) ? min(moves_to_go, MAX_MOVES_TO_GO) : DEFAULT_MOVES_TO_GO;
+	soft_ms = available / moves + (int64_t)(max<int64_t>(0, increment_ms) * INCREMENT_SHARE);
+	hard_ms = min((int64_t)(soft_ms * HARD_LIMIT_SCALE), (int64_t)(available * MAX_CLOCK_SHARE));
+	hard_ms = max<int64_t>(1, hard_ms);
+	soft_ms = clamp<int64_t>(soft_ms, 1, hard_ms);
+}
+
+
+void TimeManager::restart()
+{
+	start_ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Note how sure the search is of its move after each iteration. The first iteration has nothing to compare against.
+void TimeManager::update(Move best_move, int score)
+{
+	if (iterations++ > 0)
+	{
+		best_move_changes = best_move_changes / 2 + ((best_move != last_best_move) ? 1 : 0);
+		int drop = last_score - score;
+		fail_low_scale = 1 + (MAX_FAIL_LOW_SCALE - 1) * clamp(drop, 0, FAIL_LOW_DROP) / FAIL_LOW_DROP;
+	}
+	last_best_move = best_move;
+	last_score = score;
+}
+
+
+int64_t TimeManager::soft_limit_ms() const
+{
+	if (fixed) return soft_ms;
+
+	double scale = min(MAX_SCALE, (1 + BEST_MOVE_CHANGE_SCALE * best_move_changes) * fail_low_scale);
+	return min(hard_ms, (int64_t)(soft_ms * scale));
+}
+
+
+int64_t TimeManager::elapsed_ms() const
+{
+	int64_t now_ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+	return (now_ns - start_ns) / 1000000;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "logic.hpp"
+
+namespace SearchEngine
+{
+    // Decides how long a search playing on a clock may take over its move.
+    //
+    // Each move gets two limits. The soft limit is the time the move should normally take: an even share of the time left
+    // for the moves to the next time control, plus most of the increment. The search doesn't start another iteration once it has passed.
+    // It is stretched while the search is unsure of its move: when the best move keeps changing between iterations,
+    // or the score has just dropped (the move it expected to play failed low). The hard limit is several times the soft limit,
+    // but never more than half the clock, and the search is aborted as soon as it is reached, even mid-iteration.
+    // A fixed move time is both the soft and the hard limit, and is never stretched.
+    //
+    // The clock can be restarted while a search runs, for when pondering turns into searching for real.
+    class TimeManager
+    {
+    public:
+        void start(int64_t move_time_ms, int64_t clock_ms, int64_t increment_ms, int moves_to_go);
+        void restart();
+        void update(LogicEngine::Move best_move, int score);    // after each completed iteration
+        bool limited() const { return hard_ms > 0; }
+        bool soft_limit_reached() const { return limited() && elapsed_ms() >= soft_limit_ms(); }
+        bool hard_limit_reached() const { return limited() && elapsed_ms() >= hard_ms; }
+        int64_t soft_limit_ms() const;
+        int64_t hard_limit_ms() const { return hard_ms; }
+        int64_t elapsed_ms() const;
+
+    private:
+        std::atomic<int64_t> start_ns{ 0 };     // written when pondering turns into searching, while the search reads it
+        int64_t soft_ms = 0;
+        int64_t hard_ms = 0;
+        bool fixed = false;
+        int iterations = 0;
+        LogicEngine::Move last_best_move;
+        int last_score = 0;
+        double best_move_changes = 0;           // recent changes of best move, each counting half as much an iteration later
+        double fail_low_scale = 1;
+    };
+}
@@ -0,0 +1,143 @@
+// transposition.cpp
+
+#include "transposition.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+
+
+const int GENERATION_BITS = 6;
+const uint8_t GENERATION_MASK = (1 << GENERATION_BITS) - 1;
+
+
+uint64_t pack_entry(Move move, int score, int depth, Bound bound, uint8_t generation)
+{
+	return (uint64_t)move.raw()
+		| ((uint64_t)(uint16_t)(int16_t)score << 16)
+		| ((uint64_t)(uint8_t)depth << 32)
+		| ((uint64_t)bound << 40)
+		| ((uint64_t)generation << 42);
+}
+
+
+Move unpack_move(uint64_t data) { return Move::from_raw((uint16_t)data); }
+int unpack_score(uint64_t data) { return (int16_t)(uint16_t)(data >> 16); }
+int unpack_depth(uint64_t data) { return (uint8_t)(data >> 32); }
+Bound unpack_bound(uint64_t data) { return (Bound)((data >> 40) & 3); }
+uint8_t unpack_generation(uint64_t data) { return (data >> 42) & GENERATION_MASK; }
+
+
+TranspositionTable::TranspositionTable(size_t size_mb)
+{
+	resize(size_mb);
+}
+
+
+// Size the table to the largest power of two number of buckets that fits in the given number of megabytes, emptying it.
+void TranspositionTable::resize(size_t size_mb)
+{
+	size_t num_buckets = 1;
+	while (num_buckets * 2 * sizeof(Bucket) <= size_mb * 1024 * 1024) num_buckets *= 2;
+
+	buckets = make_unique<Bucket[]>(num_buckets);
+	mask = num_buckets - 1;
+	generation = 0;
+}
+
+
+void TranspositionTable::clear()
+{
+	for (size_t i = 0; i <= mask; i++)
+	{
+		for (Entry& entry : buckets[i].entries)
+		{
+			entry.key_xor_data.store(0, memory_order_relaxed);
+			entry.data.store(0, memory_order_relaxed);
+		}
+	}
+	generation = 0;
+}
+
+
+// Start a new search, so the entries stored by earlier searches are the first to be replaced.
+void TranspositionTable::new_search()
+{
+	generation = (generation + 1) & GENERATION_MASK;
+}
+
+
+// Look up a position, returning false if it isn't in the table.
+bool TranspositionTable::probe(Key key, TTEntry* entry) const
+{
+	const Bucket& bucket = buckets[key & mask];
+	for (const Entry& e : bucket.entries)
+	{
+		uint64_t data = e.data.load(memory_order_relaxed);
+		if ((e.key_xor_data.load(memory_order_relaxed) ^ data) != key || data == 0) continue;
+
+		entry->move = unpack_move(data);
+		entry->score = unpack_score(data);
+		entry->depth = unpack_depth(data);
+		entry->bound = unpack_bound(data);
+		return true;
+	}
+	return false;
+}
+
+
+// Store the result of searching a position.
+// An entry already holding the position is overwritten, keeping its move if no better one is given.
+// Otherwise the entry replaced is the one least worth keeping: the shallowest, counting entries from earlier searches as shallower still.
+void TranspositionTable::store(Key key, Move move, int score, int depth, Bound bound)
+{
+	Bucket& bucket = buckets[key & mask];
+	Entry* replace = nullptr;
+	int replace_worth = INT32_MAX;
+
+	for (Entry& e : bucket.entries)
+	{
+		uint64_t data = e.data.load(memory_order_relaxed);
+		if ((e.key_xor_data.load(memory_order_relaxed) ^ data) == key)
+		{
+			if (move == Move()) move = unpack_move(data);
+			replace = &e;
+			break;
+		}
+
+		int age = (generation - unpack_generation(data)) & GENERATION_MASK;
+		int worth = (data == 0) ? INT32_MIN : unpack_depth(data) - 8 * age;
+		if (worth < replace_worth)
+		{
+			replace = &e;
+			replace_worth = worth;
+		}
+	}
+
+	uint64_t data = pack_entry(move, score, depth, bound, generation);
+	replace->key_xor_data.store(key ^ data, memory_order_relaxed);
+	replace->data.store(data, memory_order_relaxed);
+}
+
+
+// How full the table is with entries from the current search, in parts per thousand, estimated from the first thousand buckets.
+int TranspositionTable::hashfull() const
+{
+	size_t sample = min<size_t>(1000, mask + 1);
+	size_t used = 0;
+	for (size_t i = 0; i < sample; i++)
+	{
+		for (const Entry& e : buckets[i].entries)
+		{
+			uint64_t data = e.data.load(memory_order_relaxed);
+			if (data != 0 && unpack_generation(data) == generation) used++;
+		}
+	}
+	return (int)(used * 1000 / (sample * BUCKET_SIZE));
+}
+
+
+size_t TranspositionTable::size_mb() const
+{
+	return (mask + 1) * sizeof(Bucket) / (1024 * 1024);
+}
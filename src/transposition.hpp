@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+#include "logic.hpp"
+
+namespace SearchEngine
+{
+    // How a stored score relates to the true score of the position: exact, or a bound from a search which failed low (UPPER) or high (LOWER).
+    enum class Bound
+    {
+        NONE,
+        UPPER,
+        LOWER,
+        EXACT
+    };
+
+    // What the table holds about a position.
+    struct TTEntry
+    {
+        LogicEngine::Move move;
+        int score;
+        int depth;
+        Bound bound;
+    };
+
+    // A hash table of search results keyed by position, so positions reached again, by another move order or in a later iteration, aren't searched from scratch.
+    // Entries are grouped into buckets of four which fill one cache line, so a probe touches a single line of memory.
+    // It is shared between search threads without locks: each 16-byte entry stores its key XORed with its data,
+    // so an entry torn by two threads writing at once fails the key check on probing instead of giving another position's result.
+    class TranspositionTable
+    {
+    public:
+        TranspositionTable(size_t size_mb);
+        void resize(size_t size_mb);
+        void clear();
+        void new_search();
+        bool probe(LogicEngine::Key key, TTEntry* entry) const;
+        void store(LogicEngine::Key key, LogicEngine::Move move, int score, int depth, Bound bound);
+        int hashfull() const;
+        size_t size_mb() const;
+
+    private:
+        struct Entry
+        {
+            std::atomic<uint64_t> key_xor_data{ 0 };
+            std::atomic<uint64_t> data{ 0 };    // move in bits 0-15, score in 16-31, depth in 32-39, bound in 40-41, generation in 42-47
+        };
+
+        static const int BUCKET_SIZE = 4;
+        struct alignas(64) Bucket
+        {
+            Entry entries[BUCKET_SIZE];
+        };
+        static_assert(sizeof(Entry) == 16, "entries should pack into 16 bytes");
+        static_assert(sizeof(Bucket) == 64, "a bucket should fill one cache line");
+
+        std::unique_ptr<Bucket[]> buckets;
+        size_t mask;            // the number of buckets is a power of two, so the key's low bits pick the bucket
+        uint8_t generation = 0; // counts searches, so entries left over from earlier searches are replaced first
+    };
+}
@@ -0,0 +1,350 @@
+// uci.cpp
+
+#include <algorithm>
+#include <cctype>
+
+#include "uci.hpp"
+#include "movegen.hpp"
+#include "nnue.hpp"
+
+using namespace std;
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace UciEngine;
+
+
+const string ENGINE_NAME = "chess3d";
+const string ENGINE_AUTHOR = "the chess3d developers";
+const string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+const int MAX_HASH_MB = 65536;
+const int MAX_THREADS = 256;
+
+
+// The options that can be set with setoption, as listed in reply to uci, pruning options by their member.
+struct PruningOption
+{
+	string name;
+	bool PruningOptions::* member;
+};
+
+const vector<PruningOption> PRUNING_OPTIONS = {
+	{ "NullMove", &PruningOptions::null_move },
+	{ "LateMoveReductions", &PruningOptions::late_move_reductions },
+	{ "Futility", &PruningOptions::futility },
+	{ "ReverseFutility", &PruningOptions::reverse_futility },
+	{ "CheckExtensions", &PruningOptions::check_extensions }
+};
+
+
+UciHandler::UciHandler(function<void(const string&)> send) : send_line(send)
+{
+	board.load_fen(START_FEN);
+	tt = make_unique<TranspositionTable>(hash_mb);
+	searcher = make_unique<ParallelSearcher>(tt.get(), threads);
+}
+
+
+UciHandler::~UciHandler()
+{
+	stop_search();
+}
+
+
+// Carry out one command. Unknown commands are reported and otherwise ignored, as the protocol asks.
+bool UciHandler::handle_command(const string& line)
+{
+	istringstream args(line);
+	string command;
+	if (!(args >> command)) return true;
+
+	if (command == "uci")
+		uci();
+	else if (command == "isready")
+		send("readyok");
+	else if (command == "setoption")
+		set_option(args);
+	else if (command == "ucinewgame")
+	{
+		stop_search();
+		tt->clear();
+	}
+	else if (command == "position")
+		position(args);
+	else if (command == "go")
+		go(args);
+	else if (command == "stop")
+		stop_search();
+	else if (command == "ponderhit")
+		ponderhit();
+	else if (command == "quit")
+	{
+		stop_search();
+		return false;
+	}
+	else if (command != "debug")
+		send("info string unknown command: " + command);
+
+	return true;
+}
+
+
+void UciHandler::wait_for_search()
+{
+	if (worker.joinable()) worker.join();
+}
+
+
+// Introduce the engine and the options it has.
+void UciHandler::uci()
+{
+	send("id name " + ENGINE_NAME);
+	send("id author " + ENGINE_AUTHOR);
+	send("option name Hash type spin default 16 min 1 max " + to_string(MAX_HASH_MB));
+	send("option name Threads type spin default 1 min 1 max " + to_string(MAX_THREADS));
+	send("option name Clear Hash type button");
+	send("option name Ponder type check default false");
+	send("option name EvalFile type string default <empty>");
+	for (const PruningOption& option : PRUNING_OPTIONS) send("option name " + option.name + " type check default true");
+	send("uciok");
+}
+
+
+// setoption name <name> [value <value>], where the name and value can both contain spaces.
+// Options are only changed between searches, so any search still running is stopped first.
+void UciHandler::set_option(istringstream& args)
+{
+	string word, name, value;
+	args >> word;
+	if (word != "name") return;
+	while (args >> word && word != "value") name += (name.empty() ? "" : " ") + word;
+	getline(args >> ws, value);
+
+	stop_search();
+	if (name == "Hash" && !value.empty() && isdigit(value[0]))
+	{
+		hash_mb = clamp(atoi(value.c_str()), 1, MAX_HASH_MB);
+		tt->resize(hash_mb);
+	}
+	else if (name == "Threads" && !value.empty() && isdigit(value[0]))
+	{
+		threads = clamp(atoi(value.c_str()), 1, MAX_THREADS);
+		searcher = make_unique<ParallelSearcher>(tt.get(), threads);
+		searcher->set_pruning(pruning);
+	}
+	else if (name == "Clear Hash")
+		tt->clear();
+	else if (name == "Ponder")
+		return;
+	else if (name == "EvalFile")
+	{
+		if (value.empty() || value == "<empty>")
+			set_network(nullptr);
+		else if (!load_network(value))
+			send("info string could not load network: " + value);
+	}
+	else
+	{
+		for (const PruningOption& option : PRUNING_OPTIONS)
+		{
+			if (name != option.name) continue;
+			pruning.*option.member = (value == "true");
+			searcher->set_pruning(pruning);
+			return;
+		}
+		send("info string unknown option: " + name);
+	}
+}
+
+
+// position startpos|fen <fen> [moves <move> ...]
+// A position that can't be read, or a move that isn't legal, is reported, and the board is left at the last position that could be reached.
+// The keys of the positions the moves pass through are kept, so the search can find repetitions of them.
+void UciHandler::position(istringstream& args)
+{
+	stop_search();
+
+	string word, fen;
+	args >> word;
+	if (word == "startpos")
+	{
+		fen = START_FEN;
+		args >> word;
+	}
+	else if (word == "fen")
+	{
+		while (args >> word && word != "moves") fen += word + " ";
+	}
+	else
+	{
+		send("info string expected startpos or fen");
+		return;
+	}
+
+	if (!board.load_fen(fen))
+	{
+		send("info string could not read FEN: " + fen);
+		return;
+	}
+	game_keys.clear();
+	if (word != "moves") return;
+
+	while (args >> word)
+	{
+		Move move;
+		if (!parse_uci_move(board, word, &move))
+		{
+			send("info string illegal move: " + word);
+			return;
+		}
+		game_keys.push_back(board.key);
+		board.do_move(move);
+	}
+}
+
+
+// go [depth <n>] [nodes <n>] [movetime <ms>] [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>] [infinite] [ponder]
+// Starts searching the board on the worker thread, and returns straight away.
+void UciHandler::go(istringstream& args)
+{
+	stop_search();
+
+	SearchLimits limits;
+	int64_t time_left[2] = {}, increment[2] = {};
+	bool go_infinite = false, go_ponder = false;
+
+	string word;
+	while (args >> word)
+	{
+		if (word == "infinite")
+			go_infinite = true;
+		else if (word == "ponder")
+			go_ponder = true;
+		else
+		{
+			int64_t value = 0;
+			if (!(args >> value)) break;
+			if (word == "depth") limits.depth = (int)value;
+			else if (word == "nodes") limits.nodes = (uint64_t)max<int64_t>(0, value);
+			else if (word == "movetime") limits.time_ms = max<int64_t>(1, value);
+			else if (word == "wtime") time_left[0] = max<int64_t>(1, value);
+			else if (word == "btime") time_left[1] = max<int64_t>(1, value);
+			else if (word == "winc") increment[0] = value;
+			else if (word == "binc") increment[1] = value;
+			else if (word == "movestogo") limits.moves_to_go = (int)value;
+		}
+	}
+
+	// the time manager only needs the side to move's clock
+	int us = (board.active_player == Colour::WHITE) ? 0 : 1;
+	limits.clock_ms = time_left[us];
+	limits.increment_ms = increment[us];
+
+	// an infinite search ignores every limit, and pondering ignores its time until ponderhit
+	if (go_infinite) limits = SearchLimits();
+	pondering = go_ponder;
+	infinite = go_infinite;
+	if (go_ponder) searcher->ponder();
+	searcher->clear_stop();
+
+	worker = thread(&UciHandler::search_worker, this, board, limits);
+}
+
+
+// The opponent played the move being pondered on, so the search carries on as a normal one, counting down its time from now.
+void UciHandler::ponderhit()
+{
+	lock_guard<mutex> lock(state_mutex);
+	if (!pondering) return;
+	pondering = false;
+	searcher->ponderhit();
+	state_changed.notify_all();
+}
+
+
+// Search on the worker thread, reporting each iteration as it completes, then send the best move and the move expected in reply.
+void UciHandler::search_worker(Chessboard search_board, SearchLimits limits)
+{
+	SearchInfo info = searcher->search(&search_board, limits, [this](const SearchInfo& iteration) { send(format_uci_info(iteration)); }, game_keys);
+
+	{
+		unique_lock<mutex> lock(state_mutex);
+		state_changed.wait(lock, [this]() { return stop_requested || (!pondering && !infinite); });
+	}
+
+	// the null move is only sent when there is no legal move at all
+	Move best = info.best_move();
+	MoveList legal_moves = get_all_legal_moves(search_board);
+	if (!legal_moves.contains(best)) best = legal_moves.empty() ? Move() : legal_moves[0];
+
+	string reply = "bestmove " + (legal_moves.empty() ? string("0000") : best.to_long_algebraic());
+	if (info.pv.size() > 1 && best == info.best_move()) reply += " ponder " + info.pv[1].to_long_algebraic();
+	send(reply);
+}
+
+
+void UciHandler::request_stop()
+{
+	{
+		lock_guard<mutex> lock(state_mutex);
+		stop_requested = true;
+		state_changed.notify_all();
+	}
+	searcher->stop();
+}
+
+
+// Stop any search running, wait for it to send its best move, and get ready for the next.
+void UciHandler::stop_search()
+{
+	if (worker.joinable())
+	{
+		request_stop();
+		worker.join();
+	}
+
+	stop_requested = false;
+	pondering = false;
+	infinite = false;
+}
+
+
+void UciHandler::send(const string& line)
+{
+	lock_guard<mutex> lock(send_mutex);
+	send_line(line);
+}
+
+
+bool UciEngine::parse_uci_move(const Chessboard& chessboard, const string& text, Move* move)
+{
+	for (Move legal : get_all_legal_moves(chessboard))
+	{
+		if (legal.to_long_algebraic() != text) continue;
+		*move = legal;
+		return true;
+	}
+	return false;
+}
+
+
+// Describe an iteration as a UCI info line. Mate scores are given as the number of moves to mate, negative if the side to move is being mated.
+string UciEngine::format_uci_info(const SearchInfo& info)
+{
+	stringstream ss;
+	ss << "info depth " << info.depth << " score ";
+	if (is_mate_score(info.score))
+	{
+		int plies = MATE_SCORE - abs(info.score);
+		ss << "mate " << ((info.score > 0) ? (plies + 1) / 2 : -plies / 2);
+	}
+	else
+		ss << "cp " << info.score;
+
+	ss << " nodes " << info.nodes << " nps " << info.nps << " time " << (int64_t)(info.seconds * 1000);
+	if (info.tt_probes > 0) ss << " hashfull " << info.hashfull;
+	ss << " pv";
+	for (Move move : info.pv) ss << " " << move.to_long_algebraic();
+
+	return ss.str();
+}
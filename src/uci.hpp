@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "logic.hpp"
+#include "search.hpp"
+#include "transposition.hpp"
+
+namespace UciEngine
+{
+    // The engine's side of the Universal Chess Interface (UCI) protocol, as spoken to chess GUIs and tournament managers.
+    // Commands are passed in one line at a time, and replies are passed to the send function one line at a time.
+    //
+    // A search runs on its own worker thread, so commands keep being read while it runs: stop ends it within a few thousand nodes,
+    // and isready is answered at once. While pondering or searching infinitely, the best move is held back until stop or ponderhit,
+    // even if the search has already finished, as the protocol requires.
+    // Replies from the worker and from commands can come from different threads, but are never sent at the same time.
+    class UciHandler
+    {
+    public:
+        UciHandler(std::function<void(const std::string&)> send);
+        ~UciHandler();
+        bool handle_command(const std::string& line);   // returns false once told to quit
+        void wait_for_search();                         // blocks until a search that will end by itself has sent its best move
+        const LogicEngine::Chessboard& get_board() const { return board; }
+
+    private:
+        void uci();
+        void set_option(std::istringstream& args);
+        void position(std::istringstream& args);
+        void go(std::istringstream& args);
+        void ponderhit();
+        void search_worker(LogicEngine::Chessboard search_board, SearchEngine::SearchLimits limits);
+        void request_stop();
+        void stop_search();
+        void send(const std::string& line);
+
+        std::function<void(const std::string&)> send_line;
+        std::mutex send_mutex;
+
+        LogicEngine::Chessboard board;
+        std::vector<LogicEngine::Key> game_keys;       // the positions before the board's, from the position command's moves
+        size_t hash_mb = 16;
+        int threads = 1;
+        SearchEngine::PruningOptions pruning;
+        std::unique_ptr<SearchEngine::TranspositionTable> tt;
+        std::unique_ptr<SearchEngine::ParallelSearcher> searcher;
+
+        // The state of the search running on the worker thread, guarded by state_mutex.
+        std::thread worker;
+        std::mutex state_mutex;
+        std::condition_variable state_changed;
+        bool stop_requested = false;
+        bool pondering = false;
+        bool infinite = false;
+    };
+
+    // A move in long algebraic notation (e.g. e2e4, e7e8q), if it is legal on the board.
+    bool parse_uci_move(const LogicEngine::Chessboard& chessboard, const std::string& text, LogicEngine::Move* move);
+    std::string format_uci_info(const SearchEngine::SearchInfo& info);
+}
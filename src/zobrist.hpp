@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace LogicEngine
+{
+    // A Zobrist key identifies a position by XORing together a random number for each feature of it:
+    // every piece on its square, the side to move, the castling rights and the en passant file.
+    // Making a move only changes a few features, so the key is updated by XORing those numbers in and out.
+    typedef uint64_t Key;
+
+    // Generate the random numbers at compile time from a fixed seed, so keys are the same on every run.
+    constexpr Key splitmix64(Key* state)
+    {
+        Key z = (*state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    struct ZobristKeys
+    {
+        Key pieces[2][6][64];   // indexed by colour, piece (skipping Piece::EMPTY) and square, like the bitboards
+        Key castling[16];       // one per combination of castling rights
+        Key ep_file[8];
+        Key side;               // XORed in when black is to move
+    };
+
+    constexpr ZobristKeys make_zobrist_keys()
+    {
+        ZobristKeys keys = {};
+        Key state = 1070372;
+
+        for (int c = 0; c < 2; c++)
+            for (int p = 0; p < 6; p++)
+                for (int sq = 0; sq < 64; sq++)
+                    keys.pieces[c][p][sq] = splitmix64(&state);
+        for (int i = 0; i < 16; i++) keys.castling[i] = splitmix64(&state);
+        for (int i = 0; i < 8; i++) keys.ep_file[i] = splitmix64(&state);
+        keys.side = splitmix64(&state);
+
+        return keys;
+    }
+
+    inline constexpr ZobristKeys ZOBRIST = make_zobrist_keys();
+}
@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include "logic.hpp"
+#include "analysis.hpp"
+#include "console.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace ConsoleEngine;
+using namespace std;
+
+Chessboard board_from_fen(string fen);  // from test_search.cpp
+
+// Wait for the analysis to complete an iteration at least as deep as the depth. A mate seen to the end is as deep as it goes.
+// Returns false if it hasn't by the timeout.
+static bool wait_for_depth(BackgroundAnalysis* analysis, int depth, SearchInfo* info, int timeout_ms = 10000)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    while (chrono::steady_clock::now() < deadline)
+    {
+        if (analysis->latest(info) && info->depth >= depth) return true;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return false;
+}
+
+TEST(BackgroundAnalysisTest, DoesNothingUntilEnabled)
+{
+    BackgroundAnalysis analysis(1);
+    analysis.start(board_from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"));
+    ASSERT_FALSE(analysis.is_running());
+    ASSERT_EQ(analysis.describe(), "Analysis is off. Type 'analyse' to turn it on.");
+}
+
+TEST(BackgroundAnalysisTest, FindsBestMoveAndScore)
+{
+    BackgroundAnalysis analysis(1);
+    analysis.set_enabled(true);
+    analysis.start(board_from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"));
+
+    SearchInfo info;
+    ASSERT_TRUE(wait_for_depth(&analysis, 1, &info));
+    ASSERT_EQ(info.best_move(), Move(square_index(0, 0), square_index(7, 0)));
+    ASSERT_EQ(analysis.describe().rfind("Depth ", 0), 0);
+    ASSERT_NE(analysis.describe().find("white mates in 1"), string::npos);
+
+    // scores are shown from white's point of view, whoever is to move
+    analysis.start(board_from_fen("r5k1/8/8/8/8/8/5PPP/6K1 b - - 0 1"));
+    ASSERT_TRUE(wait_for_depth(&analysis, 1, &info));
+    ASSERT_NE(analysis.describe().find("black mates in 1, best move a8a1"), string::npos);
+}
+
+TEST(BackgroundAnalysisTest, StopsPromptly)
+{
+    BackgroundAnalysis analysis(1);
+    analysis.set_enabled(true);
+    Chessboard board = board_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    Key key = board.key;
+    analysis.start(board);
+    SearchInfo info;
+    ASSERT_TRUE(wait_for_depth(&analysis, 3, &info));
+
+    auto start = chrono::steady_clock::now();
+    analysis.stop();
+    ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(100));
+    ASSERT_FALSE(analysis.is_running());
+    ASSERT_EQ(board.key, key);
+
+    // stopping straight after starting still stops
+    analysis.start(board);
+    analysis.stop();
+    ASSERT_FALSE(analysis.is_running());
+}
+
+TEST(BackgroundAnalysisTest, KeepsSearchingTheSamePosition)
+{
+    BackgroundAnalysis analysis(1);
+    analysis.set_enabled(true);
+    Chessboard board = board_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    analysis.start(board);
+    SearchInfo info;
+    ASSERT_TRUE(wait_for_depth(&analysis, 3, &info));
+    int depth = info.depth;
+
+    // asking again for the same position carries on rather than starting over
+    analysis.start(board);
+    ASSERT_TRUE(analysis.latest(&info));
+    ASSERT_GE(info.depth, depth);
+
+    // another position starts over
+    board.do_move(info.best_move());
+    analysis.start(board);
+    ASSERT_TRUE(wait_for_depth(&analysis, 1, &info));
+    ASSERT_TRUE(analysis.is_running());
+}
+
+TEST(BackgroundAnalysisTest, SeesRepetitionsOfTheGame)
+{
+    // Black is lost, but Kg8 repeats the position after White's first move, so it draws
+    Chessboard board = board_from_fen("6k1/8/8/8/8/8/2Q5/K7 w - - 0 1");
+    stack<UndoInfo> undo_stack;
+    for (Move move : { Move(square_index(0, 0), square_index(0, 1)), Move(square_index(7, 6), square_index(7, 7)),
+        Move(square_index(0, 1), square_index(0, 0)) })
+        undo_stack.push(board.do_move(move));
+    vector<Key> game_keys = get_game_keys(undo_stack);
+    ASSERT_EQ(game_keys.size(), 3u);
+    ASSERT_EQ(game_keys[0], board_from_fen("6k1/8/8/8/8/8/2Q5/K7 w - - 0 1").key);
+
+    BackgroundAnalysis analysis(1);
+    analysis.set_enabled(true);
+    analysis.start(board, game_keys);
+    SearchInfo info;
+    ASSERT_TRUE(wait_for_depth(&analysis, 4, &info));
+    ASSERT_EQ(info.best_move(), Move(square_index(7, 7), square_index(7, 6)));
+    ASSERT_EQ(info.score, 0);
+}
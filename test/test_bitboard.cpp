@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "bitboard.hpp"
+
+using namespace LogicEngine;
+using namespace std;
+
+// Build the attacks for a square by walking a list of offsets, as the move generators used to.
+Bitboard walk_offsets(int sq, vector<vector<int>> offsets)
+{
+    Bitboard attacks = 0;
+    for (int i = 0; i < offsets.size(); i++)
+    {
+        int row = square_row(sq) + offsets[i][0];
+        int col = square_col(sq) + offsets[i][1];
+        if (row >= 0 && row < 8 && col >= 0 && col < 8)
+            attacks |= square_bb(square_index(row, col));
+    }
+    return attacks;
+}
+
+TEST(SquareIndexTest, RoundtripRowAndCol)
+{
+    for (int row = 0; row < 8; row++)
+    {
+        for (int col = 0; col < 8; col++)
+        {
+            int sq = square_index(row, col);
+            ASSERT_EQ(square_row(sq), row);
+            ASSERT_EQ(square_col(sq), col);
+        }
+    }
+    ASSERT_EQ(square_index(0, 0), 0);  // a1
+    ASSERT_EQ(square_index(7, 7), 63); // h8
+}
+
+TEST(BitCountingTest, PopCountAndLsb)
+{
+    Bitboard b = square_bb(3) | square_bb(17) | square_bb(63);
+    ASSERT_EQ(pop_count(b), 3);
+    ASSERT_EQ(lsb(b), 3);
+    ASSERT_EQ(pop_lsb(&b), 3);
+    ASSERT_EQ(pop_lsb(&b), 17);
+    ASSERT_EQ(pop_lsb(&b), 63);
+    ASSERT_EQ(b, 0);
+}
+
+TEST(AttackTableTest, LeaperTablesMatchOffsets)
+{
+    // The tables are built at compile time
+    static_assert(KNIGHT_ATTACKS[0] == (square_bb(10) | square_bb(17)), "knight on a1 attacks c2 and b3");
+    static_assert(KING_ATTACKS[63] == (square_bb(54) | square_bb(55) | square_bb(62)), "king on h8 attacks g7, h7 and g8");
+
+    for (int sq = 0; sq < NUM_SQUARES; sq++)
+    {
+        ASSERT_EQ(KNIGHT_ATTACKS[sq], walk_offsets(sq, { {-2, -1}, {-2, 1}, {2, -1}, {2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2} }));
+        ASSERT_EQ(KING_ATTACKS[sq], walk_offsets(sq, { {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} }));
+        ASSERT_EQ(PAWN_ATTACKS[0][sq], walk_offsets(sq, { {1, -1}, {1, 1} }));
+        ASSERT_EQ(PAWN_ATTACKS[1][sq], walk_offsets(sq, { {-1, -1}, {-1, 1} }));
+    }
+
+    // Pawns on the far rank attack nothing
+    ASSERT_EQ(PAWN_ATTACKS[0][square_index(7, 4)], 0);
+    ASSERT_EQ(PAWN_ATTACKS[1][square_index(0, 4)], 0);
+}
+
+TEST(SliderAttackTest, MagicLookupsMatchRayWalks)
+{
+    // Check every square against a spread of pseudo-random occupancies, plus the empty and full boards
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (int sq = 0; sq < NUM_SQUARES; sq++)
+    {
+        for (int i = 0; i < 200; i++)
+        {
+            state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+            Bitboard occupied = (i == 0) ? 0 : (i == 1) ? ~0ULL : state & (state >> 3);
+
+            ASSERT_EQ(rook_attacks(sq, occupied), sliding_attacks(sq, occupied, true));
+            ASSERT_EQ(bishop_attacks(sq, occupied), sliding_attacks(sq, occupied, false));
+            ASSERT_EQ(queen_attacks(sq, occupied), sliding_attacks(sq, occupied, true) | sliding_attacks(sq, occupied, false));
+        }
+    }
+}
+
+TEST(SliderAttackTest, BlockersStopRays)
+{
+    // A rook on d4 with pieces on d6 and b4 sees d5, d6 (the blocker), c4, b4 and the open rays
+    int d4 = square_index(3, 3);
+    Bitboard occupied = square_bb(square_index(5, 3)) | square_bb(square_index(3, 1));
+    Bitboard attacks = rook_attacks(d4, occupied);
+    ASSERT_TRUE(attacks & square_bb(square_index(5, 3)));
+    ASSERT_FALSE(attacks & square_bb(square_index(6, 3)));
+    ASSERT_TRUE(attacks & square_bb(square_index(3, 1)));
+    ASSERT_FALSE(attacks & square_bb(square_index(3, 0)));
+    ASSERT_EQ(pop_count(attacks), 2 + 3 + 2 + 4);
+}
@@ -1,4 +1,5 @@
 #include <gtest/gtest.h>
+#include <thread>
 #include "logic.hpp"
 #include "console.hpp"
 
@@ -6,9 +7,10 @@ using namespace LogicEngine;
 using namespace ConsoleEngine;
 using namespace std;
 using namespace FileHandler;
+using namespace SearchEngine;
 namespace fs = std::filesystem;
 
-vector<int> simulate_target_square_input(const string& input, Chessboard* test_board, stack<Chessboard>* board_stack, stringstream* cout_buffer);
+vector<int> simulate_target_square_input(const string& input, Chessboard* test_board, stack<UndoInfo>* undo_stack, stringstream* cout_buffer, BackgroundAnalysis* analysis = nullptr);
 vector<int> simulate_destination_square_input(const string& input, Chessboard* test_board, vector<int> target_position, stringstream* cout_buffer);
 
 const int NUM_TEST_POSITIONS = 8;
@@ -17,73 +19,101 @@ TEST(InputTargetSquareTest, UndoAndExitInput)
 {
 	// Initialize a chessboard and stack for testing
 	Chessboard test_board("positions/starting_position.txt");
-	stack<Chessboard> board_stack;
-	board_stack.push(test_board);
+	stack<UndoInfo> undo_stack;
 
 	// Move white pawn from e2 to e4
-	switch_pieces(&test_board, { 1, 4 }, { 3, 4 });
-	board_stack.push(test_board);
+	undo_stack.push(test_board.do_move(build_move(test_board, { 1, 4 }, { 3, 4 })));
 
 	// Move black pawn from e7 to e5
-	switch_pieces(&test_board, { 6, 4 }, { 4, 4 });
-	board_stack.push(test_board);
+	undo_stack.push(test_board.do_move(build_move(test_board, { 6, 4 }, { 4, 4 })));
 	
 	stringstream cout_buffer;
 	vector<int> result;
 
 	// Simulate user input for "undo"
-	result = simulate_target_square_input("undo\nexit\n", &test_board, &board_stack, &cout_buffer);
-	ASSERT_EQ(board_stack.size(), 2);
+	result = simulate_target_square_input("undo\nexit\n", &test_board, &undo_stack, &cout_buffer);
+	ASSERT_EQ(undo_stack.size(), 1);
+	ASSERT_EQ(test_board.board[6][4].piece, Piece::PAWN);
+	ASSERT_EQ(test_board.board[4][4].piece, Piece::EMPTY);
+	ASSERT_EQ(test_board.active_player, Colour::BLACK);
 	ASSERT_TRUE(cout_buffer.str().find("Undoing move") != std::string::npos);
 	cout_buffer.str("");
 
-	result = simulate_target_square_input("undo\nexit\n", &test_board, &board_stack, &cout_buffer);
-	ASSERT_EQ(board_stack.size(), 1);
+	result = simulate_target_square_input("undo\nexit\n", &test_board, &undo_stack, &cout_buffer);
+	ASSERT_EQ(undo_stack.size(), 0);
+	ASSERT_EQ(test_board.board[1][4].piece, Piece::PAWN);
+	ASSERT_EQ(test_board.board[3][4].piece, Piece::EMPTY);
+	ASSERT_EQ(test_board.active_player, Colour::WHITE);
 	ASSERT_TRUE(cout_buffer.str().find("Undoing move") != std::string::npos);
 	cout_buffer.str("");
 	
-	result = simulate_target_square_input("undo\nexit\n", &test_board, &board_stack, &cout_buffer);
-	ASSERT_EQ(board_stack.size(), 1);
+	result = simulate_target_square_input("undo\nexit\n", &test_board, &undo_stack, &cout_buffer);
+	ASSERT_EQ(undo_stack.size(), 0);
 	ASSERT_TRUE(cout_buffer.str().find("No more moves to undo") != std::string::npos);
 	ASSERT_TRUE(cout_buffer.str().find("Returning to menu") != std::string::npos);
 }
 
+TEST(InputTargetSquareTest, AnalyseAndHintInput)
+{
+	Chessboard test_board("positions/test_blank.txt");
+	ASSERT_TRUE(test_board.load_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1"));
+	stack<UndoInfo> undo_stack;
+	BackgroundAnalysis analysis(1);
+	stringstream cout_buffer;
+
+	// hints need the analysis turned on first
+	simulate_target_square_input("hint\nanalyse\nexit\n", &test_board, &undo_stack, &cout_buffer, &analysis);
+	ASSERT_TRUE(cout_buffer.str().find("Analysis is off") != std::string::npos);
+	ASSERT_TRUE(cout_buffer.str().find("Analysis on") != std::string::npos);
+	ASSERT_TRUE(analysis.is_running());
+	cout_buffer.str("");
+
+	SearchInfo info;
+	while (!analysis.latest(&info)) this_thread::yield();
+	simulate_target_square_input("hint\nexit\n", &test_board, &undo_stack, &cout_buffer, &analysis);
+	ASSERT_TRUE(cout_buffer.str().find("white mates in 1, best move a1a8") != std::string::npos);
+	cout_buffer.str("");
+
+	simulate_target_square_input("analyse\nexit\n", &test_board, &undo_stack, &cout_buffer, &analysis);
+	ASSERT_TRUE(cout_buffer.str().find("Analysis off") != std::string::npos);
+	ASSERT_FALSE(analysis.is_running());
+}
+
 TEST(InputTargetSquareTest, InvalidInput)
 {
 	// Initialize a chessboard and stack for testing
 	Chessboard test_board("positions/starting_position.txt");
-	stack<Chessboard> board_stack = stack<Chessboard>({ test_board });
-	get_valid_and_attacking_moves(&test_board);
+	stack<UndoInfo> undo_stack;
 
 	stringstream cout_buffer;
 	vector<int> result;
 
 	// Simulate invalid inputs and check for the expected output
-	result = simulate_target_square_input("z2\nexit\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("z2\nexit\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Invalid input") != std::string::npos);
 	cout_buffer.str("");
 
-	result = simulate_target_square_input("e9\nexit\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("e9\nexit\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Invalid input") != std::string::npos);
 	cout_buffer.str("");
 
-	result = simulate_target_square_input("TEST!!!!\nexit\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("TEST!!!!\nexit\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Invalid input") != std::string::npos);
 	cout_buffer.str("");
 
-	result = simulate_target_square_input(" \nexit\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input(" \nexit\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Invalid input") != std::string::npos);
 	cout_buffer.str("");
 
-	result = simulate_target_square_input("e7\nexit\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("e7\nexit\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Piece selected belongs to opposite player") != std::string::npos);
 	cout_buffer.str("");
 
-	result = simulate_target_square_input("e3\nexit\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("e3\nexit\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Piece selected belongs to opposite player") != std::string::npos);
 	cout_buffer.str("");
 
-	result = simulate_target_square_input("e1\nexit\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("e1\nexit\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("No valid moves for that piece") != std::string::npos);
 	cout_buffer.str("");
 }
@@ -92,19 +122,18 @@ TEST(InputTargetSquareTest, ValidInput)
 {
 	// Initialize a chessboard and stack for testing
 	Chessboard test_board("positions/starting_position.txt");
-	stack<Chessboard> board_stack = stack<Chessboard>({ test_board });
-	get_valid_and_attacking_moves(&test_board);
+	stack<UndoInfo> undo_stack;
 
 	stringstream cout_buffer;
 	vector<int> result;
 
 	// Simulate valid inputs and check for the expected output
-	result = simulate_target_square_input("e2\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("e2\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Moves:") != std::string::npos);
 	ASSERT_EQ(result, vector<int>({ 1, 4 }));
 	cout_buffer.str("");
 
-	result = simulate_target_square_input("b1\n", &test_board, &board_stack, &cout_buffer);
+	result = simulate_target_square_input("b1\n", &test_board, &undo_stack, &cout_buffer);
 	ASSERT_TRUE(cout_buffer.str().find("Moves:") != std::string::npos);
 	ASSERT_EQ(result, vector<int>({ 0, 1 }));
 	cout_buffer.str("");
@@ -113,7 +142,6 @@ TEST(InputTargetSquareTest, ValidInput)
 TEST(GetInputDestinationSquareTest, InvalidInput) {
 	// Initialize a chessboard and stack for testing
 	Chessboard test_board("positions/starting_position.txt");
-	get_valid_and_attacking_moves(&test_board);
 
 	stringstream cout_buffer;
 	vector<int> target_square, result;
@@ -156,7 +184,6 @@ TEST(GetInputDestinationSquareTest, InvalidInput) {
 TEST(GetInputDestinationSquareTest, ValidInput) {
 	// Initialize a chessboard and stack for testing
 	Chessboard test_board("positions/starting_position.txt");
-	get_valid_and_attacking_moves(&test_board);
 
 	stringstream cout_buffer;
 	vector<int> target_square, result;
@@ -176,7 +203,6 @@ TEST(GetInputDestinationSquareTest, ValidInput) {
 TEST(PrintBoardTest, WellformedOutput) {
 	// Initialize a chessboard and stack for testing
 	Chessboard test_board("positions/starting_position.txt");
-	get_valid_and_attacking_moves(&test_board);
 
 	string board_string =
 		"PGN : \nCurrent board : "
@@ -211,7 +237,7 @@ TEST(PrintBoardTest, WellformedOutput) {
 	stringstream cout_buffer;
 	cout.rdbuf(cout_buffer.rdbuf());
 
-	print_board(test_board, vector<Square>(), Gamestate::NORMAL);
+	print_board(test_board, MoveList(), Gamestate::NORMAL);
 	ASSERT_EQ(cout_buffer.str(), board_string);
 
 	// When done redirect cout to its old self
@@ -259,14 +285,14 @@ TEST(GetFileMapTest, InvalidFileMapHandled) {
 	cout.rdbuf(sbuf);
 }
 
-vector<int> simulate_target_square_input(const string& input, Chessboard* test_board, stack<Chessboard>* board_stack, stringstream* cout_buffer) {
+vector<int> simulate_target_square_input(const string& input, Chessboard* test_board, stack<UndoInfo>* undo_stack, stringstream* cout_buffer, BackgroundAnalysis* analysis) {
 	istringstream iss(input);
 	cin.rdbuf(iss.rdbuf());
 
 	// Redirect cout to stringstream buffer
 	streambuf* sbuf = std::cout.rdbuf();
 	cout.rdbuf(cout_buffer->rdbuf());
-	vector<int> result = ConsoleEngine::get_input_target_square(test_board, board_stack);
+	vector<int> result = ConsoleEngine::get_input_target_square(test_board, undo_stack, analysis);
 
 	// When done redirect cout to its old self
 	cout.rdbuf(sbuf);
@@ -282,7 +308,7 @@ vector<int> simulate_destination_square_input(const string& input, Chessboard* t
 	streambuf* sbuf = std::cout.rdbuf();
 	cout.rdbuf(cout_buffer->rdbuf());
 
-	vector<Square> vms = test_board->find_valid_moves(test_board->board[target_position[0]][target_position[1]]);
+	MoveList vms = test_board->find_valid_moves(test_board->board[target_position[0]][target_position[1]]);
 	vector<int> result = ConsoleEngine::get_input_destination_square(vms);
 
 	// When done redirect cout to its old self
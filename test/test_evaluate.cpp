@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "logic.hpp"
+#include "movegen.hpp"
+#include "perft.hpp"
+#include "evaluate.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+// The same position with the board turned upside down and the colours swapped, with the same side to move.
+Chessboard flip_colours(const Chessboard& board)
+{
+    Chessboard flipped("positions/test_blank.txt");
+    for (int row = 0; row < DIM_SIZE; row++)
+        for (int col = 0; col < DIM_SIZE; col++)
+            flipped.set_square(row, col, Square(row, col));
+
+    for (int row = 0; row < DIM_SIZE; row++)
+    {
+        for (int col = 0; col < DIM_SIZE; col++)
+        {
+            Square square = board.board[row][col];
+            if (square.colour == Colour::EMPTY) continue;
+            Colour colour = (square.colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+            flipped.set_square(DIM_SIZE - 1 - row, col, Square(square.piece, colour, DIM_SIZE - 1 - row, col));
+        }
+    }
+    flipped.set_active_player(board.active_player);
+    return flipped;
+}
+
+TEST(EvaluateTest, StartingPositionIsLevel)
+{
+    Chessboard board("positions/starting_position.txt");
+    ASSERT_EQ(board.psqt.phase, MAX_PHASE);
+    ASSERT_EQ(evaluate(board), 0);
+}
+
+TEST(EvaluateTest, EndgameUsesEndgameTables)
+{
+    Chessboard board("positions/test_blank.txt");
+    ASSERT_TRUE(board.load_fen("8/8/8/3k4/8/8/4P3/4K3 w - - 0 1"));
+    ASSERT_EQ(board.psqt.phase, 0);
+    PawnEntry pawns = evaluate_pawns(board);
+    int eg = board.psqt.eg + pawns.eg[0] - pawns.eg[1];
+    ASSERT_EQ(evaluate(board), eg);
+
+    // the same side seen from black's point of view
+    board.set_active_player(Colour::BLACK);
+    ASSERT_EQ(evaluate(board), -eg);
+}
+
+TEST(EvaluateTest, IncrementalScoreMatchesScratchScore)
+{
+    // play a fixed sequence of moves through each position, covering captures, castling, en passant and promotions along the way
+    for (const PerftPosition& position : PERFT_POSITIONS)
+    {
+        Chessboard board("positions/test_blank.txt");
+        ASSERT_TRUE(board.load_fen(position.fen));
+        PsqtScore start = board.psqt;
+
+        vector<UndoInfo> undos;
+        for (int ply = 0; ply < 40; ply++)
+        {
+            MoveList moves = get_all_legal_moves(board);
+            if (moves.empty()) break;
+            undos.push_back(board.do_move(moves[(ply * 7) % moves.size()]));
+            ASSERT_TRUE(board.psqt == board.compute_psqt()) << position.name << " ply " << ply;
+        }
+        while (!undos.empty())
+        {
+            board.undo_move(undos.back());
+            undos.pop_back();
+        }
+        ASSERT_TRUE(board.psqt == start) << position.name;
+    }
+}
+
+TEST(EvaluateTest, FlippedColoursNegateScore)
+{
+    for (const PerftPosition& position : PERFT_POSITIONS)
+    {
+        Chessboard board("positions/test_blank.txt");
+        ASSERT_TRUE(board.load_fen(position.fen));
+
+        for (int ply = 0; ply < 20; ply++)
+        {
+            Chessboard flipped = flip_colours(board);
+            ASSERT_EQ(evaluate(flipped), -evaluate(board)) << position.name << " ply " << ply;
+            ASSERT_EQ(flipped.psqt.phase, board.psqt.phase);
+
+            MoveList moves = get_all_legal_moves(board);
+            if (moves.empty()) break;
+            board.do_move(moves[(ply * 5) % moves.size()]);
+        }
+    }
+}
@@ -35,26 +35,6 @@ TEST(RoundtripTests, IntToSquareToInt)
     ASSERT_EQ(convert_chessboard_square_to_int("e2"), vector<int>({ 1, 4 }));
 }
 
-TEST(DeepCloneBoardTest, AssertDeepClonedBoardHasCorrectMetadata)
-{
-	Chessboard original_board("positions/test_ep.txt");
-
-    vector<vector<Square>> cloned_board = deep_clone_board(original_board.board);
-    
-    for (int row = 0; row < DIM_SIZE; row++)
-    {
-        for (int col = 0; col < DIM_SIZE; col++)
-        {
-            ASSERT_EQ(cloned_board[row][col].row,        original_board.board[row][col].row);
-            ASSERT_EQ(cloned_board[row][col].col,        original_board.board[row][col].col);
-            ASSERT_EQ(cloned_board[row][col].piece,      original_board.board[row][col].piece);
-            ASSERT_EQ(cloned_board[row][col].colour,     original_board.board[row][col].colour);
-            ASSERT_EQ(cloned_board[row][col].has_moved,  original_board.board[row][col].has_moved);
-            ASSERT_EQ(cloned_board[row][col].when_moved, original_board.board[row][col].when_moved);
-        }
-	}
-}
-
 TEST(SwitchPiecesTest, AssertSwitchingPiecesCorrectness)
 {
 	Chessboard test_board("positions/starting_position.txt");
@@ -62,30 +42,27 @@ TEST(SwitchPiecesTest, AssertSwitchingPiecesCorrectness)
 	// Move white pawn from e2 to e4
     switch_pieces(&test_board, { 1, 4 }, { 3, 4 }); 
 
-	// Check that the destination square has the correct piece, colour and metadata
+	// Check that the destination square has the correct piece, colour and coordinates
 	ASSERT_EQ(test_board.board[3][4].piece, Piece::PAWN);
     ASSERT_EQ(test_board.board[3][4].colour, Colour::WHITE);
-	ASSERT_TRUE(test_board.board[3][4].has_moved);
-	ASSERT_EQ(test_board.board[3][4].when_moved.back(), test_board.move_no);
+	ASSERT_EQ(test_board.board[3][4].row, 3);
+	ASSERT_EQ(test_board.board[3][4].col, 4);
 
 	// Check that the original square is now empty
     ASSERT_EQ(test_board.board[1][4].piece, Piece::EMPTY);
     ASSERT_EQ(test_board.board[1][4].colour, Colour::EMPTY);
-    ASSERT_TRUE(test_board.board[1][4].has_moved);
-	ASSERT_TRUE(test_board.board[1][4].when_moved.empty());
+	ASSERT_EQ(test_board.board[1][4], Square(1, 4));
 }
 
 TEST(CheckmateStalemateTest, DetectStalemateCorrectly)
 {
     // Not initially in stalemate as there is a black pawn move
     Chessboard stalemate_board("positions/test_stalemate.txt");
-    get_valid_and_attacking_moves(&stalemate_board);
     ASSERT_FALSE(test_for_checkmate_stalemate(&stalemate_board, Colour::BLACK, Colour::WHITE));
 
 	// Remove the g2 pawn and check for stalemate again
     int p_row = 1, p_col = 6;
-    stalemate_board.board[p_row][p_col] = Square(p_row, p_col);
-    get_valid_and_attacking_moves(&stalemate_board);
+    stalemate_board.set_square(p_row, p_col, Square(p_row, p_col));
 	ASSERT_TRUE(test_for_checkmate_stalemate(&stalemate_board, Colour::BLACK, Colour::WHITE));
 }
 
@@ -93,13 +70,11 @@ TEST(CheckmateStalemateTest, DetectCheckmateCorrectly)
 {
     // Not initially in checkmate as there is a black pawn in the way
     Chessboard checkmate_board("positions/test_checkmate.txt");
-    get_valid_and_attacking_moves(&checkmate_board);
     ASSERT_FALSE(test_for_checkmate_stalemate(&checkmate_board, Colour::BLACK, Colour::WHITE));
     
     // Remove the f8 pawn and check for checkmate again
     int p_row = 7, p_col = 5;
-    checkmate_board.board[p_row][p_col] = Square(p_row, p_col);
-    get_valid_and_attacking_moves(&checkmate_board);
+    checkmate_board.set_square(p_row, p_col, Square(p_row, p_col));
 	ASSERT_TRUE(test_for_checkmate_stalemate(&checkmate_board, Colour::BLACK, Colour::WHITE));
 }
 
@@ -108,70 +83,436 @@ TEST(GetPlyNotationTest, AssertSimplePlyNotationCorrectness)
 	// Test a simple pawn move from e2 to e4
     Chessboard test_board("positions/starting_position.txt");
 	vector<int> target_position = { 1, 4 }, destination_position = { 3, 4 };
-    switch_pieces(&test_board, target_position, destination_position);
     string ply_notation = get_ply_notation(&test_board, target_position, destination_position, false);
 	ASSERT_EQ(ply_notation, "e4");
 }
 
-Chessboard generate_notation_test_board_and_capture(vector<int> target_position, vector<int> destination_position)
-{
-    Chessboard test_board("positions/test_notation.txt");
-    get_valid_and_attacking_moves(&test_board);
-    switch_pieces(&test_board, target_position, destination_position);
-	return test_board;
-}
-
 TEST(GetPlyNotationTest, AssertCapturePlyNotationCorrectness)
 {
-    Chessboard test_board;
+    // The notation is worked out before the capture is made, so the same board is used for each one
+    Chessboard test_board("positions/test_notation.txt");
 	vector<int> target_position, destination_position;
     string ply_notation;
 
     // Move white pawn from h6 to g7 to capture black rook
     target_position = { 5, 7 }, destination_position = { 6, 6 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "hxg7");
 
     // Move white pawn from f6 to g7 to capture black rook
     target_position = { 5, 5 }, destination_position = { 6, 6 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "fxg7");
 
     // Move white bishop from b3 to c4 to capture black rook
     target_position = { 2, 1 }, destination_position = { 3, 2 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "B3xc4");
 
     // Move white bishop from b5 to c4 to capture black rook
     target_position = { 4, 1 }, destination_position = { 3, 2 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "Bb5xc4");
 
     // Move white bishop from d5 to c4 to capture black rook
     target_position = { 4, 3 }, destination_position = { 3, 2 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "Bdxc4");
 
     // Move white knight from e5 to c4 to capture black rook
     target_position = { 4, 4 }, destination_position = { 3, 2 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "Ne5xc4");
 
     // Move white knight from e3 to c4 to capture black rook
     target_position = { 2, 4 }, destination_position = { 3, 2 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "Ne3xc4");
 
     // Move white knight from b2 to c4 to capture black rook
     target_position = { 1, 1 }, destination_position = { 3, 2 };
-    test_board = generate_notation_test_board_and_capture(target_position, destination_position);
     ply_notation = get_ply_notation(&test_board, target_position, destination_position, true);
     ASSERT_EQ(ply_notation, "Nbxc4");
 }
+
+TEST(BitboardsTest, AssertBitboardsFollowTheBoard)
+{
+    Chessboard test_board("positions/starting_position.txt");
+
+    // Move white pawn from e2 to e4, then capture it with the black knight via f6
+    switch_pieces(&test_board, { 1, 4 }, { 3, 4 });
+    switch_pieces(&test_board, { 7, 6 }, { 5, 5 });
+    switch_pieces(&test_board, { 5, 5 }, { 3, 4 });
+
+    for (int row = 0; row < DIM_SIZE; row++)
+    {
+        for (int col = 0; col < DIM_SIZE; col++)
+        {
+            Square square = test_board.board[row][col];
+            Bitboard square_mask = square_bb(square_index(row, col));
+            for (Colour c : { Colour::WHITE, Colour::BLACK })
+            {
+                ASSERT_EQ((test_board.bitboards.occupancy[(int)c] & square_mask) != 0, square.colour == c);
+                for (Piece p : { Piece::PAWN, Piece::ROOK, Piece::KNIGHT, Piece::BISHOP, Piece::QUEEN, Piece::KING })
+                    ASSERT_EQ((test_board.bitboards.of(c, p) & square_mask) != 0, square.colour == c && square.piece == p);
+            }
+        }
+    }
+
+    ASSERT_EQ(pop_count(test_board.bitboards.occupancy[(int)Colour::WHITE]), 15);
+    ASSERT_EQ(pop_count(test_board.bitboards.occupancy[(int)Colour::BLACK]), 16);
+}
+
+// Reference versions of the leaper move generators, walking the move offsets square by square.
+// The table-driven generators must agree with these on every test position.
+vector<Square> reference_knight_moves(Square target, const Board& board, Colour opp_colour)
+{
+    vector<Square> moves;
+    vector<tuple<int, int>> knight_moves = { {-2, -1}, {-2, 1}, {2, -1}, {2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2} };
+    for (int i = 0; i < knight_moves.size(); i++)
+    {
+        int row = target.row + get<0>(knight_moves[i]), col = target.col + get<1>(knight_moves[i]);
+        if (row < 0 || row >= DIM_SIZE || col < 0 || col >= DIM_SIZE) continue;
+        if (board[row][col].colour == Colour::EMPTY || board[row][col].colour == opp_colour) moves.push_back(board[row][col]);
+    }
+    return moves;
+}
+
+vector<Square> reference_pawn_attacking_squares(Square target, const Board& board, Colour opp_colour)
+{
+    vector<Square> moves;
+    int dir = (target.colour == Colour::WHITE) ? 1 : -1;
+    if (target.row + dir < 0 || target.row + dir >= DIM_SIZE) return moves;
+    if (target.col > 0 && board[target.row + dir][target.col - 1].colour == opp_colour) moves.push_back(board[target.row + dir][target.col - 1]);
+    if (target.col < 7 && board[target.row + dir][target.col + 1].colour == opp_colour) moves.push_back(board[target.row + dir][target.col + 1]);
+    return moves;
+}
+
+vector<Square> reference_king_moves(Square target, const Board& board, Colour opp_colour)
+{
+    vector<Square> moves;
+    for (int i = -1; i <= 1; i++)
+    {
+        for (int j = -1; j <= 1; j++)
+        {
+            int row = target.row + i, col = target.col + j;
+            if ((i == 0 && j == 0) || row < 0 || row >= DIM_SIZE || col < 0 || col >= DIM_SIZE) continue;
+            if (board[row][col].colour == Colour::EMPTY || board[row][col].colour == opp_colour) moves.push_back(board[row][col]);
+        }
+    }
+    return moves;
+}
+
+vector<int> square_indices(vector<Square> squares)
+{
+    vector<int> result;
+    for (int i = 0; i < squares.size(); i++) result.push_back(square_index(squares[i].row, squares[i].col));
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<int> square_indices(Bitboard squares)
+{
+    vector<int> result;
+    while (squares) result.push_back(pop_lsb(&squares));
+    return result;
+}
+
+TEST(LeaperMovesTest, AssertTableMovesMatchReferenceOnAllPositions)
+{
+    int positions_checked = 0;
+    for (const auto& entry : fs::directory_iterator(fs::current_path().append("positions")))
+    {
+        if (entry.path().extension() != ".txt") continue;
+        Chessboard test_board("positions/" + entry.path().filename().string());
+        positions_checked++;
+
+        for (int row = 0; row < DIM_SIZE; row++)
+        {
+            for (int col = 0; col < DIM_SIZE; col++)
+            {
+                Square target = test_board.board[row][col];
+                if (target.colour == Colour::EMPTY) continue;
+                Colour opp_colour = (target.colour == Colour::WHITE) ? Colour::BLACK : Colour::WHITE;
+
+                switch (target.piece)
+                {
+                case Piece::KNIGHT:
+                    ASSERT_EQ(square_indices(get_prospective_moves(test_board, target)),
+                              square_indices(reference_knight_moves(target, test_board.board, opp_colour)));
+                    break;
+                case Piece::PAWN:
+                    ASSERT_EQ(square_indices(test_board.attacks.from[square_index(row, col)] & test_board.bitboards.occupancy[(int)opp_colour]),
+                              square_indices(reference_pawn_attacking_squares(target, test_board.board, opp_colour)));
+                    break;
+                case Piece::KING:
+                    ASSERT_EQ(square_indices(get_prospective_moves(test_board, target)),
+                              square_indices(reference_king_moves(target, test_board.board, opp_colour)));
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    }
+    ASSERT_GT(positions_checked, 0);
+}
+
+// Compare two boards square by square, along with the state kept alongside the squares.
+void assert_boards_match(const Chessboard& actual, const Chessboard& expected)
+{
+    for (int row = 0; row < DIM_SIZE; row++)
+    {
+        for (int col = 0; col < DIM_SIZE; col++)
+            ASSERT_EQ(actual.board[row][col], expected.board[row][col]);
+    }
+    for (int c = 0; c < 2; c++)
+    {
+        ASSERT_EQ(actual.bitboards.occupancy[c], expected.bitboards.occupancy[c]);
+        for (int p = 0; p < 6; p++) ASSERT_EQ(actual.bitboards.pieces[c][p], expected.bitboards.pieces[c][p]);
+    }
+    ASSERT_EQ(actual.active_player, expected.active_player);
+    ASSERT_EQ(actual.move_no, expected.move_no);
+    ASSERT_EQ(actual.castling_rights, expected.castling_rights);
+    ASSERT_EQ(actual.ep_square, expected.ep_square);
+    ASSERT_EQ(actual.halfmove_clock, expected.halfmove_clock);
+    ASSERT_EQ(actual.notation, expected.notation);
+}
+
+TEST(DoUndoMoveTest, AssertUndoRestoresTheBoard)
+{
+    // Play e4, then each of black's replies in turn, and undo back to the start
+    Chessboard test_board("positions/starting_position.txt");
+    Chessboard original_board = test_board;
+
+    UndoInfo first_undo = test_board.do_move(build_move(test_board, { 1, 4 }, { 3, 4 }));
+    ASSERT_EQ(test_board.ep_square, square_index(2, 4));
+    ASSERT_EQ(test_board.active_player, Colour::BLACK);
+    Chessboard after_first_move = test_board;
+
+    for (Move move : find_all_attackable_squares(test_board, Colour::BLACK, Piece_Finding_Mode::VALID))
+    {
+        UndoInfo undo = test_board.do_move(move);
+        test_board.undo_move(undo);
+        assert_boards_match(test_board, after_first_move);
+    }
+
+    test_board.undo_move(first_undo);
+    assert_boards_match(test_board, original_board);
+}
+
+TEST(DoUndoMoveTest, AssertSpecialMovesAreUndone)
+{
+    // Castle both ways with black
+    Chessboard castling_board("positions/test_castling.txt");
+    castling_board.set_active_player(Colour::BLACK);
+    Chessboard original_castling_board = castling_board;
+    ASSERT_EQ(castling_board.castling_rights, WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO);
+
+    UndoInfo undo = castling_board.do_move(build_move(castling_board, { 7, 4 }, { 7, 2 }));
+    ASSERT_EQ(undo.move.flag(), MoveFlag::CASTLING);
+    ASSERT_EQ(castling_board.board[7][3].piece, Piece::ROOK);
+    ASSERT_EQ(castling_board.castling_rights, WHITE_OO | WHITE_OOO);
+    castling_board.undo_move(undo);
+    assert_boards_match(castling_board, original_castling_board);
+
+    undo = castling_board.do_move(build_move(castling_board, { 7, 4 }, { 7, 6 }));
+    ASSERT_EQ(castling_board.board[7][5].piece, Piece::ROOK);
+    castling_board.undo_move(undo);
+    assert_boards_match(castling_board, original_castling_board);
+
+    // Capture en passant with the black f pawn after the white g pawn moves two squares
+    Chessboard ep_board("positions/test_ep.txt");
+    ep_board.do_move(build_move(ep_board, { 1, 6 }, { 3, 6 }));
+    Chessboard original_ep_board = ep_board;
+
+    undo = ep_board.do_move(build_move(ep_board, { 3, 5 }, { 2, 6 }));
+    ASSERT_EQ(undo.move.flag(), MoveFlag::EN_PASSANT);
+    ASSERT_EQ(ep_board.board[3][6].piece, Piece::EMPTY);
+    ep_board.undo_move(undo);
+    assert_boards_match(ep_board, original_ep_board);
+
+    // Promote the white g pawn by capturing on f8
+    Chessboard promotion_board("positions/test_promotion.txt");
+    Chessboard original_promotion_board = promotion_board;
+
+    undo = promotion_board.do_move(build_move(promotion_board, { 6, 6 }, { 7, 5 }, Piece::KNIGHT));
+    ASSERT_EQ(undo.move.flag(), MoveFlag::PROMOTION);
+    ASSERT_EQ(promotion_board.board[7][5].piece, Piece::KNIGHT);
+    promotion_board.undo_move(undo);
+    assert_boards_match(promotion_board, original_promotion_board);
+}
+
+TEST(DoUndoMoveTest, AssertHalfmoveClockCountsQuietMoves)
+{
+    Chessboard test_board("positions/starting_position.txt");
+    ASSERT_EQ(test_board.halfmove_clock, 0);
+
+    // Knight moves count towards the fifty-move rule, and a pawn move starts the count again
+    test_board.do_move(build_move(test_board, { 0, 6 }, { 2, 5 }));
+    test_board.do_move(build_move(test_board, { 7, 6 }, { 5, 5 }));
+    ASSERT_EQ(test_board.halfmove_clock, 2);
+
+    UndoInfo undo = test_board.do_move(build_move(test_board, { 1, 4 }, { 3, 4 }));
+    ASSERT_EQ(test_board.halfmove_clock, 0);
+    test_board.undo_move(undo);
+    ASSERT_EQ(test_board.halfmove_clock, 2);
+
+    // Loading a FEN takes the clock from its fifth field
+    ASSERT_TRUE(test_board.load_fen("8/8/8/8/8/8/8/K6k w - - 37 80"));
+    ASSERT_EQ(test_board.halfmove_clock, 37);
+}
+
+TEST(DoUndoMoveTest, AssertNullMovePassesTheTurn)
+{
+    Chessboard test_board("positions/test_blank.txt");
+    ASSERT_TRUE(test_board.load_fen("4k3/8/8/3pP3/8/8/8/4K3 w - d6 3 40"));
+    Chessboard original = test_board;
+
+    // passing changes the side to move and loses the en passant capture, but moves no pieces
+    UndoInfo undo = test_board.do_null_move();
+    ASSERT_EQ(test_board.active_player, Colour::BLACK);
+    ASSERT_EQ(test_board.ep_square, -1);
+    ASSERT_EQ(test_board.halfmove_clock, 4);
+    ASSERT_EQ(test_board.key, test_board.compute_key());
+    ASSERT_NE(test_board.key, original.key);
+    ASSERT_EQ(test_board.bitboards.occupancy[0], original.bitboards.occupancy[0]);
+    ASSERT_EQ(test_board.bitboards.occupancy[1], original.bitboards.occupancy[1]);
+
+    test_board.undo_null_move(undo);
+    assert_boards_match(test_board, original);
+    ASSERT_EQ(test_board.halfmove_clock, 3);
+    ASSERT_EQ(test_board.key, original.key);
+}
+
+// Check the attack map against attacks worked out from scratch: the squares each colour attacks, and the number of attackers on each square.
+void assert_attack_map_matches(const Chessboard& test_board)
+{
+    ASSERT_TRUE(test_board.attacks == test_board.compute_attacks());
+    for (Colour c : { Colour::WHITE, Colour::BLACK })
+    {
+        ASSERT_EQ(test_board.attacks.attacked[(int)c], get_attacked_squares(test_board.bitboards, c, test_board.bitboards.all()));
+        for (int sq = 0; sq < NUM_SQUARES; sq++)
+        {
+            Bitboard attackers = get_attackers_to(test_board.bitboards, sq, test_board.bitboards.all()) & test_board.bitboards.occupancy[(int)c];
+            ASSERT_EQ(test_board.attacks.count(c, sq), pop_count(attackers));
+        }
+    }
+}
+
+TEST(AttackMapTest, AssertAttackMapFollowsMoves)
+{
+    // A position with castling, en passant, promotions and plenty of sliders blocking each other
+    Chessboard test_board("positions/test_blank.txt");
+    ASSERT_TRUE(test_board.load_fen("r3k2r/Pppp1ppp/1b3nbN/nP6/BBPPP3/q4N2/Pp4PP/R2Q1RK1 b kq d3 0 1"));
+    assert_attack_map_matches(test_board);
+
+    for (Move move : get_all_legal_moves(test_board))
+    {
+        UndoInfo undo = test_board.do_move(move);
+        assert_attack_map_matches(test_board);
+
+        for (Move reply : get_all_legal_moves(test_board))
+        {
+            UndoInfo reply_undo = test_board.do_move(reply);
+            assert_attack_map_matches(test_board);
+            test_board.undo_move(reply_undo);
+        }
+
+        test_board.undo_move(undo);
+        assert_attack_map_matches(test_board);
+    }
+}
+
+TEST(MoveCacheTest, AssertMovesAreCachedUntilTheBoardChanges)
+{
+    Chessboard test_board("positions/starting_position.txt");
+    ASSERT_EQ(test_board.move_cache.ready, 0);
+
+    // Asking for one piece's moves only works out that piece's moves
+    MoveList knight_moves = test_board.find_valid_moves(test_board.board[0][6]);
+    ASSERT_EQ(knight_moves.size(), 2);
+    ASSERT_EQ(test_board.move_cache.ready, square_bb(square_index(0, 6)));
+
+    // The whole side's moves match the moves found without the cache
+    MoveList white_moves = test_board.valid_moves(Colour::WHITE);
+    ASSERT_EQ(white_moves.size(), 20);
+    ASSERT_EQ(test_board.move_cache.ready, test_board.bitboards.occupancy[(int)Colour::WHITE]);
+    for (Move move : white_moves)
+    {
+        Square mover = test_board.board[square_row(move.from())][square_col(move.from())];
+        ASSERT_TRUE(get_valid_square_moves(mover, test_board).contains(move));
+    }
+
+    // Making a move or editing the board empties the cache
+    UndoInfo undo = test_board.do_move(build_move(test_board, { 1, 4 }, { 3, 4 }));
+    ASSERT_EQ(test_board.move_cache.ready, 0);
+    ASSERT_EQ(test_board.valid_moves(Colour::WHITE).size(), 30);
+    test_board.undo_move(undo);
+    ASSERT_EQ(test_board.move_cache.ready, 0);
+
+    test_board.find_valid_moves(test_board.board[0][6]);
+    test_board.set_square(2, 5, Square(Piece::PAWN, Colour::WHITE, 2, 5));
+    ASSERT_EQ(test_board.move_cache.ready, 0);
+    ASSERT_EQ(test_board.find_valid_moves(test_board.board[0][6]).size(), 1);
+}
+
+TEST(MoveCacheTest, AssertAnyLegalMoveStopsAtTheFirstMove)
+{
+    // The king has a move, so no other piece needs looking at
+    Chessboard test_board("positions/test_castling.txt");
+    ASSERT_TRUE(test_board.has_any_legal_move(Colour::WHITE));
+    ASSERT_EQ(test_board.move_cache.ready, test_board.bitboards.of(Colour::WHITE, Piece::KING));
+
+    // Stalemated: every black piece is looked at and none can move
+    Chessboard stalemate_board("positions/test_stalemate.txt");
+    stalemate_board.set_square(1, 6, Square(1, 6));
+    ASSERT_FALSE(stalemate_board.has_any_legal_move(Colour::BLACK));
+    ASSERT_TRUE(stalemate_board.valid_moves(Colour::BLACK).empty());
+}
+
+TEST(MoveTest, AssertMovesPackAndUnpack)
+{
+    ASSERT_EQ(sizeof(Move), 2);
+
+    Move quiet(square_index(0, 6), square_index(2, 5));
+    ASSERT_EQ(quiet.from(), square_index(0, 6));
+    ASSERT_EQ(quiet.to(), square_index(2, 5));
+    ASSERT_EQ(quiet.flag(), MoveFlag::NORMAL);
+    ASSERT_EQ(quiet.promotion(), Piece::EMPTY);
+
+    for (MoveFlag flag : { MoveFlag::DOUBLE_PUSH, MoveFlag::CASTLING, MoveFlag::EN_PASSANT })
+    {
+        Move move(63, 0, flag);
+        ASSERT_EQ(move.from(), 63);
+        ASSERT_EQ(move.to(), 0);
+        ASSERT_EQ(move.flag(), flag);
+        ASSERT_EQ(move.promotion(), Piece::EMPTY);
+    }
+
+    for (Piece promotion : { Piece::KNIGHT, Piece::BISHOP, Piece::ROOK, Piece::QUEEN })
+    {
+        Move move(square_index(6, 0), square_index(7, 1), MoveFlag::PROMOTION, promotion);
+        ASSERT_EQ(move.flag(), MoveFlag::PROMOTION);
+        ASSERT_EQ(move.promotion(), promotion);
+        ASSERT_EQ(move.to_long_algebraic(), string("a7b8") + "nbrq"[(int)(move.raw() >> 12) - 4]);
+    }
+
+    // A promotion without a piece is to a queen
+    ASSERT_EQ(Move(square_index(6, 0), square_index(7, 0), MoveFlag::PROMOTION).promotion(), Piece::QUEEN);
+}
+
+TEST(MoveTest, AssertMoveListHoldsMoves)
+{
+    MoveList moves;
+    ASSERT_TRUE(moves.empty());
+
+    for (int sq = 0; sq < NUM_SQUARES; sq++) moves.push_back(Move(sq, 63 - sq));
+    ASSERT_EQ(moves.size(), NUM_SQUARES);
+    ASSERT_EQ(moves[10].to(), 53);
+    ASSERT_TRUE(moves.contains(Move(20, 43)));
+    ASSERT_FALSE(moves.contains(Move(20, 44)));
+
+    moves.clear();
+    ASSERT_EQ(moves.size(), 0);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "logic.hpp"
+#include "movegen.hpp"
 #include "file_handler.hpp"
 
 using namespace LogicEngine;
@@ -10,33 +11,33 @@ namespace fs = std::filesystem;
 
 TEST(DetectMoves, DetectQueenMoves) {
 	Chessboard queen_board("positions/test_blank.txt");
-	vector<Square> queen_moves;
+	MoveList queen_moves;
 	int queen_col = 3, queen_row = 5;
 
 	// Test with a board with just a white queen in the middle
-	queen_board.board[queen_col][queen_row] = Square(Piece::QUEEN, Colour::WHITE, queen_col, queen_row, false, {});
-	queen_moves = get_valid_square_moves(queen_board.board[queen_col][queen_row], queen_board, Colour::BLACK);
+	queen_board.set_square(queen_col, queen_row, Square(Piece::QUEEN, Colour::WHITE, queen_col, queen_row));
+	queen_moves = get_valid_square_moves(queen_board.board[queen_col][queen_row], queen_board);
 	ASSERT_EQ(queen_moves.size(), 25);
 
 	// Now add a black rook to block the queen's path orthogonally and test again
-	queen_board.board[3][4] = Square(Piece::ROOK, Colour::BLACK, 3, 4, false, {});
-	queen_moves = get_valid_square_moves(queen_board.board[queen_col][queen_row], queen_board, Colour::BLACK);
+	queen_board.set_square(3, 4, Square(Piece::ROOK, Colour::BLACK, 3, 4));
+	queen_moves = get_valid_square_moves(queen_board.board[queen_col][queen_row], queen_board);
 	ASSERT_EQ(queen_moves.size(), 21);
 
 	// Now add a white rook to block the queen's path diagonally and test again
-	queen_board.board[4][6] = Square(Piece::ROOK, Colour::WHITE, 4, 6, false, {});
-	queen_moves = get_valid_square_moves(queen_board.board[queen_col][queen_row], queen_board, Colour::BLACK);
+	queen_board.set_square(4, 6, Square(Piece::ROOK, Colour::WHITE, 4, 6));
+	queen_moves = get_valid_square_moves(queen_board.board[queen_col][queen_row], queen_board);
 	ASSERT_EQ(queen_moves.size(), 19);
 }
 
 TEST(DetectMoves, DetectKnightMovesInCentre) {
 	Chessboard knight_board("positions/test_blank.txt");
-	vector<Square> knight_moves;
+	MoveList knight_moves;
 	int knight_col = 3, knight_row = 5;
 
 	// Test with a board with just a black knight in the middle
-	knight_board.board[knight_col][knight_row] = Square(Piece::KNIGHT, Colour::BLACK, knight_col, knight_row, false, {});
-	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board, Colour::WHITE);
+	knight_board.set_square(knight_col, knight_row, Square(Piece::KNIGHT, Colour::BLACK, knight_col, knight_row));
+	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board);
 	ASSERT_EQ(knight_moves.size(), 8);
 
 	// Now surround the knight in white rooks which should not block the knight's path and test again
@@ -45,103 +46,195 @@ TEST(DetectMoves, DetectKnightMovesInCentre) {
 		for (int j = -1; j < 1; j++)
 		{
 			if (i == 0 && j == 0) continue; // Skip the knight's position
-			knight_board.board[knight_col + i][knight_row + j] = Square(Piece::ROOK, Colour::WHITE, knight_col + i, knight_row + j, false, {});
+			knight_board.set_square(knight_col + i, knight_row + j, Square(Piece::ROOK, Colour::WHITE, knight_col + i, knight_row + j));
 		}
 	}
-	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board, Colour::WHITE);
+	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board);
 	ASSERT_EQ(knight_moves.size(), 8);
 
 	// Now add a black pawn to block a knight's target and test again
-	knight_board.board[1][4] = Square(Piece::PAWN, Colour::BLACK, 1, 4, false, {});
-	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board, Colour::WHITE);
+	knight_board.set_square(1, 4, Square(Piece::PAWN, Colour::BLACK, 1, 4));
+	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board);
 	ASSERT_EQ(knight_moves.size(), 7);
 }
 
 TEST(DetectMoves, DetectKnightMovesInCorner) {
 	Chessboard knight_board("positions/test_blank.txt");
-	vector<Square> knight_moves;
+	MoveList knight_moves;
 	int knight_col = 7, knight_row = 7;
 
 	// Test with a board with just a black knight in the corner
-	knight_board.board[knight_col][knight_row] = Square(Piece::KNIGHT, Colour::BLACK, knight_col, knight_row, false, {});
-	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board, Colour::WHITE);
+	knight_board.set_square(knight_col, knight_row, Square(Piece::KNIGHT, Colour::BLACK, knight_col, knight_row));
+	knight_moves = get_valid_square_moves(knight_board.board[knight_col][knight_row], knight_board);
 	ASSERT_EQ(knight_moves.size(), 2);
 }
 
 TEST(DetectMoves, DetectKingMoves) {
 	Chessboard king_board("positions/test_blank.txt");
-	vector<Square> king_moves;
+	MoveList king_moves;
 	int king_col = 0, king_row = 0;
 
 	// Test with a board with just a white king in the corner
-	king_moves = get_valid_square_moves(king_board.board[king_col][king_row], king_board, Colour::BLACK);
+	king_moves = get_valid_square_moves(king_board.board[king_col][king_row], king_board);
 	ASSERT_EQ(king_moves.size(), 3);
 }
 
 TEST(DetectMoves, DetectKingMovesIntoDanger) {
 	Chessboard king_board("positions/test_blank.txt");
-	vector<Square> king_moves;
+	MoveList king_moves;
 	int king_col = 4, king_row = 4;
 
 	// Move the king to the centre of the board
 	switch_pieces(&king_board, { 0, 0 }, { king_col, king_row });
 
 	// Add some black pieces that could capture the white king in certain squares
-	king_board.board[4][6] = Square(Piece::KING, Colour::BLACK, 4, 6, false, {});
-	king_board.board[3][0] = Square(Piece::ROOK, Colour::BLACK, 3, 0, false, {});
-	king_board.board[4][3] = Square(Piece::PAWN, Colour::BLACK, 4, 3, false, {});
+	king_board.set_square(4, 6, Square(Piece::KING, Colour::BLACK, 4, 6));
+	king_board.set_square(3, 0, Square(Piece::ROOK, Colour::BLACK, 3, 0));
+	king_board.set_square(4, 3, Square(Piece::PAWN, Colour::BLACK, 4, 3));
 
-	king_moves = get_valid_square_moves(king_board.board[king_col][king_row], king_board, Colour::BLACK);
+	king_moves = get_valid_square_moves(king_board.board[king_col][king_row], king_board);
 	ASSERT_EQ(king_moves.size(), 3);
 }
 
 TEST(DetectMoves, DetectPawnMovesFoward) {
 	Chessboard pawn_board("positions/test_blank.txt");
-	vector<Square> pawn_moves;
+	MoveList pawn_moves;
 
 	// A white pawn on the second rank should be able to move one or two squares forward
 	int pawn_row = 1, pawn_col = 4;
-	pawn_board.board[pawn_row][pawn_col] = Square(Piece::PAWN, Colour::WHITE, pawn_row, pawn_col, false, {});
-	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board, Colour::BLACK);
+	pawn_board.set_square(pawn_row, pawn_col, Square(Piece::PAWN, Colour::WHITE, pawn_row, pawn_col));
+	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board);
 	ASSERT_EQ(pawn_moves.size(), 2);
 
 	// Move the pawn forward to the seventh rank
 	switch_pieces(&pawn_board, { pawn_row, pawn_col }, { 6, pawn_col });
-	pawn_board.board[6][pawn_col].has_moved = true;
-	pawn_moves = get_valid_square_moves(pawn_board.board[6][pawn_col], pawn_board, Colour::BLACK);
+	pawn_moves = get_valid_square_moves(pawn_board.board[6][pawn_col], pawn_board);
 	ASSERT_EQ(pawn_moves.size(), 1);
 
 	// Move the pawn forward to the eighth rank
 	switch_pieces(&pawn_board, { pawn_row, pawn_col }, { 7, pawn_col });
-	pawn_moves = get_valid_square_moves(pawn_board.board[7][pawn_col], pawn_board, Colour::BLACK);
+	pawn_moves = get_valid_square_moves(pawn_board.board[7][pawn_col], pawn_board);
 	ASSERT_EQ(pawn_moves.size(), 0);
 
 	// A black pawn on the seventh rank should be able to move one or two squares forward
 	pawn_row = 7, pawn_col = 5;
-	pawn_board.board[pawn_row][pawn_col] = Square(Piece::PAWN, Colour::BLACK, pawn_row, pawn_col, false, {});
-	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board, Colour::WHITE);
+	pawn_board.set_square(pawn_row, pawn_col, Square(Piece::PAWN, Colour::BLACK, pawn_row, pawn_col));
+	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board);
 	ASSERT_EQ(pawn_moves.size(), 2);
 }
 
 TEST(DetectMoves, DetectPawnMovesAttacking) {
 	Chessboard pawn_board("positions/test_blank.txt");
-	vector<Square> pawn_moves;
+	MoveList pawn_moves;
 
 	// A white pawn on the second rank should be able to move one or two squares forward
 	// If there are black pieces diagonally in front of it, it should be able to capture them
 	int pawn_row = 1, pawn_col = 4;
-	pawn_board.board[pawn_row][pawn_col] = Square(Piece::PAWN, Colour::WHITE, pawn_row, pawn_col, false, {});
+	pawn_board.set_square(pawn_row, pawn_col, Square(Piece::PAWN, Colour::WHITE, pawn_row, pawn_col));
 	
-	pawn_board.board[pawn_row + 1][pawn_col - 1] = Square(Piece::ROOK, Colour::BLACK, pawn_row + 1, pawn_col - 1, false, {});
-	pawn_board.board[pawn_row + 1][pawn_col + 1] = Square(Piece::ROOK, Colour::BLACK, pawn_row + 1, pawn_col + 1, false, {});
+	pawn_board.set_square(pawn_row + 1, pawn_col - 1, Square(Piece::ROOK, Colour::BLACK, pawn_row + 1, pawn_col - 1));
+	pawn_board.set_square(pawn_row + 1, pawn_col + 1, Square(Piece::ROOK, Colour::BLACK, pawn_row + 1, pawn_col + 1));
 	
-	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board, Colour::BLACK);
+	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board);
 	ASSERT_EQ(pawn_moves.size(), 4);
 
 	// If the rooks are white they should not be capturable
-	pawn_board.board[pawn_row + 1][pawn_col - 1].colour = Colour::WHITE;
-	pawn_board.board[pawn_row + 1][pawn_col + 1].colour = Colour::WHITE;
+	pawn_board.set_square(pawn_row + 1, pawn_col - 1, Square(Piece::ROOK, Colour::WHITE, pawn_row + 1, pawn_col - 1));
+	pawn_board.set_square(pawn_row + 1, pawn_col + 1, Square(Piece::ROOK, Colour::WHITE, pawn_row + 1, pawn_col + 1));
 
-	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board, Colour::BLACK);
+	pawn_moves = get_valid_square_moves(pawn_board.board[pawn_row][pawn_col], pawn_board);
 	ASSERT_EQ(pawn_moves.size(), 2);
-}
\ No newline at end of file
+}
+
+// Write out the valid moves of every piece on the board, in the form "e2=e3,e4 g1=f3,h3".
+string describe_valid_moves(const Chessboard& chessboard)
+{
+	string description = "";
+	for (int row = 0; row < DIM_SIZE; row++)
+	{
+		for (int col = 0; col < DIM_SIZE; col++)
+		{
+			Square target = chessboard.board[row][col];
+			if (target.colour == Colour::EMPTY) continue;
+
+			MoveList moves = get_valid_square_moves(target, chessboard);
+			sort(moves.begin(), moves.end(), [](const Move& a, const Move& b) { return a.to() < b.to(); });
+
+			if (description != "") description += " ";
+			description += string(1, 'a' + col) + to_string(row + 1) + "=";
+			for (int i = 0; i < moves.size(); i++)
+			{
+				if (i > 0) description += ",";
+				description += string(1, 'a' + square_col(moves[i].to())) + to_string(square_row(moves[i].to()) + 1);
+			}
+		}
+	}
+	return description;
+}
+
+TEST(DetectMoves, DetectSameMovesOnAllPositions) {
+	// The valid moves on each test position, as found by the move generator before it used check masks and pins.
+	// Two moves differ, where the old generator let the king step onto a square attacked only by a pawn:
+	// the white king's f1 in test_stalemate.txt and the black king's e7 in test_notation.txt.
+	map<string, string> expected_moves = {
+		{ "starting_position.txt",
+			"a1= b1=a3,c3 c1= d1= e1= f1= g1=f3,h3 h1= a2=a3,a4 b2=b3,b4 c2=c3,c4 d2=d3,d4 e2=e3,e4 f2=f3,f4 g2=g3,g4 h2=h3,h4 a7=a5,a6 b7=b5,b6 c7=c5,c6 d7=d5,d6 e7=e5,e6 f7=f5,f6 g7=g5,g6 h7=h5,h6 a8= b8=a6,c6 c8= d8= e8= f8= g8=f6,h6 h8=" },
+		{ "test_blank.txt",
+			"a1=b1,a2,b2 a8=a7,b7,b8" },
+		{ "test_castling.txt",
+			"a1=b1,c1,d1,a2,a3,a4,a5,a6,a7 e1=f1,e2,f2 h1=f1,g1,h2,h3,h4,h5,h6,h7 d3=d1,d2,a3,b3,c3,e3,f3,d4,d5,d6,d7,d8 g3=g1,g2,e3,f3,h3,g4,g5,g6,g7,g8 a7=a5,a6 h7=h5,h6 a8=b8,c8,d8 e8=d7,e7,f7,c8,d8,f8,g8 h8=f8,g8" },
+		{ "test_checkmate.txt",
+			"f2=e1,g1,e2,g2,e3,g3 c6=f3 e6=f5,f6,f7 d8= f8=e8,g8,h8 h8=f6,f8" },
+		{ "test_ep.txt",
+			"a1= b1=a3,c3 c1=b2,a3 d1= e1= f1= g1=f3,h3 h1= a2=a3,a4 c2=c3,c4 d2=d3,d4 e2=e3,e4 f2=f3 g2=g3,g4 h2=h3 b4=b5 f4=f3 h4=h3 a7=a5,a6 b7=b5,b6 c7=c5,c6 d7=d5,d6 e7=e5,e6 g7=g5,g6 a8= b8=a6,c6 c8= d8= e8=f7 f8= g8=f6,h6 h8=h5,h6,h7" },
+		{ "test_notation.txt",
+			"d1=e1,d2,e2 b2=d3,a4,c4 b3=a2,c2,a4,c4 e3=f1,c2,g2,c4,g4,f5 c4=c1,c2,c3,a4,b4,d4,e4,f4,g4,h4,c5,c6,c7,c8 b5=a4,c4,a6,c6,d7,e8 d5=h1,g2,f3,c4,e4,c6,e6,b7,f7,a8,g8 e5=d3,f3,c4,g4,c6,g6,d7,f7 f6=f7,g7 h6=g7,h7 g7=g1,g2,g3,g4,g5,g6,a7,b7,c7,d7,e7,f7,h7,g8 d8=c7,c8" },
+		{ "test_promotion.txt",
+			"a1=b1,b2 g2=g1 d6=d1,d2,d3,d4,d5,a6,b6,c6 e6=e1,a2,e2,b3,e3,h3,c4,e4,g4,d5,e5,f5 f6=f1,f2,f3,f4,f5,g6,h6 d7= e7= f7= g7=f8,g8 d8=a5,b6,c7 e8= f8=g7" },
+		{ "test_stalemate.txt",
+			"f2=e1,g1,e2,g2,e3,f3,g3 g2=g1 c6=c1,c2,g2,c3,f3,a4,c4,e4,b5,c5,d5,a6,b6,d6,e6,f6,g6,h6,b7,c7,d7,a8,c8,e8 h7=b1,h1,c2,h2,d3,h3,e4,h4,f5,h5,g6,h6,a7,b7,c7,d7,e7,f7,g7,g8,h8 d8=" }
+	};
+
+	for (const auto& entry : fs::directory_iterator(fs::current_path().append("positions")))
+	{
+		if (entry.path().extension() != ".txt") continue;
+		string filename = entry.path().filename().string();
+		ASSERT_EQ(expected_moves.count(filename), 1) << filename;
+
+		Chessboard test_board("positions/" + filename);
+		ASSERT_EQ(describe_valid_moves(test_board), expected_moves[filename]) << filename;
+	}
+}
+
+TEST(DetectMoves, DetectKingMovesIntoPawnAttacks) {
+	Chessboard king_board("positions/test_blank.txt");
+	MoveList king_moves;
+
+	// A black pawn on b3 attacks a2 and c2, so the white king on a1 can only step to b1 and b2 (which the pawn does not attack)
+	king_board.set_square(2, 1, Square(Piece::PAWN, Colour::BLACK, 2, 1));
+	king_moves = get_valid_square_moves(king_board.board[0][0], king_board);
+	ASSERT_EQ(king_moves.size(), 2);
+
+	// A pawn attacking the king gives check, and the king can capture it as nothing defends it
+	king_board.set_square(2, 1, Square());
+	king_board.set_square(1, 1, Square(Piece::PAWN, Colour::BLACK, 1, 1));
+	ASSERT_TRUE(is_king_attacked(king_board, Colour::WHITE));
+	king_moves = get_valid_square_moves(king_board.board[0][0], king_board);
+	ASSERT_EQ(king_moves.size(), 3);
+}
+
+TEST(DetectMoves, DetectPinnedPieceMoves) {
+	Chessboard pin_board("positions/test_blank.txt");
+	MoveList rook_moves;
+
+	// A white rook on a4 is pinned to the king on a1 by a black rook on a6: it can only move along the a-file
+	pin_board.set_square(3, 0, Square(Piece::ROOK, Colour::WHITE, 3, 0));
+	pin_board.set_square(5, 0, Square(Piece::ROOK, Colour::BLACK, 5, 0));
+	rook_moves = get_valid_square_moves(pin_board.board[3][0], pin_board);
+	ASSERT_EQ(rook_moves.size(), 4);
+
+	// Once a black knight checks the king from b3, the pinned rook cannot capture it or block, so it has no moves
+	pin_board.set_square(2, 1, Square(Piece::KNIGHT, Colour::BLACK, 2, 1));
+	rook_moves = get_valid_square_moves(pin_board.board[3][0], pin_board);
+	ASSERT_EQ(rook_moves.size(), 0);
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include "logic.hpp"
+#include "movegen.hpp"
+#include "movepick.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+const string KIWIPETE = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+
+vector<Move> pick_all(MovePicker* picker)
+{
+    vector<Move> moves;
+    for (Move move = picker->next(); move != Move(); move = picker->next()) moves.push_back(move);
+    return moves;
+}
+
+TEST(MoveGenTypeTest, NoisyAndQuietMovesMakeUpAllMoves)
+{
+    Chessboard board("positions/test_blank.txt");
+    // white can capture en passant on c6, and promote by taking on a8 or pushing to b8
+    ASSERT_TRUE(board.load_fen("r3k3/1P6/8/2pPp3/8/8/8/4K2R w K c6 0 1"));
+
+    MoveList all = get_all_legal_moves(board);
+    MoveList noisy = get_all_legal_moves(board, MoveGenType::NOISY);
+    MoveList quiet = get_all_legal_moves(board, MoveGenType::QUIET);
+    ASSERT_EQ(noisy.size() + quiet.size(), all.size());
+    for (Move move : noisy) ASSERT_TRUE(all.contains(move) && is_noisy(board, move));
+    for (Move move : quiet) ASSERT_TRUE(all.contains(move) && !is_noisy(board, move));
+
+    // four promotions by capture on a8, four by pushing to b8, and the en passant capture
+    ASSERT_EQ(noisy.size(), 9);
+    ASSERT_TRUE(noisy.contains(Move(square_index(4, 3), square_index(5, 2), MoveFlag::EN_PASSANT)));
+    ASSERT_TRUE(quiet.contains(Move(square_index(0, 4), square_index(0, 6), MoveFlag::CASTLING)));
+}
+
+TEST(MovePickerTest, GivesEveryLegalMoveOnce)
+{
+    Chessboard board("positions/test_blank.txt");
+    ASSERT_TRUE(board.load_fen(KIWIPETE));
+    HistoryTable history;
+    Move killers[2] = { Move(square_index(1, 0), square_index(2, 0)), Move(square_index(1, 0), square_index(4, 0)) };  // a3, then an impossible a5
+    MovePicker picker(board, Move(square_index(4, 4), square_index(6, 5)), killers, history);  // Nxf7
+
+    vector<Move> picked = pick_all(&picker);
+    MoveList legal = get_all_legal_moves(board);
+    ASSERT_EQ(picked.size(), legal.size());
+    for (Move move : legal) ASSERT_EQ(count(picked.begin(), picked.end(), move), 1);
+}
+
+TEST(MovePickerTest, StagesComeInOrder)
+{
+    Chessboard board("positions/test_blank.txt");
+    ASSERT_TRUE(board.load_fen(KIWIPETE));
+    HistoryTable history;
+    Move quiet_move(square_index(1, 6), square_index(2, 6));   // g3
+    history.add(Colour::WHITE, quiet_move, 10);
+    Move tt_move(square_index(0, 4), square_index(0, 6), MoveFlag::CASTLING);
+    Move killers[2] = { Move(square_index(1, 0), square_index(2, 0)), Move() };
+
+    MovePicker picker(board, tt_move, killers, history);
+    vector<Move> picked = pick_all(&picker);
+    ASSERT_EQ(picked[0], tt_move);
+
+    // the winning and even captures come next, led by the bishop taking a bishop
+    int first_quiet = 1;
+    while (is_noisy(board, picked[first_quiet])) first_quiet++;
+    ASSERT_EQ(first_quiet, 4);
+    ASSERT_EQ(picked[1], Move(square_index(1, 4), square_index(5, 0)));  // Bxa6
+    ASSERT_EQ(picked[first_quiet], killers[0]);
+    ASSERT_EQ(picked[first_quiet + 1], quiet_move);
+
+    // and the captures that lose material come last, ending with the queen taking a pawn defended by the rook on h8
+    for (int i = (int)picked.size() - 5; i < picked.size(); i++) ASSERT_TRUE(is_noisy(board, picked[i]));
+    ASSERT_FALSE(is_noisy(board, picked[picked.size() - 6]));
+    ASSERT_EQ(picked.back(), Move(square_index(2, 5), square_index(2, 7)));   // Qxh3
+}
+
+TEST(MovePickerTest, SkipsIllegalTableMove)
+{
+    Chessboard board("positions/starting_position.txt");
+    HistoryTable history;
+    MovePicker picker(board, Move(square_index(6, 4), square_index(4, 4), MoveFlag::DOUBLE_PUSH), nullptr, history);   // black's e5
+
+    vector<Move> picked = pick_all(&picker);
+    ASSERT_EQ(picked.size(), 20);
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "logic.hpp"
+#include "movegen.hpp"
+#include "perft.hpp"
+#include "evaluate.hpp"
+#include "search.hpp"
+#include "nnue.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+Chessboard flip_colours(const Chessboard& board);  // from test_evaluate.cpp
+
+// Each test evaluates with a random network, and goes back to the piece-square tables afterwards so other tests are unaffected.
+class NnueTest : public ::testing::Test
+{
+protected:
+    void SetUp() override { set_network(random_network(42)); }
+    void TearDown() override
+    {
+        set_network(nullptr);
+        set_simd_path(best_path);
+    }
+
+    SimdPath best_path = get_simd_path();
+};
+
+TEST_F(NnueTest, IncrementalAccumulatorMatchesScratch)
+{
+    // play a fixed sequence of moves through each position, covering captures, castling, en passant, promotions and king moves along the way
+    for (const PerftPosition& position : PERFT_POSITIONS)
+    {
+        Chessboard board("positions/test_blank.txt");
+        ASSERT_TRUE(board.load_fen(position.fen));
+        int start = nnue_evaluate(board);
+
+        vector<UndoInfo> undos;
+        for (int ply = 0; ply < 40; ply++)
+        {
+            MoveList moves = get_all_legal_moves(board);
+            if (moves.empty()) break;
+            undos.push_back(board.do_move(moves[(ply * 7) % moves.size()]));
+
+            Accumulator scratch = compute_accumulator(board);
+            ASSERT_TRUE(board.accumulator.agrees_with(scratch)) << position.name << " ply " << ply;
+            int score = nnue_evaluate(board);
+            ASSERT_TRUE(board.accumulator.agrees_with(scratch)) << position.name << " ply " << ply;
+
+            Chessboard fresh("positions/test_blank.txt");
+            ASSERT_TRUE(fresh.load_fen(position.fen));
+            for (const UndoInfo& undo : undos) fresh.do_move(undo.move);
+            ASSERT_EQ(nnue_evaluate(fresh), score) << position.name << " ply " << ply;
+        }
+        while (!undos.empty())
+        {
+            board.undo_move(undos.back());
+            undos.pop_back();
+            ASSERT_TRUE(board.accumulator.agrees_with(compute_accumulator(board))) << position.name;
+        }
+        ASSERT_EQ(nnue_evaluate(board), start) << position.name;
+    }
+}
+
+TEST_F(NnueTest, EverySimdPathGivesTheSameScores)
+{
+    vector<int> scalar_scores;
+    for (SimdPath path : { SimdPath::SCALAR, SimdPath::SSE41, SimdPath::AVX2 })
+    {
+        if (!set_simd_path(path)) continue;
+
+        vector<int> scores;
+        for (const PerftPosition& position : PERFT_POSITIONS)
+        {
+            Chessboard board("positions/test_blank.txt");
+            ASSERT_TRUE(board.load_fen(position.fen));
+            for (int ply = 0; ply < 20; ply++)
+            {
+                scores.push_back(nnue_evaluate(board));
+                MoveList moves = get_all_legal_moves(board);
+                if (moves.empty()) break;
+                board.do_move(moves[(ply * 3) % moves.size()]);
+            }
+        }
+
+        if (path == SimdPath::SCALAR)
+            scalar_scores = scores;
+        else
+            ASSERT_EQ(scores, scalar_scores) << simd_path_name(path);
+    }
+}
+
+TEST_F(NnueTest, FlippedColoursSwapViews)
+{
+    // with the colours swapped, the side to move sees exactly what the other side saw before
+    for (const PerftPosition& position : PERFT_POSITIONS)
+    {
+        Chessboard board("positions/test_blank.txt");
+        ASSERT_TRUE(board.load_fen(position.fen));
+        Chessboard flipped = flip_colours(board);
+        board.set_active_player((board.active_player == Colour::WHITE) ? Colour::BLACK : Colour::WHITE);
+        ASSERT_EQ(nnue_evaluate(flipped), nnue_evaluate(board)) << position.name;
+    }
+}
+
+TEST_F(NnueTest, SavedNetworkLoadsTheSame)
+{
+    Chessboard board("positions/test_blank.txt");
+    ASSERT_TRUE(board.load_fen(PERFT_POSITIONS[1].fen));
+    int score = nnue_evaluate(board);
+
+    string path = (filesystem::temp_directory_path() / "chess3d_test.nnue").string();
+    ASSERT_TRUE(save_network(*random_network(42), path));
+    set_network(random_network(7));
+    ASSERT_NE(nnue_evaluate(board), score);
+
+    ASSERT_TRUE(load_network(path));
+    ASSERT_EQ(nnue_evaluate(board), score);
+
+    // a file cut short is turned down, and the network in use is kept
+    filesystem::resize_file(path, filesystem::file_size(path) - 1);
+    ASSERT_FALSE(load_network(path));
+    ASSERT_FALSE(load_network("positions/starting_position.txt"));
+    ASSERT_EQ(nnue_evaluate(board), score);
+    filesystem::remove(path);
+}
+
+TEST_F(NnueTest, EvaluateUsesNetworkWhileLoaded)
+{
+    Chessboard board("positions/starting_position.txt");
+    ASSERT_EQ(evaluate(board), nnue_evaluate(board));
+
+    // without kings there are no features to look from, so the piece-square tables are used
+    Chessboard no_kings("positions/test_blank.txt");
+    ASSERT_TRUE(no_kings.load_fen("8/3p4/8/8/8/8/4P3/8 w - - 0 1"));
+    ASSERT_FALSE(nnue_can_evaluate(no_kings));
+
+    set_network(nullptr);
+    ASSERT_FALSE(nnue_can_evaluate(board));
+    ASSERT_EQ(evaluate(board), 0);
+}
+
+TEST_F(NnueTest, SearchesWithNetwork)
+{
+    Chessboard board("positions/starting_position.txt");
+    Key key = board.key;
+    TranspositionTable tt(1);
+    Searcher searcher(&tt);
+    SearchLimits limits;
+    limits.depth = 3;
+
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_TRUE(get_all_legal_moves(board).contains(info.best_move()));
+    ASSERT_EQ(board.key, key);
+    ASSERT_TRUE(board.accumulator.agrees_with(compute_accumulator(board)));
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "logic.hpp"
+#include "movegen.hpp"
+#include "perft.hpp"
+#include "evaluate.hpp"
+#include "pawns.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+Chessboard board_from_fen(string fen);  // from test_search.cpp
+
+static int sq(const string& name) { return square_index(name[1] - '1', name[0] - 'a'); }
+
+TEST(PawnsTest, PawnKeyMatchesScratchKey)
+{
+    for (const PerftPosition& position : PERFT_POSITIONS)
+    {
+        Chessboard board = board_from_fen(position.fen);
+        Key start = board.pawn_key;
+        ASSERT_EQ(start, board.compute_pawn_key()) << position.name;
+
+        vector<UndoInfo> undos;
+        for (int ply = 0; ply < 40; ply++)
+        {
+            MoveList moves = get_all_legal_moves(board);
+            if (moves.empty()) break;
+
+            Move move = moves[(ply * 7) % moves.size()];
+            Key before = board.pawn_key;
+            bool touches_pawns = board.board[square_row(move.from())][square_col(move.from())].piece == Piece::PAWN
+                || board.board[square_row(move.to())][square_col(move.to())].piece == Piece::PAWN;
+
+            undos.push_back(board.do_move(move));
+            ASSERT_EQ(board.pawn_key, board.compute_pawn_key()) << position.name << " ply " << ply;
+            if (!touches_pawns)
+            {
+                ASSERT_EQ(board.pawn_key, before) << position.name << " ply " << ply;
+            }
+        }
+        while (!undos.empty())
+        {
+            board.undo_move(undos.back());
+            undos.pop_back();
+        }
+        ASSERT_EQ(board.pawn_key, start) << position.name;
+    }
+}
+
+TEST(PawnsTest, FindsPassedPawns)
+{
+    // the a-pawn and d-pawn are passed; the g-pawn is held up by the pawn on h6
+    Chessboard board = board_from_fen("4k3/8/7p/3P4/8/P5P1/8/4K3 w - - 0 1");
+    PawnEntry entry = evaluate_pawns(board);
+    ASSERT_EQ(entry.passed[0], square_bb(sq("a3")) | square_bb(sq("d5")));
+    ASSERT_EQ(entry.passed[1], 0ULL);
+
+    // the black pawn is passed once the g-pawn is gone
+    board = board_from_fen("4k3/8/7p/3P4/8/P7/8/4K3 w - - 0 1");
+    ASSERT_EQ(evaluate_pawns(board).passed[1], square_bb(sq("h6")));
+}
+
+TEST(PawnsTest, PenalisesDoubledAndIsolatedPawns)
+{
+    // connected pawns on their own, against the same pawns with one doubled, and with one cut off
+    PawnEntry healthy = evaluate_pawns(board_from_fen("4k3/pp6/8/8/8/8/PP6/4K3 w - - 0 1"));
+    PawnEntry doubled = evaluate_pawns(board_from_fen("4k3/pp6/8/8/8/P7/P7/4K3 w - - 0 1"));
+    PawnEntry isolated = evaluate_pawns(board_from_fen("4k3/pp6/8/8/8/8/P1P5/4K3 w - - 0 1"));
+
+    ASSERT_EQ(healthy.mg[0], healthy.mg[1]);
+    ASSERT_EQ(healthy.eg[0], healthy.eg[1]);
+    ASSERT_LT(doubled.mg[0], healthy.mg[0]);
+    ASSERT_LT(doubled.eg[0], healthy.eg[0]);
+    ASSERT_LT(isolated.mg[0], healthy.mg[0]);
+    ASSERT_LT(isolated.eg[0], healthy.eg[0]);
+}
+
+TEST(PawnsTest, PenalisesBackwardPawns)
+{
+    // the d-pawn has fallen behind the pawn beside it, and its stop square is covered by the black pawn on e5
+    PawnEntry backward = evaluate_pawns(board_from_fen("4k3/8/8/4p3/2P5/3P4/8/4K3 w - - 0 1"));
+    // the same pawns with the d-pawn level with its neighbour
+    PawnEntry level = evaluate_pawns(board_from_fen("4k3/8/8/4p3/2PP4/8/8/4K3 w - - 0 1"));
+
+    ASSERT_LT(backward.mg[0], level.mg[0]);
+    ASSERT_LT(backward.eg[0], level.eg[0]);
+}
+
+TEST(PawnsTest, TableReturnsCachedEntries)
+{
+    Chessboard board = board_from_fen("4k3/pp6/8/3P4/8/P7/P7/4K3 w - - 0 1");
+    PawnTable table(1024);
+
+    PawnEntry first = table.probe(board);
+    ASSERT_EQ(table.get_probes(), 1);
+    ASSERT_EQ(table.get_hits(), 0);
+
+    // a king move leaves the pawns alone, so the structure is found in the table
+    board.do_move(Move(sq("e1"), sq("f1")));
+    PawnEntry second = table.probe(board);
+    ASSERT_EQ(table.get_probes(), 2);
+    ASSERT_EQ(table.get_hits(), 1);
+    ASSERT_EQ(second.key, first.key);
+    ASSERT_EQ(second.passed[0], first.passed[0]);
+    ASSERT_EQ(second.mg[0], first.mg[0]);
+
+    table.clear_stats();
+    ASSERT_EQ(table.get_probes(), 0);
+    ASSERT_EQ(table.get_hits(), 0);
+}
+
+TEST(PawnsTest, CachedEvaluationMatchesScratchEvaluation)
+{
+    PawnTable table(64);    // small, so entries are overwritten along the way
+    for (const PerftPosition& position : PERFT_POSITIONS)
+    {
+        Chessboard board = board_from_fen(position.fen);
+        for (int ply = 0; ply < 40; ply++)
+        {
+            ASSERT_EQ(evaluate(board, &table), evaluate(board)) << position.name << " ply " << ply;
+
+            MoveList moves = get_all_legal_moves(board);
+            if (moves.empty()) break;
+            board.do_move(moves[(ply * 3) % moves.size()]);
+        }
+    }
+    ASSERT_GT(table.get_hits(), 0);
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include "logic.hpp"
+#include "perft.hpp"
+
+using namespace LogicEngine;
+using namespace std;
+
+TEST(LoadFenTest, StartingPositionMatchesPositionFile)
+{
+    Chessboard file_board("positions/starting_position.txt");
+    Chessboard fen_board("positions/test_blank.txt");
+    ASSERT_TRUE(fen_board.load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+
+    for (int row = 0; row < DIM_SIZE; row++)
+    {
+        for (int col = 0; col < DIM_SIZE; col++)
+        {
+            ASSERT_EQ(fen_board.board[row][col].piece, file_board.board[row][col].piece);
+            ASSERT_EQ(fen_board.board[row][col].colour, file_board.board[row][col].colour);
+        }
+    }
+    ASSERT_EQ(fen_board.active_player, Colour::WHITE);
+    ASSERT_EQ(fen_board.move_no, 1);
+    ASSERT_EQ(fen_board.castling_rights, file_board.castling_rights);
+    ASSERT_EQ(fen_board.ep_square, -1);
+    ASSERT_EQ(fen_board.key, file_board.key);
+}
+
+TEST(LoadFenTest, SideCastlingAndEnPassantAreRead)
+{
+    Chessboard test_board("positions/test_blank.txt");
+
+    // After 1.e4 c5 2.e5 d5, white can capture on d6 en passant, and has lost queenside castling
+    ASSERT_TRUE(test_board.load_fen("rnbqkbnr/pp2pppp/8/2ppP3/8/8/PPPP1PPP/RNBQKBNR w Kkq d6 0 3"));
+    ASSERT_EQ(test_board.move_no, 5);
+    ASSERT_EQ(test_board.castling_rights, WHITE_OO | BLACK_OO | BLACK_OOO);
+    ASSERT_EQ(test_board.ep_square, square_index(5, 3));
+
+    MoveList pawn_moves = test_board.find_valid_moves(test_board.board[4][4]);
+    ASSERT_EQ(pawn_moves.size(), 2);
+
+    // Black to move keeps the move number, and is one ply later
+    ASSERT_TRUE(test_board.load_fen("8/8/8/8/8/8/8/K6k b - - 0 3"));
+    ASSERT_EQ(test_board.active_player, Colour::BLACK);
+    ASSERT_EQ(test_board.move_no, 6);
+    ASSERT_EQ(test_board.castling_rights, 0);
+}
+
+TEST(LoadFenTest, MalformedFenIsRejected)
+{
+    Chessboard test_board("positions/starting_position.txt");
+    Key start_key = test_board.key;
+
+    ASSERT_FALSE(test_board.load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP w KQkq - 0 1"));
+    ASSERT_FALSE(test_board.load_fen("rnbqkbnr/pppppppp/9/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+    ASSERT_FALSE(test_board.load_fen("rnbqkbnr/ppppxppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"));
+    ASSERT_FALSE(test_board.load_fen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR x KQkq - 0 1"));
+    ASSERT_EQ(test_board.key, start_key);
+}
+
+TEST(PerftTest, ReferencePositionsMatchKnownCounts)
+{
+    // Only run the depths that finish quickly; chess3d_perft runs the deeper ones
+    for (const PerftPosition& position : PERFT_POSITIONS)
+    {
+        Chessboard test_board("positions/test_blank.txt");
+        ASSERT_TRUE(test_board.load_fen(position.fen));
+
+        for (int depth = 1; depth <= position.node_counts.size() && position.node_counts[depth - 1] <= 100000; depth++)
+            ASSERT_EQ(perft(&test_board, depth), position.node_counts[depth - 1]) << position.name << " at depth " << depth;
+    }
+}
+
+TEST(PerftTest, DivideAddsUpToPerft)
+{
+    Chessboard test_board("positions/starting_position.txt");
+    Key start_key = test_board.key;
+
+    vector<tuple<Move, uint64_t>> results = perft_divide(&test_board, 3);
+    ASSERT_EQ(results.size(), 20);
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < results.size(); i++) nodes += get<1>(results[i]);
+    ASSERT_EQ(nodes, 8902);
+
+    // making and unmaking every move leaves the board as it was
+    ASSERT_EQ(test_board.key, start_key);
+    ASSERT_EQ(perft(&test_board, 3), 8902);
+}
+
+TEST(PerftTest, ThreadsAndHashGiveTheSameCounts)
+{
+    Chessboard test_board("positions/test_blank.txt");
+    ASSERT_TRUE(test_board.load_fen(PERFT_POSITIONS[1].fen));
+
+    vector<tuple<Move, uint64_t>> expected = perft_divide(&test_board, 3);
+    PerftTable table(1);
+    for (int threads : { 1, 2, 4 })
+    {
+        vector<tuple<Move, uint64_t>> results = perft_divide(&test_board, 3, threads, &table);
+        ASSERT_EQ(results.size(), expected.size());
+        for (int i = 0; i < results.size(); i++)
+        {
+            ASSERT_EQ(get<0>(results[i]).to_long_algebraic(), get<0>(expected[i]).to_long_algebraic());
+            ASSERT_EQ(get<1>(results[i]), get<1>(expected[i]));
+        }
+    }
+}
+
+TEST(PerftTest, PerftTableStoresByKeyAndDepth)
+{
+    PerftTable table(1);
+    uint64_t nodes = 0;
+
+    ASSERT_FALSE(table.probe(0x1234, 3, &nodes));
+    table.store(0x1234, 3, 8902);
+    ASSERT_TRUE(table.probe(0x1234, 3, &nodes));
+    ASSERT_EQ(nodes, 8902);
+
+    // the same position at another depth, or another position in the same entry, is a miss
+    ASSERT_FALSE(table.probe(0x1234, 4, &nodes));
+    ASSERT_FALSE(table.probe(0x1234 + (1ULL << 40), 3, &nodes));
+}
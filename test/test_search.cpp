@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+#include "logic.hpp"
+#include "movegen.hpp"
+#include "search.hpp"
+#include "perft.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+Chessboard board_from_fen(string fen)
+{
+    Chessboard board("positions/test_blank.txt");
+    EXPECT_TRUE(board.load_fen(fen));
+    return board;
+}
+
+TEST(SearchTest, FindsBackRankMate)
+{
+    Chessboard board = board_from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    SearchLimits limits;
+    limits.depth = 4;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_EQ(info.best_move(), Move(square_index(0, 0), square_index(7, 0)));
+    ASSERT_EQ(info.score, MATE_SCORE - 1);
+    ASSERT_NE(format_info(info).find("score mate 1 "), string::npos);
+}
+
+TEST(SearchTest, TakesHangingQueen)
+{
+    Chessboard board = board_from_fen("4k3/8/8/3q4/8/8/8/3RK3 w - - 0 1");
+    SearchLimits limits;
+    limits.depth = 3;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_EQ(info.best_move(), Move(square_index(0, 3), square_index(4, 3)));
+    ASSERT_EQ(info.depth, 3);
+    ASSERT_GT(info.score, 400);
+}
+
+TEST(SearchTest, QuiescenceSeesRecapture)
+{
+    // at depth 1 the queen taking the pawn on d5 looks like it wins a pawn, until the recapture is searched
+    Chessboard board = board_from_fen("4k3/8/2p5/3p4/8/8/8/3QK3 w - - 0 1");
+    SearchLimits limits;
+    limits.depth = 1;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_NE(info.best_move(), Move(square_index(0, 3), square_index(4, 3)));
+    ASSERT_GT(info.score, 600);
+    ASSERT_LT(info.score, 800);
+    ASSERT_GT(info.qnodes, 0);
+    ASSERT_LE(info.qnodes, info.nodes);
+}
+
+TEST(SearchTest, QuiescenceSearchesCheckEvasions)
+{
+    // Qxf7+ leaves the black king in check at the horizon; the only evasion, Kxf7, loses the queen back
+    Chessboard board = board_from_fen("4k3/5p2/8/8/8/8/5Q2/4K3 w - - 0 1");
+    SearchLimits limits;
+    limits.depth = 1;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_NE(info.best_move(), Move(square_index(1, 5), square_index(6, 5)));
+    ASSERT_GT(info.score, 700);
+}
+
+TEST(SearchTest, StalemateScoresZeroWithoutMoves)
+{
+    Chessboard board = board_from_fen("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1");
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, SearchLimits());
+    ASSERT_EQ(info.score, 0);
+    ASSERT_TRUE(info.pv.empty());
+}
+
+TEST(SearchTest, BoardIsLeftUnchanged)
+{
+    Chessboard board = board_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    Key key = board.key;
+    SearchLimits limits;
+    limits.depth = 3;
+
+    Searcher searcher;
+    searcher.search(&board, limits);
+    ASSERT_EQ(board.key, key);
+    ASSERT_EQ(board.castling_rights, WHITE_OO | WHITE_OOO | BLACK_OO | BLACK_OOO);
+    ASSERT_EQ(board.active_player, Colour::WHITE);
+    ASSERT_TRUE(board.attacks == board.compute_attacks());
+}
+
+TEST(SearchTest, PrincipalVariationIsLegal)
+{
+    Chessboard board("positions/starting_position.txt");
+    SearchLimits limits;
+    limits.depth = 4;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_EQ(info.pv.size(), 4);
+    for (Move move : info.pv)
+    {
+        ASSERT_TRUE(get_all_legal_moves(board).contains(move));
+        board.do_move(move);
+    }
+}
+
+TEST(SearchTest, StopsAtNodeLimit)
+{
+    Chessboard board("positions/starting_position.txt");
+    SearchLimits limits;
+    limits.nodes = 5000;
+
+    vector<int> depths;
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits, [&](const SearchInfo& iteration) { depths.push_back(iteration.depth); });
+    ASSERT_LE(info.nodes, 5000);
+    ASSERT_GE(info.depth, 1);
+    ASSERT_FALSE(info.pv.empty());
+    ASSERT_EQ(depths.back(), info.depth);
+    for (int i = 0; i < depths.size(); i++) ASSERT_EQ(depths[i], i + 1);
+}
+
+TEST(SearchTest, StopsAtTimeLimit)
+{
+    Chessboard board("positions/starting_position.txt");
+    SearchLimits limits;
+    limits.time_ms = 100;
+
+    Searcher searcher;
+    auto start = chrono::steady_clock::now();
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_LT(chrono::duration<double>(chrono::steady_clock::now() - start).count(), 2.0);
+    ASSERT_FALSE(info.pv.empty());
+}
+
+TEST(SearchTest, FiftyMoveRuleScoresAsDraw)
+{
+    // White is a queen up, but every move it has reaches the hundredth ply without a capture or pawn move
+    Chessboard board = board_from_fen("7k/8/8/8/8/8/8/Q6K w - - 99 80");
+    SearchLimits limits;
+    limits.depth = 3;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_EQ(info.score, 0);
+}
+
+TEST(SearchTest, StoppedSearchCompletesFirstIteration)
+{
+    Chessboard board = board_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    SearchLimits limits;
+    limits.depth = 6;
+
+    // a stop made before the search starts is kept, and the search still finishes its first iteration with a legal move
+    Searcher searcher;
+    searcher.stop();
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_EQ(info.depth, 1);
+    ASSERT_TRUE(get_all_legal_moves(board).contains(info.best_move()));
+
+    // the stop lasts until cleared
+    info = searcher.search(&board, limits);
+    ASSERT_EQ(info.depth, 1);
+    searcher.clear_stop();
+    info = searcher.search(&board, limits);
+    ASSERT_EQ(info.depth, 6);
+}
+
+TEST(SearchTest, RepetitionOfGamePositionScoresAsDraw)
+{
+    // Black is lost, but the game has already been through the position after Kg8, so repeating it is a draw
+    Chessboard board = board_from_fen("6k1/8/8/8/8/8/2Q5/K7 w - - 0 1");
+    vector<Key> game_keys;
+    for (Move move : { Move(square_index(0, 0), square_index(0, 1)), Move(square_index(7, 6), square_index(7, 7)),
+        Move(square_index(0, 1), square_index(0, 0)) })
+    {
+        game_keys.push_back(board.key);
+        board.do_move(move);
+    }
+    SearchLimits limits;
+    limits.depth = 4;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_LT(info.score, -500);
+
+    info = searcher.search(&board, limits, nullptr, game_keys);
+    ASSERT_EQ(info.best_move(), Move(square_index(7, 7), square_index(7, 6)));
+    ASSERT_EQ(info.score, 0);
+}
+
+TEST(SearchTest, PruningSearchesFewerNodesToDepth)
+{
+    SearchLimits limits;
+    limits.depth = 6;
+    PruningOptions none = { false, false, false, false, false };
+
+    uint64_t pruned_nodes = 0, unpruned_nodes = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        for (bool pruned : { true, false })
+        {
+            Chessboard board = board_from_fen(PERFT_POSITIONS[i].fen);
+            TranspositionTable tt(1);
+            Searcher searcher(&tt);
+            if (!pruned) searcher.set_pruning(none);
+            SearchInfo info = searcher.search(&board, limits);
+            ASSERT_EQ(info.depth, 6);
+            (pruned ? pruned_nodes : unpruned_nodes) += info.nodes;
+        }
+    }
+    ASSERT_LT(pruned_nodes * 4, unpruned_nodes);
+}
+
+TEST(SearchTest, FindsMateWithEachPruningOptionOff)
+{
+    vector<PruningOptions> configurations(5);
+    configurations[0].null_move = false;
+    configurations[1].late_move_reductions = false;
+    configurations[2].futility = false;
+    configurations[3].reverse_futility = false;
+    configurations[4].check_extensions = false;
+
+    for (const PruningOptions& options : configurations)
+    {
+        Chessboard board = board_from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+        SearchLimits limits;
+        limits.depth = 4;
+
+        Searcher searcher;
+        searcher.set_pruning(options);
+        SearchInfo info = searcher.search(&board, limits);
+        ASSERT_EQ(info.best_move(), Move(square_index(0, 0), square_index(7, 0)));
+        ASSERT_EQ(info.score, MATE_SCORE - 1);
+    }
+}
+
+TEST(SearchTest, NullMoveVerificationFindsZugzwang)
+{
+    // after 1. Ra6 every black move loses: bxa6 allows b7 mate, and any bishop move allows Rxa7 mate.
+    // Passing would be safe, so null move pruning alone would miss it.
+    Chessboard board = board_from_fen("kbK5/pp6/1P6/8/8/8/8/R7 w - - 0 1");
+    SearchLimits limits;
+    limits.depth = 9;
+
+    TranspositionTable tt(1);
+    Searcher searcher(&tt);
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_EQ(info.best_move(), Move(square_index(0, 0), square_index(5, 0)));
+    ASSERT_EQ(info.score, MATE_SCORE - 3);
+}
+
+TEST(ParallelSearchTest, HelpersShareTableAndStop)
+{
+    Chessboard board = board_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    Key key = board.key;
+    SearchLimits limits;
+    limits.depth = 4;
+
+    TranspositionTable tt(16);
+    ParallelSearcher searcher(&tt, 4);
+    ASSERT_EQ(searcher.thread_count(), 4);
+
+    vector<int> depths;
+    SearchInfo info = searcher.search(&board, limits, [&](const SearchInfo& iteration) { depths.push_back(iteration.depth); });
+    ASSERT_EQ(info.depth, 4);
+    ASSERT_EQ(depths, vector<int>({ 1, 2, 3, 4 }));
+    ASSERT_TRUE(get_all_legal_moves(board).contains(info.best_move()));
+    ASSERT_EQ(board.key, key);
+
+    // searching again with a time limit still returns, once the helpers have been stopped
+    limits.depth = 0;
+    limits.time_ms = 50;
+    info = searcher.search(&board, limits);
+    ASSERT_FALSE(info.pv.empty());
+    ASSERT_EQ(board.key, key);
+}
+
+TEST(ParallelSearchTest, FindsSameMateAsSingleThread)
+{
+    Chessboard board = board_from_fen("6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    SearchLimits limits;
+    limits.depth = 4;
+
+    TranspositionTable tt(1);
+    ParallelSearcher searcher(&tt, 3);
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_EQ(info.best_move(), Move(square_index(0, 0), square_index(7, 0)));
+    ASSERT_EQ(info.score, MATE_SCORE - 1);
+}
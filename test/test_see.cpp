@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include "logic.hpp"
+#include "movegen.hpp"
+#include "see.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+// Each line of the suite is an EPD record: the first four FEN fields, then operations giving the move,
+// its expected exchange value and a description of the position.
+TEST(SeeTest, MatchesHandBuiltSuite)
+{
+    ifstream suite("positions/see_suite.epd");
+    ASSERT_TRUE(suite.is_open());
+
+    string line;
+    int positions_checked = 0;
+    while (getline(suite, line))
+    {
+        if (line.empty()) continue;
+        stringstream fields(line);
+        string placement, side, castling, ep, op, move_text, see_op, see_text;
+        fields >> placement >> side >> castling >> ep >> op >> move_text >> see_op >> see_text;
+        ASSERT_EQ(op, "move") << line;
+        ASSERT_EQ(see_op, "see") << line;
+        move_text.pop_back();
+
+        Chessboard board("positions/test_blank.txt");
+        ASSERT_TRUE(board.load_fen(placement + " " + side + " " + castling + " " + ep + " 0 1")) << line;
+
+        MoveList moves = get_all_legal_moves(board);
+        const Move* move = find_if(moves.begin(), moves.end(), [&](Move m) { return m.to_long_algebraic() == move_text; });
+        ASSERT_NE(move, moves.end()) << line;
+        ASSERT_EQ(see(board, *move), stoi(see_text)) << line;
+        positions_checked++;
+    }
+    ASSERT_EQ(positions_checked, 15);
+}
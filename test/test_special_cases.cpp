@@ -10,22 +10,16 @@ namespace fs = std::filesystem;
 
 TEST(PromotionTest, AssertPromotionIsHandledCorrectly) {
 	Chessboard test_board("positions/test_promotion.txt");
-	get_valid_and_attacking_moves(&test_board);
 
 	// Redirect cout to stringstream buffer
 	streambuf* sbuf = std::cout.rdbuf();
 	stringstream cout_buffer;
 	cout.rdbuf(cout_buffer.rdbuf());
 
-	// Simulate user input for promoting to a queen
-	string input = "Queen\nexit\n";
-	istringstream iss(input);
-	cin.rdbuf(iss.rdbuf());
-
-	make_move(&test_board, 
-			  test_board.find_valid_moves(test_board.board[6][6]),
-			  { 6, 6 },
-			  { 7, 6 });
+	// The move already carries the piece the player chose to promote to
+	Move move = build_move(test_board, { 6, 6 }, { 7, 6 }, Piece::QUEEN);
+	ASSERT_TRUE(test_board.find_valid_moves(test_board.board[6][6]).contains(Move(move.from(), move.to(), MoveFlag::PROMOTION)));
+	make_move(&test_board, move);
 
 	ASSERT_EQ(test_board.board[6][6].piece, Piece::EMPTY);
 	ASSERT_EQ(test_board.board[7][6].piece, Piece::QUEEN);
@@ -37,18 +31,14 @@ TEST(PromotionTest, AssertPromotionIsHandledCorrectly) {
 
 TEST(CastlingTest, AssertLongCastlingIsHandledCorrectly) {
 	Chessboard test_board("positions/test_castling.txt");
-	test_board.active_player = Colour::BLACK;
-	get_valid_and_attacking_moves(&test_board);
+	test_board.set_active_player(Colour::BLACK);
 
 	// Redirect cout to stringstream buffer
 	streambuf* sbuf = std::cout.rdbuf();
 	stringstream cout_buffer;
 	cout.rdbuf(cout_buffer.rdbuf());
 
-	make_move(&test_board,
-		test_board.find_valid_moves(test_board.board[7][4]),
-		{ 7, 4 },
-		{ 7, 2 });
+	make_move(&test_board, build_move(test_board, { 7, 4 }, { 7, 2 }));
 
 	ASSERT_EQ(test_board.board[7][4].piece, Piece::EMPTY);
 	ASSERT_EQ(test_board.board[7][2].piece, Piece::KING);
@@ -62,18 +52,14 @@ TEST(CastlingTest, AssertLongCastlingIsHandledCorrectly) {
 
 TEST(CastlingTest, AssertShortCastlingIsHandledCorrectly) {
 	Chessboard test_board("positions/test_castling.txt");
-	test_board.active_player = Colour::BLACK;
-	get_valid_and_attacking_moves(&test_board);
+	test_board.set_active_player(Colour::BLACK);
 
 	// Redirect cout to stringstream buffer
 	streambuf* sbuf = std::cout.rdbuf();
 	stringstream cout_buffer;
 	cout.rdbuf(cout_buffer.rdbuf());
 
-	make_move(&test_board,
-		test_board.find_valid_moves(test_board.board[7][4]),
-		{ 7, 4 },
-		{ 7, 6 });
+	make_move(&test_board, build_move(test_board, { 7, 4 }, { 7, 6 }));
 
 	ASSERT_EQ(test_board.board[7][4].piece, Piece::EMPTY);
 	ASSERT_EQ(test_board.board[7][6].piece, Piece::KING);
@@ -87,8 +73,7 @@ TEST(CastlingTest, AssertShortCastlingIsHandledCorrectly) {
 
 TEST(CastlingTest, AssertCastlingThroughOrIntoCheckIsInvalid) {
 	Chessboard test_board("positions/test_castling.txt");
-	vector<Square> king_moves;
-	get_valid_and_attacking_moves(&test_board);
+	MoveList king_moves;
 
 	// The white king should have three valid moves as it cannot castle
 	king_moves = test_board.find_valid_moves(test_board.board[0][4]);
@@ -97,13 +82,10 @@ TEST(CastlingTest, AssertCastlingThroughOrIntoCheckIsInvalid) {
 
 TEST(EnPassantTest, AssertEnPassantIsHandledCorrectly) {
 	Chessboard test_board("positions/test_ep.txt");
-	vector<Square> pawn_moves;
-	//get_valid_and_attacking_moves(&test_board);
+	MoveList pawn_moves;
 
-	switch_pieces(&test_board, { 1, 6 }, { 3, 6 }); // Move white g pawn two squares forward
-	test_board.board[3][6].has_moved = true;
-	test_board.board[3][6].when_moved = vector<int>({ 1 });
-	test_board.move_no = 2;
+	test_board.do_move(build_move(test_board, { 1, 6 }, { 3, 6 })); // Move white g pawn two squares forward
+	ASSERT_EQ(test_board.ep_square, square_index(2, 6));
 
 	// Now both black pawns should be able to capture en passant
 	pawn_moves = test_board.find_valid_moves(test_board.board[3][5]);
@@ -115,13 +97,12 @@ TEST(EnPassantTest, AssertEnPassantIsHandledCorrectly) {
 
 TEST(EnPassantTest, AssertEnPassantIsNotGivenWhenOpportunityPassed) {
 	Chessboard test_board("positions/test_ep.txt");
-	vector<Square> pawn_moves;
-	//get_valid_and_attacking_moves(&test_board);
+	MoveList pawn_moves;
 
-	switch_pieces(&test_board, { 1, 6 }, { 3, 6 }); // Move white g pawn two squares forward
-	test_board.board[3][6].has_moved = true;
-	test_board.board[3][6].when_moved = vector<int>({ 1 });
-	test_board.move_no = 3;
+	test_board.do_move(build_move(test_board, { 1, 6 }, { 3, 6 })); // Move white g pawn two squares forward
+	test_board.do_move(build_move(test_board, { 6, 0 }, { 5, 0 })); // Black plays a6 instead of capturing
+	test_board.do_move(build_move(test_board, { 1, 0 }, { 2, 0 })); // White plays a3
+	ASSERT_EQ(test_board.ep_square, -1);
 
 	// Neither pawn should be able to capture en passant as the opportunity has passed
 	pawn_moves = test_board.find_valid_moves(test_board.board[3][5]);
@@ -133,15 +114,14 @@ TEST(EnPassantTest, AssertEnPassantIsNotGivenWhenOpportunityPassed) {
 
 TEST(EnPassantTest, AssertEnPassantIsNotGivenWhenTwoIndividualSquaresMoved) {
 	Chessboard test_board("positions/test_ep.txt");
-	vector<Square> pawn_moves;
-	//get_valid_and_attacking_moves(&test_board);
+	MoveList pawn_moves;
 
-	switch_pieces(&test_board, { 1, 6 }, { 3, 6 }); // Move white g pawn two squares forward
-	test_board.board[3][6].has_moved = true;
-	test_board.board[3][6].when_moved = vector<int>({ 1, 3 });
-	test_board.move_no = 4;
+	test_board.do_move(build_move(test_board, { 1, 6 }, { 2, 6 })); // Move white g pawn one square forward
+	test_board.do_move(build_move(test_board, { 6, 0 }, { 5, 0 }));
+	test_board.do_move(build_move(test_board, { 2, 6 }, { 3, 6 })); // and then another
+	ASSERT_EQ(test_board.ep_square, -1);
 
-	// Neither pawn should be able to capture en passant as the opportunity has passed
+	// Neither pawn should be able to capture en passant as the pawn did not move two squares at once
 	pawn_moves = test_board.find_valid_moves(test_board.board[3][5]);
 	ASSERT_EQ(pawn_moves.size(), 1);
 
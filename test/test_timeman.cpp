@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include "logic.hpp"
+#include "timeman.hpp"
+#include "search.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+Chessboard board_from_fen(string fen);  // from test_search.cpp
+
+const Move MOVE_A = Move(square_index(1, 4), square_index(3, 4));
+const Move MOVE_B = Move(square_index(1, 3), square_index(3, 3));
+
+TEST(TimeManagerTest, SharesTheClock)
+{
+    TimeManager time;
+    time.start(0, 0, 0, 0);
+    ASSERT_FALSE(time.limited());
+    ASSERT_FALSE(time.hard_limit_reached());
+
+    // a sixtieth of the clock, less the overhead, for 30 moves, and most of the increment on top
+    time.start(0, 60050, 0, 0);
+    ASSERT_EQ(time.soft_limit_ms(), 2000);
+    ASSERT_EQ(time.hard_limit_ms(), 10000);
+    time.start(0, 60050, 1000, 0);
+    ASSERT_EQ(time.soft_limit_ms(), 2750);
+
+    // with few moves to go the share is larger, but the hard limit never takes more than half the clock
+    time.start(0, 10050, 0, 1);
+    ASSERT_EQ(time.hard_limit_ms(), 5000);
+    ASSERT_LE(time.soft_limit_ms(), time.hard_limit_ms());
+
+    // almost out of time, there is still some to search with
+    time.start(0, 10, 0, 0);
+    ASSERT_GT(time.hard_limit_ms(), 0);
+}
+
+TEST(TimeManagerTest, FixedMoveTimeIsNeverStretched)
+{
+    TimeManager time;
+    time.start(500, 60000, 0, 0);
+    ASSERT_EQ(time.soft_limit_ms(), 500);
+    ASSERT_EQ(time.hard_limit_ms(), 500);
+
+    time.update(MOVE_A, 0);
+    time.update(MOVE_B, -200);
+    ASSERT_EQ(time.soft_limit_ms(), 500);
+}
+
+TEST(TimeManagerTest, StretchesWhileUnsure)
+{
+    TimeManager time;
+    time.start(0, 60050, 0, 0);
+    time.update(MOVE_A, 20);
+    time.update(MOVE_A, 25);
+    ASSERT_EQ(time.soft_limit_ms(), 2000);
+
+    // a new best move takes longer to settle, and is forgotten over the following iterations
+    time.update(MOVE_B, 25);
+    int64_t unstable = time.soft_limit_ms();
+    ASSERT_GT(unstable, 2000);
+    time.update(MOVE_B, 25);
+    time.update(MOVE_B, 25);
+    ASSERT_LT(time.soft_limit_ms(), unstable);
+
+    // so does a drop in the score, up to the hard limit
+    int64_t stable = time.soft_limit_ms();
+    time.update(MOVE_B, -50);
+    ASSERT_GT(time.soft_limit_ms(), stable);
+    time.update(MOVE_A, -1000);
+    ASSERT_LE(time.soft_limit_ms(), time.hard_limit_ms());
+}
+
+TEST(TimeManagerTest, SearchStaysWithinHardLimit)
+{
+    Chessboard board = board_from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    SearchLimits limits;
+    limits.clock_ms = 1000;
+
+    Searcher searcher;
+    SearchInfo info = searcher.search(&board, limits);
+    ASSERT_GT(info.depth, 1);
+    ASSERT_LT(info.seconds, 0.6);
+}
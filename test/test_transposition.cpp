@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "logic.hpp"
+#include "search.hpp"
+#include "transposition.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace std;
+
+TEST(TranspositionTableTest, SizeIsPowerOfTwoWithinLimit)
+{
+    ASSERT_EQ(TranspositionTable(1).size_mb(), 1);
+    ASSERT_EQ(TranspositionTable(3).size_mb(), 2);
+    ASSERT_EQ(TranspositionTable(16).size_mb(), 16);
+}
+
+TEST(TranspositionTableTest, StoredEntryIsFound)
+{
+    TranspositionTable tt(1);
+    Move move(square_index(6, 4), square_index(7, 4), MoveFlag::PROMOTION, Piece::KNIGHT);
+    tt.store(0x123456789ABCDEF0ULL, move, -1234, 17, Bound::LOWER);
+
+    TTEntry entry;
+    ASSERT_TRUE(tt.probe(0x123456789ABCDEF0ULL, &entry));
+    ASSERT_EQ(entry.move, move);
+    ASSERT_EQ(entry.score, -1234);
+    ASSERT_EQ(entry.depth, 17);
+    ASSERT_EQ(entry.bound, Bound::LOWER);
+
+    // a key for the same bucket with different upper bits misses
+    ASSERT_FALSE(tt.probe(0x023456789ABCDEF0ULL, &entry));
+
+    tt.clear();
+    ASSERT_FALSE(tt.probe(0x123456789ABCDEF0ULL, &entry));
+}
+
+TEST(TranspositionTableTest, RestoringKeepsMove)
+{
+    TranspositionTable tt(1);
+    Move move(square_index(1, 4), square_index(3, 4), MoveFlag::DOUBLE_PUSH);
+    tt.store(42, move, 10, 3, Bound::EXACT);
+    tt.store(42, Move(), 20, 4, Bound::UPPER);
+
+    TTEntry entry;
+    ASSERT_TRUE(tt.probe(42, &entry));
+    ASSERT_EQ(entry.move, move);
+    ASSERT_EQ(entry.score, 20);
+    ASSERT_EQ(entry.depth, 4);
+}
+
+TEST(TranspositionTableTest, ShallowestAndOldestEntriesAreReplacedFirst)
+{
+    // keys differing only in their upper bits all share a bucket of four entries
+    TranspositionTable tt(1);
+    auto key = [](uint64_t i) { return (i + 1) << 40; };
+    for (int i = 0; i < 4; i++) tt.store(key(i), Move(), 0, 10 - i, Bound::EXACT);
+
+    TTEntry entry;
+    tt.store(key(4), Move(), 0, 8, Bound::EXACT);
+    ASSERT_FALSE(tt.probe(key(3), &entry));
+    for (int i : { 0, 1, 2, 4 }) ASSERT_TRUE(tt.probe(key(i), &entry));
+
+    // after a new search begins, entries from the last one go before new entries much shallower than them
+    tt.new_search();
+    for (int i = 5; i < 9; i++) tt.store(key(i), Move(), 0, 3, Bound::EXACT);
+    for (int i : { 5, 6, 7, 8 }) ASSERT_TRUE(tt.probe(key(i), &entry));
+}
+
+TEST(TranspositionTableTest, SearchWithTableAgreesAndSearchesFewerNodes)
+{
+    SearchLimits limits;
+    limits.depth = 5;
+    // pruning decides differently with stored results to hand, so is left out to compare the table alone
+    PruningOptions no_pruning = { false, false, false, false, false };
+
+    Chessboard board("positions/starting_position.txt");
+    Searcher plain;
+    plain.set_pruning(no_pruning);
+    SearchInfo without_table = plain.search(&board, limits);
+
+    TranspositionTable tt(1);
+    Searcher with_tt(&tt);
+    with_tt.set_pruning(no_pruning);
+    SearchInfo with_table = with_tt.search(&board, limits);
+
+    ASSERT_EQ(with_table.score, without_table.score);
+    ASSERT_LT(with_table.nodes, without_table.nodes);
+    ASSERT_GT(with_table.tt_hits, 0);
+    ASSERT_LE(with_table.tt_hits, with_table.tt_probes);
+    ASSERT_GT(with_table.hashfull, 0);
+    ASSERT_EQ(without_table.tt_probes, 0);
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "logic.hpp"
+#include "uci.hpp"
+
+using namespace LogicEngine;
+using namespace SearchEngine;
+using namespace UciEngine;
+using namespace std;
+
+// Collects the lines a handler sends, which can come from its worker thread while the test reads them.
+class UciTest : public ::testing::Test
+{
+protected:
+    UciHandler handler{ [this](const string& line) { lock_guard<mutex> lock(lines_mutex); lines.push_back(line); } };
+
+    vector<string> sent()
+    {
+        lock_guard<mutex> lock(lines_mutex);
+        return lines;
+    }
+
+    // The last line sent starting with the prefix, or "" if there is none.
+    string last_line(const string& prefix)
+    {
+        vector<string> copy = sent();
+        for (auto it = copy.rbegin(); it != copy.rend(); it++)
+        {
+            if (it->rfind(prefix, 0) == 0) return *it;
+        }
+        return "";
+    }
+
+    bool wait_for_line(const string& prefix, int timeout_ms)
+    {
+        auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+        while (chrono::steady_clock::now() < deadline)
+        {
+            if (!last_line(prefix).empty()) return true;
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    mutex lines_mutex;
+    vector<string> lines;
+};
+
+TEST_F(UciTest, IntroducesItselfAndItsOptions)
+{
+    ASSERT_TRUE(handler.handle_command("uci"));
+    ASSERT_EQ(last_line("id name"), "id name chess3d");
+    ASSERT_FALSE(last_line("option name Hash").empty());
+    ASSERT_FALSE(last_line("option name EvalFile").empty());
+    ASSERT_FALSE(last_line("option name NullMove type check").empty());
+    ASSERT_EQ(sent().back(), "uciok");
+
+    ASSERT_TRUE(handler.handle_command("isready"));
+    ASSERT_EQ(sent().back(), "readyok");
+    ASSERT_FALSE(handler.handle_command("quit"));
+}
+
+TEST_F(UciTest, PositionPlaysMoves)
+{
+    handler.handle_command("position startpos moves e2e4 e7e5 g1f3");
+    Chessboard expected("positions/test_blank.txt");
+    ASSERT_TRUE(expected.load_fen("rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2"));
+    ASSERT_EQ(handler.get_board().key, expected.key);
+
+    // promotions carry the piece promoted to
+    handler.handle_command("position fen 8/4P3/8/8/8/8/k7/4K3 w - - 0 1 moves e7e8n");
+    ASSERT_EQ(handler.get_board().board[7][4].piece, Piece::KNIGHT);
+
+    // an illegal move is reported, and the moves before it are kept
+    handler.handle_command("position startpos moves e2e4 e2e4");
+    ASSERT_EQ(last_line("info string"), "info string illegal move: e2e4");
+    ASSERT_EQ(handler.get_board().active_player, Colour::BLACK);
+}
+
+TEST_F(UciTest, GoReportsIterationsAndBestMove)
+{
+    handler.handle_command("position fen 6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    handler.handle_command("go depth 4");
+    handler.wait_for_search();
+
+    ASSERT_EQ(last_line("bestmove"), "bestmove a1a8");
+    ASSERT_NE(last_line("info depth").find("score mate 1"), string::npos);
+    ASSERT_EQ(sent().back(), "bestmove a1a8");
+}
+
+TEST_F(UciTest, StopEndsInfiniteSearch)
+{
+    // the mate is found in the first iteration, which ends the search, but the best move is held back until stop
+    handler.handle_command("position fen 6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+    handler.handle_command("go infinite");
+    ASSERT_TRUE(wait_for_line("info depth 1", 10000));
+    ASSERT_EQ(last_line("bestmove"), "");
+    handler.handle_command("stop");
+    ASSERT_EQ(last_line("bestmove"), "bestmove a1a8");
+
+    // a search that is still running stops, and the handler is ready for more
+    handler.handle_command("position startpos");
+    handler.handle_command("go infinite");
+    ASSERT_TRUE(wait_for_line("info depth 3", 10000));
+    handler.handle_command("stop");
+    Move move;
+    ASSERT_TRUE(parse_uci_move(handler.get_board(), last_line("bestmove").substr(9, 4), &move));
+    ASSERT_TRUE(handler.handle_command("isready"));
+    ASSERT_EQ(sent().back(), "readyok");
+}
+
+TEST_F(UciTest, StopAtAnyPointGivesLegalMove)
+{
+    // stopping straight after go lands before the search starts or in its first iteration, which still has to give a legal move
+    const string kiwipete = "position fen r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+    int searches = 0;
+    for (const char* threads : { "1", "4" })
+    {
+        handler.handle_command(string("setoption name Threads value ") + threads);
+        for (int i = 0; i < 30; i++)
+        {
+            for (const char* go : { "go infinite", "go depth 30", "go ponder" })
+            {
+                handler.handle_command(kiwipete);
+                handler.handle_command(go);
+                handler.handle_command("stop");
+                searches++;
+
+                string bestmove = last_line("bestmove");
+                Move move;
+                ASSERT_GE(bestmove.size(), 13u) << go;
+                ASSERT_TRUE(parse_uci_move(handler.get_board(), bestmove.substr(9, 4), &move)) << go << ": " << bestmove;
+            }
+        }
+    }
+
+    // every search sent exactly one best move
+    vector<string> lines = sent();
+    ASSERT_EQ(count_if(lines.begin(), lines.end(), [](const string& line) { return line.rfind("bestmove", 0) == 0; }), searches);
+}
+
+TEST_F(UciTest, PonderhitStartsTheClock)
+{
+    // while pondering there is no time limit, so the search carries on until ponderhit
+    handler.handle_command("position startpos");
+    handler.handle_command("go ponder movetime 100");
+    ASSERT_TRUE(wait_for_line("info depth 2", 10000));
+    ASSERT_EQ(last_line("bestmove"), "");
+
+    handler.handle_command("ponderhit");
+    ASSERT_TRUE(wait_for_line("bestmove", 10000));
+}
+
+TEST_F(UciTest, SeesRepetitionsOfTheGame)
+{
+    // Black is lost, but Kg8 repeats the position after White's first move, so it draws
+    handler.handle_command("position fen 6k1/8/8/8/8/8/2Q5/K7 w - - 0 1 moves a1b1 g8h8 b1a1");
+    handler.handle_command("go depth 4");
+    handler.wait_for_search();
+    ASSERT_EQ(last_line("bestmove"), "bestmove h8g8");
+    ASSERT_NE(last_line("info depth 4").find("score cp 0 "), string::npos);
+}
+
+TEST_F(UciTest, PlaysOnTheClock)
+{
+    // black is to move, so only black's clock counts
+    handler.handle_command("position startpos moves e2e4");
+    auto start = chrono::steady_clock::now();
+    handler.handle_command("go wtime 1 btime 2000 winc 0 binc 0");
+    handler.wait_for_search();
+    ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(1000));
+    ASSERT_FALSE(last_line("bestmove").empty());
+    ASSERT_NE(last_line("info depth"), "");
+}
+
+TEST_F(UciTest, SetsOptions)
+{
+    handler.handle_command("setoption name Hash value 4");
+    handler.handle_command("setoption name Threads value 2");
+    handler.handle_command("setoption name NullMove value false");
+    handler.handle_command("setoption name Clear Hash");
+    ASSERT_EQ(last_line("info string"), "");
+
+    handler.handle_command("setoption name EvalFile value no_such_file.nnue");
+    ASSERT_EQ(last_line("info string"), "info string could not load network: no_such_file.nnue");
+    handler.handle_command("setoption name Nonsense value 1");
+    ASSERT_EQ(last_line("info string"), "info string unknown option: Nonsense");
+
+    handler.handle_command("position startpos");
+    handler.handle_command("go nodes 20000");
+    handler.wait_for_search();
+    ASSERT_FALSE(last_line("bestmove").empty());
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <set>
+#include "logic.hpp"
+
+using namespace LogicEngine;
+using namespace std;
+
+TEST(ZobristKeysTest, KeysAreDistinct)
+{
+    set<Key> keys;
+    for (int c = 0; c < 2; c++)
+        for (int p = 0; p < 6; p++)
+            for (int sq = 0; sq < NUM_SQUARES; sq++)
+                keys.insert(ZOBRIST.pieces[c][p][sq]);
+    for (int i = 0; i < 16; i++) keys.insert(ZOBRIST.castling[i]);
+    for (int i = 0; i < 8; i++) keys.insert(ZOBRIST.ep_file[i]);
+    keys.insert(ZOBRIST.side);
+
+    ASSERT_EQ(keys.size(), (2 * 6 * 64) + 16 + 8 + 1);
+    ASSERT_EQ(keys.count(0), 0);
+}
+
+TEST(ZobristKeysTest, IncrementalKeyMatchesScratchKey)
+{
+    Chessboard test_board("positions/starting_position.txt");
+    Key start_key = test_board.key;
+    ASSERT_EQ(test_board.key, test_board.compute_key());
+
+    // 1.e4 sets an en passant file, and 1...Nf6 clears it again
+    vector<UndoInfo> undos;
+    undos.push_back(test_board.do_move(build_move(test_board, { 1, 4 }, { 3, 4 })));
+    ASSERT_EQ(test_board.key, test_board.compute_key());
+    undos.push_back(test_board.do_move(build_move(test_board, { 7, 6 }, { 5, 5 })));
+    ASSERT_EQ(test_board.key, test_board.compute_key());
+
+    // 2.Ke2 loses white's castling rights
+    undos.push_back(test_board.do_move(build_move(test_board, { 0, 4 }, { 1, 4 })));
+    ASSERT_EQ(test_board.castling_rights, BLACK_OO | BLACK_OOO);
+    ASSERT_EQ(test_board.key, test_board.compute_key());
+
+    while (!undos.empty())
+    {
+        test_board.undo_move(undos.back());
+        undos.pop_back();
+        ASSERT_EQ(test_board.key, test_board.compute_key());
+    }
+    ASSERT_EQ(test_board.key, start_key);
+}
+
+TEST(ZobristKeysTest, TranspositionsShareAKey)
+{
+    // 1.Nf3 Nf6 2.Ng1 Ng8 returns to the starting position, so has the starting key
+    Chessboard test_board("positions/starting_position.txt");
+    Key start_key = test_board.key;
+
+    test_board.do_move(build_move(test_board, { 0, 6 }, { 2, 5 }));
+    test_board.do_move(build_move(test_board, { 7, 6 }, { 5, 5 }));
+    Key after_knights_out = test_board.key;
+    test_board.do_move(build_move(test_board, { 2, 5 }, { 0, 6 }));
+    ASSERT_NE(test_board.key, start_key);
+    test_board.do_move(build_move(test_board, { 5, 5 }, { 7, 6 }));
+    ASSERT_EQ(test_board.key, start_key);
+
+    // The same pieces with the other side to move are a different position
+    test_board.set_active_player(Colour::BLACK);
+    ASSERT_NE(test_board.key, start_key);
+    ASSERT_EQ(test_board.key, test_board.compute_key());
+
+    // 1.Nc3 Nf6 2.Nb1 Nc6 3.Nf3 Nb8 reaches the position after 1.Nf3 Nf6 by another move order
+    Chessboard other_board("positions/starting_position.txt");
+    other_board.do_move(build_move(other_board, { 0, 1 }, { 2, 2 }));
+    other_board.do_move(build_move(other_board, { 7, 6 }, { 5, 5 }));
+    other_board.do_move(build_move(other_board, { 2, 2 }, { 0, 1 }));
+    other_board.do_move(build_move(other_board, { 7, 1 }, { 5, 2 }));
+    other_board.do_move(build_move(other_board, { 0, 6 }, { 2, 5 }));
+    other_board.do_move(build_move(other_board, { 5, 2 }, { 7, 1 }));
+    ASSERT_EQ(other_board.key, after_knights_out);
+}